@@ -0,0 +1,49 @@
+#ifndef ASSETPACK_HPP
+#define ASSETPACK_HPP
+
+#include <span>
+
+#include <utils.hpp>
+#include <mappedfile.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Single file holding every asset of the resource directory:
+//
+//  [ header ][ table of contents, sorted by path ][ paths ][ page aligned blobs... ]
+//
+// The whole pack is mapped once, lookups binary search the mapped table of contents
+// and hand out views of the blobs so that no asset is ever copied out of the mapping.
+// Each entry keeps the stamp of the file it was packed from, the caches compiled from
+// that file are still valid when they are packed along with it.
+class AssetPack
+{
+public:
+    AssetPack() = default;
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack(AssetPack&&) = default;
+
+    AssetPack& operator=(const AssetPack&) = delete;
+    AssetPack& operator=(AssetPack&&) = default;
+
+    bool Open(const std::string& packFile);
+    void Close();
+
+    inline bool IsOpen() const { return m_Mapping.IsOpen(); }
+    inline std::size_t GetEntryCount() const { return m_EntryCount; }
+
+    // Paths are relative to the packed directory and use '/' separators
+    bool Find(std::string_view path, std::span<const uint8_t>& data, FileStamp& stamp) const;
+
+private:
+    MappedFile m_Mapping;
+    std::size_t m_EntryCount = 0;
+};
+
+// Packs every file found under resourceDirectory, except the pack itself and the temporary files
+bool BuildAssetPack(const std::string& resourceDirectory, const std::string& packFile);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !ASSETPACK_HPP
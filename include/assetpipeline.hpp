@@ -0,0 +1,78 @@
+#ifndef ASSETPIPELINE_HPP
+#define ASSETPIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <threadpool.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Dependency graph of asset loading tasks (read -> parse -> post-process -> upload).
+// Worker tasks run on the thread pool as soon as their dependencies are done, main thread
+// tasks (the OpenGL uploads) are queued until the main thread consumes them, so that an
+// asset is uploaded while the slower ones are still being decoded.
+class AssetPipeline
+{
+public:
+    using TaskID = uint32_t;
+
+    enum class Queue
+    {
+        Worker,
+        Main
+    };
+
+    explicit AssetPipeline(ThreadPool& threadPool);
+
+    AssetPipeline(const AssetPipeline&) = delete;
+    AssetPipeline(AssetPipeline&&) = delete;
+
+    AssetPipeline& operator=(const AssetPipeline&) = delete;
+    AssetPipeline& operator=(AssetPipeline&&) = delete;
+
+    // Tasks must all be added before Start
+    TaskID AddTask(const std::string& name, Queue queue, std::function<void()> work, std::initializer_list<TaskID> dependencies = {});
+
+    void Start();
+
+    // Main thread only: runs the ready main thread tasks, waiting for one if none is ready and wait is set.
+    // Returns the number of tasks run.
+    uint32_t ProcessMainThreadTasks(bool wait);
+
+    // Main thread only: processes the main thread tasks until the whole graph is done
+    void Finish();
+
+    bool IsComplete() const;
+
+    // Tasks that did not start yet are skipped, the graph still completes so that the pool can be drained
+    void Cancel();
+
+private:
+    struct Task
+    {
+        std::string name;
+        Queue queue;
+        std::function<void()> work;
+        std::vector<TaskID> dependents;
+        uint32_t remainingDependencies = 0;
+    };
+
+    void Schedule(TaskID id);
+    void Run(TaskID id);
+
+    ThreadPool& m_ThreadPool;
+    std::vector<Task> m_Tasks;
+    std::deque<TaskID> m_MainThreadTasks;
+    uint32_t m_CompletedTaskCount = 0;
+    bool m_Started = false;
+    std::atomic<bool> m_Cancelled = false;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+
+    std::chrono::time_point<std::chrono::steady_clock> m_StartTime;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !ASSETPIPELINE_HPP
@@ -0,0 +1,43 @@
+#ifndef ASSETPREFETCH_HPP
+#define ASSETPREFETCH_HPP
+
+#include <virtualfilesystem.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+class ThreadPool;
+
+// Batch of asset reads issued at once, ahead of the loaders.
+// Every asset of the batch is mapped and all of their pages are requested from the disk in a single
+// PrefetchVirtualMemory call, which lets the system issue large concurrent reads rather than the
+// small page faults the loaders would otherwise take one after the other. The loaders then find the
+// pages in the file cache, or wait on the read already in flight. Where PrefetchVirtualMemory is not
+// available the pages are touched on the thread pool instead.
+class AssetPrefetch
+{
+public:
+    AssetPrefetch() = default;
+
+    AssetPrefetch(const AssetPrefetch&) = delete;
+    AssetPrefetch(AssetPrefetch&&) = default;
+
+    AssetPrefetch& operator=(const AssetPrefetch&) = delete;
+    AssetPrefetch& operator=(AssetPrefetch&&) = default;
+
+    // Missing assets are skipped
+    bool Add(const std::string& path);
+    // Returns without waiting for the reads, the batch must outlive the tasks given to threadPool
+    void Submit(ThreadPool& threadPool);
+    void Release();
+
+    inline std::size_t GetAssetCount() const { return m_Files.size(); }
+    inline std::size_t GetSize() const { return m_Size; }
+
+private:
+    std::vector<AssetFile> m_Files;
+    std::size_t m_Size = 0;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !ASSETPREFETCH_HPP
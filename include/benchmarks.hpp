@@ -0,0 +1,13 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Command line benchmarks, they run without any window or OpenGL context.
+
+void RunObjParserBenchmark(const std::string& inputFile);
+void RunMeshOptimizationReport(const std::string& inputFile);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !BENCHMARKS_HPP
@@ -0,0 +1,73 @@
+#ifndef CUBEMAP_HPP
+#define CUBEMAP_HPP
+
+#include <glm/glm.hpp>
+
+#include <utils.hpp>
+#include <virtualfilesystem.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Six faces of a cube map sharing a single pixel buffer.
+// The buffer is either a decoded horizontal cross image, the faces being sub-rectangles of it:
+//
+//          [ Up  ]
+//  [ Left ][Front][Right][Back]
+//          [Down ]
+//
+// or a raw face cache where the faces are stored one after the other.
+// Faces are uploaded straight from that buffer with the unpack row length and skip offsets.
+class CubemapImage
+{
+public:
+    // Same order as GL_TEXTURE_CUBE_MAP_POSITIVE_X + i
+    enum Face
+    {
+        Right = 0,
+        Left,
+        Up,
+        Down,
+        Front,
+        Back,
+        FaceCount
+    };
+
+    CubemapImage() = default;
+    ~CubemapImage();
+
+    CubemapImage(const CubemapImage&) = delete;
+    CubemapImage(CubemapImage&& other) noexcept;
+
+    CubemapImage& operator=(const CubemapImage&) = delete;
+    CubemapImage& operator=(CubemapImage&& other) noexcept;
+
+    // Takes ownership of pixels which must have been allocated by stb_image
+    static bool FromCross(unsigned char* pixels, int width, int height, int channels, CubemapImage& image);
+
+    static bool LoadCache(const std::string& cacheFile, const FileStamp& sourceStamp, CubemapImage& image);
+    bool WriteCache(const std::string& cacheFile, const FileStamp& sourceStamp) const;
+
+    // Uploads the six faces in the currently bound GL_TEXTURE_CUBE_MAP
+    void Upload() const;
+
+    inline bool IsValid() const { return m_Data != nullptr; }
+    inline int GetFaceSize() const { return m_FaceSize; }
+
+private:
+    void Release();
+
+    unsigned char* m_DecodedPixels = nullptr;
+    AssetFile m_Mapping;
+
+    const uint8_t* m_Data = nullptr;
+    int m_RowLength = 0;
+    int m_FaceSize = 0;
+    int m_Channels = 0;
+    std::array<glm::ivec2, FaceCount> m_FaceOffsets = {};
+};
+
+std::string GetCubemapCachePath(const std::string& sourceFile);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !CUBEMAP_HPP
@@ -0,0 +1,81 @@
+#ifndef GEOMETRYARENA_HPP
+#define GEOMETRYARENA_HPP
+
+#include <vertexformat.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Command of the indirect draws, laid out as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+// Static geometry of every mesh in a single vertex buffer and a single index buffer.
+// All the vertices share one layout and all the indices are 16 bit, relative to the base vertex of their range,
+// so that one vertex array and one multi-draw call cover every mesh. The buffers are allocated once with a fixed
+// capacity: meshes are sub-allocated one after the other and never released, they are static for the whole run.
+// Both buffers accept glNamedBufferSubData uploads and, once mapped, writes from any thread through GetMappedVertices
+// and GetMappedIndices, the written ranges being flushed explicitly.
+class GeometryArena
+{
+public:
+    GeometryArena() = default;
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena(GeometryArena&&) = delete;
+
+    GeometryArena& operator=(const GeometryArena&) = delete;
+    GeometryArena& operator=(GeometryArena&&) = delete;
+
+    // Allocation of a mesh, in vertices and indices from the start of the buffers
+    struct Allocation
+    {
+        uint32_t baseVertex = 0;
+        uint32_t firstIndex = 0;
+    };
+
+    void Create(const VertexLayout& layout, uint32_t vertexCapacity, uint32_t indexCapacity);
+    void Destroy();
+
+    // False when the arena is full, the allocation is left untouched then
+    bool Allocate(uint32_t vertexCount, uint32_t indexCount, Allocation& allocation);
+
+    // Maps both buffers for the rest of the streaming, Unmap is only needed before the arena is destroyed
+    bool Map();
+    void Unmap();
+    void FlushVertices(uint32_t firstVertex, uint32_t vertexCount);
+    void FlushIndices(uint32_t firstIndex, uint32_t indexCount);
+
+    inline std::byte* GetMappedVertices(uint32_t firstVertex) const { return m_MappedVertices ? m_MappedVertices + std::size_t(firstVertex) * m_Layout.stride : nullptr; }
+    inline uint16_t* GetMappedIndices(uint32_t firstIndex) const { return m_MappedIndices ? m_MappedIndices + firstIndex : nullptr; }
+
+    inline GLuint GetVertexBuffer() const { return m_VertexBuffer; }
+    inline GLuint GetIndexBuffer() const { return m_IndexBuffer; }
+    inline const VertexLayout& GetLayout() const { return m_Layout; }
+    inline uint32_t GetVertexCount() const { return m_VertexCount; }
+    inline uint32_t GetIndexCount() const { return m_IndexCount; }
+
+private:
+    GLuint m_VertexBuffer = 0;
+    GLuint m_IndexBuffer = 0;
+    VertexLayout m_Layout;
+    uint32_t m_VertexCapacity = 0;
+    uint32_t m_IndexCapacity = 0;
+    uint32_t m_VertexCount = 0;
+    uint32_t m_IndexCount = 0;
+
+    std::byte* m_MappedVertices = nullptr;
+    uint16_t* m_MappedIndices = nullptr;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !GEOMETRYARENA_HPP
@@ -0,0 +1,137 @@
+#ifndef GPUCULLING_HPP
+#define GPUCULLING_HPP
+
+#include <glm/glm.hpp>
+
+#include <mesh.hpp>
+#include <instancefile.hpp>
+#include <geometryarena.hpp>
+#include <shaderprogram.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// What the culling pass draws, rebuilt whenever a mesh becomes resident:
+//  - the terrain as commands of its tiles split along their index ranges, each one with the bounds of its tile
+//  - the palms as commands of the index ranges of every level of detail of every variant, the draw of a command being variant * lodsPerVariant + lod
+// The commands are those of the geometry arena, their instance count and base instance are left to the pass.
+struct GpuCullingScene
+{
+    std::vector<DrawElementsIndirectCommand> tileCommands;
+    std::vector<MeshBounds> tileBounds;
+    // Instance the terrain commands read, the first of the culled instances
+    PackedInstance terrainInstance = {};
+
+    // Every palm instance, their species byte holding the variant they draw
+    std::vector<PackedInstance> instances;
+    std::vector<DrawElementsIndirectCommand> palmCommands;
+    std::vector<uint32_t> palmCommandDraws;
+    // Error of every draw, see MeshLod
+    std::vector<float> lodErrors;
+    uint32_t lodsPerVariant = 1;
+    // Bounding sphere of the palm mesh and its colour, which multiplies the tints of the instances drawn as meshes
+    glm::vec3 palmCenter = glm::vec3(0.0f);
+    float palmRadius = 0.0f;
+    glm::vec3 palmColor = glm::vec3(1.0f);
+    // Position decoding of the default shader the palms drawn as meshes select, written over their variant, see PackedInstance
+    uint32_t palmPositionDecode = 0;
+};
+
+struct GpuCullingParameters
+{
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    // Pixels covered on screen by one unit at a distance of one
+    float pixelsPerUnit = 1.0f;
+    // Same as RendererSettings::lodThreshold and impostorDistance, the impostor distance being 0 until the impostor is ready
+    float lodThreshold = 0.0f;
+    float lodHysteresis = 0.0f;
+    float impostorDistance = 0.0f;
+};
+
+// Frustum culling and level of detail selection of the terrain tiles and palm instances on the GPU.
+// Every frame three compute dispatches read the view from the Matrix uniform block and:
+//  1. cull every palm instance against the frustum and select its level of detail, the hysteresis being kept in a buffer from frame to frame,
+//     the instance counting itself in the draw it ends up in with an atomic add, the impostors being one more draw
+//  2. set the instance count of every terrain command to 0 or 1 and the instance count and base instance of every palm command from the counts,
+//     followed by the DrawArraysIndirectCommand of the impostors
+//  3. scatter the surviving instances to their slot in the culled instances, sorted by draw
+// The CPU never reads nor writes per instance data once the scene is set, the commands are consumed by a single multi-draw.
+class GpuCulling
+{
+public:
+    GpuCulling() = default;
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling(GpuCulling&&) = delete;
+
+    GpuCulling& operator=(const GpuCulling&) = delete;
+    GpuCulling& operator=(GpuCulling&&) = delete;
+
+    // Source of the compute shader the pass runs
+    static const char* GetShaderSource();
+
+    // Takes ownership of the linked culling program, false when it failed to link
+    bool Create(GLuint program);
+    void Destroy();
+
+    // Requires a program, see Create
+    void SetScene(const GpuCullingScene& scene);
+    // Expects the Matrix uniform block at binding 0, leaves no program in use
+    void Dispatch(const GpuCullingParameters& parameters);
+
+    inline bool HasTerrain() const { return m_TileCommandCount > 0; }
+    inline bool HasPalms() const { return m_InstanceCount > 0; }
+
+    // Indirect buffer holding the terrain and palm commands then the impostor command
+    inline GLuint GetCommandBuffer() const { return m_Buffers[CommandBuffer]; }
+    // Culled instances the commands refer to, in the PackedInstance layout
+    inline GLuint GetInstanceBuffer() const { return m_Buffers[CulledInstanceBuffer]; }
+    inline uint32_t GetDrawCommandCount() const { return m_TileCommandCount + m_PalmCommandCount; }
+    inline std::size_t GetImpostorCommandOffset() const { return GetDrawCommandCount() * sizeof(DrawElementsIndirectCommand); }
+
+private:
+    // Shader storage bindings of the culling shader, within the 8 a compute shader is guaranteed
+    enum Buffer : uint32_t
+    {
+        InstanceBuffer,
+        InstanceStateBuffer,
+        DrawCountBuffer,
+        LodErrorBuffer,
+        CommandDrawBuffer,
+        TileBoundsBuffer,
+        CommandBuffer,
+        CulledInstanceBuffer,
+        BufferCount
+    };
+
+    ShaderProgram m_Program;
+    struct Uniforms
+    {
+        ShaderProgram::Uniform<uint32_t> cullPass;
+        ShaderProgram::Uniform<uint32_t> instanceCount;
+        ShaderProgram::Uniform<uint32_t> tileCommandCount;
+        ShaderProgram::Uniform<uint32_t> palmCommandCount;
+        ShaderProgram::Uniform<uint32_t> drawCount;
+        ShaderProgram::Uniform<uint32_t> lodsPerVariant;
+        ShaderProgram::Uniform<glm::vec3> cameraPosition;
+        ShaderProgram::Uniform<glm::vec3> palmCenter;
+        ShaderProgram::Uniform<float> palmRadius;
+        ShaderProgram::Uniform<glm::vec3> palmColor;
+        ShaderProgram::Uniform<uint32_t> palmPositionDecode;
+        ShaderProgram::Uniform<float> pixelsPerUnit;
+        ShaderProgram::Uniform<float> lodThreshold;
+        ShaderProgram::Uniform<float> lodHysteresis;
+        ShaderProgram::Uniform<float> impostorDistance;
+    } m_Uniforms;
+    GLuint m_Buffers[BufferCount] = {};
+
+    uint32_t m_TileCommandCount = 0;
+    uint32_t m_PalmCommandCount = 0;
+    uint32_t m_InstanceCount = 0;
+    // Draws of the palm meshes, the impostors being the next one
+    uint32_t m_DrawCount = 0;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !GPUCULLING_HPP
@@ -0,0 +1,82 @@
+#ifndef IMPOSTOR_HPP
+#define IMPOSTOR_HPP
+
+#include <glm/glm.hpp>
+
+#include <utils.hpp>
+#include <virtualfilesystem.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Octahedral impostor of a mesh: the mesh rendered offscreen from framesPerSide * framesPerSide view directions
+// spread over the upper hemisphere (hemi-octahedral mapping), every view in its own frame of a colour and a depth atlas.
+// A far instance is drawn as a single quad showing the frame of the baked direction closest to the camera,
+// the depth atlas giving back the depth of every pixel so that impostors intersect the scene like the mesh would.
+//
+//  atlas coordinates (u, v) in [0, 1]²  ->  e = 2 * (u, v) - 1  ->  direction (e.x + e.y, 2 - |e.x + e.y| - |e.x - e.y|, e.x - e.y) normalized
+//
+// Every frame is an orthographic view of the bounding sphere of the mesh, its depth going from 0 on the side
+// of the sphere facing the viewer to 1 on the opposite side. A mesh made of several variants gets an atlas per variant,
+// the layers of array textures sharing the bounding sphere of the whole mesh.
+struct ImpostorSettings
+{
+    // Frames along each side of the atlas
+    uint32_t framesPerSide = 8;
+    // Pixels along each side of a frame
+    uint32_t frameSize = 128;
+
+    inline uint32_t GetAtlasSize() const { return framesPerSide * frameSize; }
+};
+
+// Colour (RGBA8, alpha being the coverage) and depth (16 bit) atlases of an impostor, a layer per variant, either read back
+// from the GPU right after baking or mapped from the impostor cache.
+class ImpostorAtlas
+{
+public:
+    ImpostorAtlas() = default;
+
+    ImpostorAtlas(const ImpostorAtlas&) = delete;
+    ImpostorAtlas(ImpostorAtlas&&) = default;
+
+    ImpostorAtlas& operator=(const ImpostorAtlas&) = delete;
+    ImpostorAtlas& operator=(ImpostorAtlas&&) = default;
+
+    // Creates the immutable storage of both array textures, the colour one with a few mipmaps that never mix two frames
+    static void AllocateTextures(GLuint colorTexture, GLuint depthTexture, const ImpostorSettings& settings, uint32_t layerCount);
+    // Reads back the textures an impostor of the given bounding sphere was just baked into
+    static ImpostorAtlas FromTextures(GLuint colorTexture, GLuint depthTexture, const ImpostorSettings& settings, uint32_t layerCount, const glm::vec3& center, float radius);
+
+    // The cache is only valid for the source stamp and the hash of the settings the impostor was baked with
+    static bool LoadCache(const std::string& cacheFile, const FileStamp& sourceStamp, uint64_t settingsHash, const ImpostorSettings& settings, ImpostorAtlas& atlas);
+    bool WriteCache(const std::string& cacheFile, const FileStamp& sourceStamp, uint64_t settingsHash) const;
+
+    // Allocates both textures and uploads the atlas into them
+    void Upload(GLuint colorTexture, GLuint depthTexture) const;
+
+    inline bool IsValid() const { return m_Color != nullptr; }
+    inline const glm::vec3& GetCenter() const { return m_Center; }
+    inline float GetRadius() const { return m_Radius; }
+    inline uint32_t GetLayerCount() const { return m_LayerCount; }
+
+private:
+    std::vector<uint8_t> m_Pixels;
+    AssetFile m_Mapping;
+
+    const uint8_t* m_Color = nullptr;
+    const uint16_t* m_Depth = nullptr;
+    ImpostorSettings m_Settings;
+    uint32_t m_LayerCount = 1;
+    glm::vec3 m_Center = glm::vec3(0.0f);
+    float m_Radius = 0.0f;
+};
+
+// View direction of the frame at the given atlas coordinates, the impostor shader uses the same mapping
+glm::vec3 DecodeImpostorDirection(const glm::vec2& coords);
+// Image plane axes of a view along direction, the bake and the impostor quads must agree on them
+void GetImpostorViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up);
+
+std::string GetImpostorCachePath(const std::string& sourceFile);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !IMPOSTOR_HPP
@@ -0,0 +1,99 @@
+#ifndef INSTANCEFILE_HPP
+#define INSTANCEFILE_HPP
+
+#include <span>
+#include <glm/glm.hpp>
+
+#include <utils.hpp>
+#include <virtualfilesystem.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Per instance records of a forest, stored as a structure of arrays: every attribute of the instances lives in its
+// own array so that the passes reading only some of them, such as the level of detail selection, stream through those alone.
+//  - the position of the instance origin
+//  - its rotation around the vertical axis, in radians, counterclockwise seen from above
+//  - its scale along each axis of the mesh, applied before the rotation
+//  - a tint multiplying the colour of the mesh
+//  - its species, the variant of the mesh it draws
+struct InstanceStreams
+{
+    std::span<const glm::vec3> positions;
+    std::span<const float> rotations;
+    std::span<const glm::vec3> scales;
+    std::span<const glm::vec3> tints;
+    std::span<const uint32_t> species;
+
+    inline std::size_t GetCount() const { return positions.size(); }
+};
+
+// Owned arrays of the streams, all of the same size
+struct InstanceArrays
+{
+    std::vector<glm::vec3> positions;
+    std::vector<float> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::vec3> tints;
+    std::vector<uint32_t> species;
+
+    void Resize(std::size_t count);
+};
+
+// Instance records either parsed from text or mapped from a binary instance file.
+class InstanceData
+{
+public:
+    InstanceData() = default;
+
+    InstanceData(const InstanceData&) = delete;
+    InstanceData(InstanceData&&) = default;
+
+    InstanceData& operator=(const InstanceData&) = delete;
+    InstanceData& operator=(InstanceData&&) = default;
+
+    static InstanceData FromBuffer(InstanceArrays&& instances);
+    static InstanceData FromMapping(AssetFile&& mapping, const InstanceStreams& instances);
+
+    inline const InstanceStreams& GetStreams() const { return m_Streams; }
+    inline std::size_t GetCount() const { return m_Streams.GetCount(); }
+
+    inline bool IsMapped() const { return m_Mapping.IsOpen(); }
+
+private:
+    InstanceArrays m_Instances;
+    AssetFile m_Mapping;
+
+    InstanceStreams m_Streams;
+};
+
+// Instance as streamed to the GPU, 24 bytes instead of the 44 of the streams:
+// the position as floats, the scale and the rotation as half floats, the tint as 8 bit unsigned normalized values
+// and the species in the last byte, which the draws grouped by species never read: the mesh draws of the default shader
+// hold the position decoding of their mesh there instead, see Renderer::SetMeshUniforms.
+struct PackedInstance
+{
+    glm::vec3 position;
+    uint16_t scaleRotation[4];
+    uint8_t tintSpecies[4];
+};
+
+static_assert(sizeof(PackedInstance) == 24);
+
+// species above 255 are clamped to it, the draws reading the byte select their variant from the full species beforehand
+PackedInstance PackInstance(const glm::vec3& position, float rotation, const glm::vec3& scale, const glm::vec3& tint, uint32_t species);
+// color multiplies the tint of the instance
+PackedInstance PackInstance(const InstanceStreams& instances, std::size_t index, const glm::vec3& color = glm::vec3(1.0f));
+
+// Binary instance file: a versioned header holding the instance count and the offset of every stream
+// followed by the streams, each one aligned so that they can be mapped as they are.
+// When the file was compiled from a text file, the stamp of that file is stored
+// and checked against sourceStamp on load.
+
+std::string GetInstanceFilePath(const std::string& sourceFile);
+
+bool LoadInstanceFile(const std::string& instanceFile, InstanceData& instances, const FileStamp* sourceStamp = nullptr);
+bool WriteInstanceFile(const std::string& instanceFile, const InstanceStreams& instances, const FileStamp* sourceStamp = nullptr);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !INSTANCEFILE_HPP
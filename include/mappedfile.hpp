@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Read-only view of a whole file mapped in the process address space.
+// The mapping stays valid as long as the object is alive.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& fileName);
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& fileName);
+    void Close();
+
+    inline bool IsOpen() const { return m_Data != nullptr; }
+
+    inline const uint8_t* GetData() const { return m_Data; }
+    inline std::size_t GetSize() const { return m_Size; }
+
+    inline std::string_view GetView() const { return std::string_view(reinterpret_cast<const char*>(m_Data), m_Size); }
+
+private:
+    void* m_FileHandle = nullptr;
+    void* m_MappingHandle = nullptr;
+    const uint8_t* m_Data = nullptr;
+    std::size_t m_Size = 0;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MAPPEDFILE_HPP
@@ -0,0 +1,62 @@
+#ifndef MEMORYARENA_HPP
+#define MEMORYARENA_HPP
+
+#include <span>
+#include <type_traits>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Linear allocator for the temporaries of a load.
+// Allocations bump a pointer in large blocks which are only released all at once, by Release
+// or when the arena is destroyed. Reserving the size given by a prescan keeps a whole load in
+// a single block, further blocks are only allocated when the reservation was too small.
+// Allocating is not thread safe, threads are meant to fill arrays allocated beforehand.
+class MemoryArena
+{
+public:
+    explicit MemoryArena(std::size_t capacity = 0);
+    ~MemoryArena() = default;
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena(MemoryArena&&) = default;
+
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    MemoryArena& operator=(MemoryArena&&) = default;
+
+    // Makes sure the next allocations totalling capacity bytes fit in a single block
+    void Reserve(std::size_t capacity);
+    void Release();
+
+    void* Allocate(std::size_t size, std::size_t alignment);
+
+    // Elements are left uninitialized
+    template<typename T>
+    std::span<T> AllocateArray(std::size_t count)
+    {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>, "arena arrays are never constructed nor destroyed");
+        return std::span<T>(static_cast<T*>(Allocate(count * sizeof(T), alignof(T))), count);
+    }
+
+    // Size to reserve for an array of count T, padding included
+    template<typename T>
+    static constexpr std::size_t GetArraySize(std::size_t count) { return count * sizeof(T) + alignof(T) - 1; }
+
+    inline std::size_t GetUsedSize() const { return m_UsedSize; }
+    inline std::size_t GetCapacity() const { return m_Capacity; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size = 0;
+        std::size_t used = 0;
+    };
+
+    std::vector<Block> m_Blocks;
+    std::size_t m_UsedSize = 0;
+    std::size_t m_Capacity = 0;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MEMORYARENA_HPP
@@ -0,0 +1,133 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <span>
+#include <glm/glm.hpp>
+
+#include <virtualfilesystem.hpp>
+#include <meshlet.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+struct VertexDataPosition3fColor3f
+{
+    glm::vec3 position;
+    glm::vec3 color;
+};
+
+struct VertexDataPosition3fNormal3fColor3f
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec3 color;
+};
+
+// Parameters baked into the final vertices at import time.
+// Any change to these must invalidate the cached meshes.
+struct MeshImportSettings
+{
+    glm::vec3 color = glm::vec3(1.0f);
+    // Stores the mesh cache with quantized vertices and compressed indices, see meshcodec.hpp
+    bool quantize = false;
+    // Reorders the triangles and vertices for the vertex cache, overdraw and vertex fetch, see meshoptimizer.hpp
+    bool optimize = false;
+    // Levels of detail built by simplification, each one with about half the triangles of the previous one, see meshsimplifier.hpp
+    uint32_t lodCount = 1;
+    // Partitions the full level of detail into meshlets culled on their own, see meshlet.hpp
+    bool meshlets = false;
+    // Sorts the full level of detail into tileGridSize x tileGridSize tiles over the x and z extent of the mesh, see MeshTile, 0 keeps it whole
+    uint32_t tileGridSize = 0;
+};
+
+constexpr uint32_t s_MaxMeshLodCount = 8;
+
+// Level of detail of a mesh: a range of its indices drawn instead of the full triangle list, every level references the same vertices
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // Distance estimate between this level and the full surface, in mesh units
+    float error = 0.0f;
+};
+
+struct MeshBounds
+{
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    inline void Extend(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+};
+
+// Spatial tile of a large mesh such as a terrain, culled as a whole against the view before its meshlets if any.
+// The tiles follow each other in the indices of the full level of detail, in rows along the x axis, every one
+// holding the triangles whose centre falls in its cell of the grid and owning the meshlets built from them.
+struct MeshTile
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+    // Bounds of the triangles of the tile, which may reach out of its cell
+    MeshBounds bounds;
+};
+
+// Final, GPU ready geometry of a mesh.
+// The arrays either live in owned vectors or point inside a mapped mesh cache.
+class MeshData
+{
+public:
+    MeshData() = default;
+
+    MeshData(const MeshData&) = delete;
+    MeshData(MeshData&&) = default;
+
+    MeshData& operator=(const MeshData&) = delete;
+    MeshData& operator=(MeshData&&) = default;
+
+    static MeshData FromBuffers(std::vector<VertexDataPosition3fNormal3fColor3f>&& vertices, std::vector<uint32_t>&& indices);
+    static MeshData FromMapping(AssetFile&& mapping, std::span<const VertexDataPosition3fNormal3fColor3f> vertices, std::span<const uint32_t> indices, const MeshBounds& bounds);
+
+    inline std::span<const VertexDataPosition3fNormal3fColor3f> GetVertices() const { return m_VertexView; }
+    inline std::span<const uint32_t> GetIndices() const { return m_IndexView; }
+    inline const MeshBounds& GetBounds() const { return m_Bounds; }
+    // Empty when the mesh has no levels of detail, the indices then only hold the full mesh
+    inline std::span<const MeshLod> GetLods() const { return m_Lods; }
+
+    // Empty when the mesh was imported without meshlets, they cover the full level of detail otherwise
+    inline std::span<const Meshlet> GetMeshlets() const { return m_Meshlets; }
+    // Empty when the mesh was imported without tiles, they cover the full level of detail otherwise
+    inline std::span<const MeshTile> GetTiles() const { return m_Tiles; }
+
+    inline void SetLods(std::vector<MeshLod>&& lods) { m_Lods = std::move(lods); }
+    inline void SetMeshlets(std::vector<Meshlet>&& meshlets) { m_Meshlets = std::move(meshlets); }
+    inline void SetTiles(std::vector<MeshTile>&& tiles) { m_Tiles = std::move(tiles); }
+
+    inline bool IsMapped() const { return m_Mapping.IsOpen(); }
+
+private:
+    std::vector<VertexDataPosition3fNormal3fColor3f> m_Vertices;
+    std::vector<uint32_t> m_Indices;
+    AssetFile m_Mapping;
+
+    std::span<const VertexDataPosition3fNormal3fColor3f> m_VertexView;
+    std::span<const uint32_t> m_IndexView;
+    MeshBounds m_Bounds;
+    std::vector<MeshLod> m_Lods;
+    std::vector<Meshlet> m_Meshlets;
+    std::vector<MeshTile> m_Tiles;
+};
+
+// Coarse heightfield of resolution x resolution cells covering the bounds of a terrain mesh.
+// Every grid point takes the mean height of the terrain vertices closest to it, it is meant to
+// be drawn while the full resolution terrain is still being streamed to the GPU.
+MeshData GenerateTerrainPlaceholder(const MeshData& terrain, uint32_t resolution);
+// Same from the x, y, z positions of the terrain, for terrains whose final vertices never live on the CPU
+MeshData GenerateTerrainPlaceholder(std::span<const float> positions, glm::vec3 color, uint32_t resolution);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESH_HPP
@@ -0,0 +1,65 @@
+#ifndef MESHBUILDER_HPP
+#define MESHBUILDER_HPP
+
+#include <span>
+#include <tiny_obj_loader.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+enum WeldAttributes : uint32_t
+{
+    WeldPosition = 1 << 0,
+    WeldNormal = 1 << 1,
+    WeldTexcoord = 1 << 2,
+    WeldAll = WeldPosition | WeldNormal | WeldTexcoord
+};
+
+// Unique vertices of an indexed mesh, each one being an OBJ (v, vn, vt) triple.
+// Attributes that are not part of the weld key are set to -1.
+struct WeldedMesh
+{
+    std::vector<tinyobj::index_t> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Builds the unique vertices of a triangle list with an open addressing hash table
+// keyed on the selected attributes of every corner.
+void WeldVertices(std::span<const tinyobj::index_t> corners, uint32_t attributes, std::size_t expectedVertexCount, WeldedMesh& result);
+
+// Splits the triangles, in order, into parts that each reference at most maxVertexCount vertices,
+// returns the first triangle of every part
+std::vector<uint32_t> SplitTriangles(std::span<const uint32_t> indices, std::size_t vertexCount, uint32_t maxVertexCount = 65536);
+
+// Triangles drawn with a single call, their indices are relative to baseVertex
+struct IndexRange
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t baseVertex = 0;
+};
+
+// Index type and draw ranges of a triangle list on the GPU.
+// 16 bit indices are relative to the base vertex of their range, 32 bit indices are used as is in a single range per segment.
+struct IndexLayout
+{
+    bool shortIndices = false;
+    std::vector<IndexRange> ranges;
+    // First range of every segment followed by the range count, the segments are drawn independently
+    std::vector<uint32_t> segmentRanges;
+
+    inline std::size_t GetIndexSize() const { return shortIndices ? sizeof(uint16_t) : sizeof(uint32_t); }
+};
+
+// Picks the narrowest index type: the triangles are split in order into ranges that each span at most
+// 65536 vertices, which is only kept when it takes at most twice as many ranges as the vertex count requires.
+// Meshes split by SplitTriangles with a block of vertices per part always qualify.
+// No range straddles two segments, segmentStarts holds the first index of each (the levels of detail of a mesh),
+// the whole list is a single segment when it is empty.
+IndexLayout ChooseIndexLayout(std::span<const uint32_t> indices, std::span<const uint32_t> segmentStarts = {});
+
+// Writes indices[first, last) in the given layout at the same position of an index buffer holding the whole mesh
+void WriteIndices(std::span<const uint32_t> indices, const IndexLayout& layout, std::size_t first, std::size_t last, void* destination);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHBUILDER_HPP
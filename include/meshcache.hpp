@@ -0,0 +1,39 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <functional>
+
+#include <mesh.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Compiled mesh cache written next to the source asset on first import.
+// The cache holds the final vertex and index arrays plus the bounds, the levels of detail, the meshlets and the tiles and is
+// memory-mapped as is on later runs. It is invalidated whenever the source
+// file size, its last write time or the import settings change.
+// With MeshImportSettings::quantize the arrays are stored encoded instead and
+// decoded in parallel on load.
+
+std::string GetMeshCachePath(const std::string& sourceFile);
+
+bool LoadMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, MeshData& mesh);
+bool WriteMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, const MeshData& mesh);
+
+// Mesh written to the cache without ever holding all of its final vertices:
+// generateVertices fills the given array with the vertices starting at first.
+struct MeshCacheSource
+{
+    std::size_t vertexCount = 0;
+    std::function<void(std::size_t first, std::span<VertexDataPosition3fNormal3fColor3f> vertices)> generateVertices;
+    std::span<const uint32_t> indices;
+    MeshBounds bounds;
+    std::span<const MeshLod> lods;
+    std::span<const Meshlet> meshlets;
+    std::span<const MeshTile> tiles;
+};
+
+bool WriteMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, const MeshCacheSource& mesh);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHCACHE_HPP
@@ -0,0 +1,100 @@
+#ifndef MESHCODEC_HPP
+#define MESHCODEC_HPP
+
+#include <span>
+#include <cmath>
+
+#include <mesh.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Compact encoding of a mesh for the mesh cache:
+//  - positions are quantized to 16 bits per axis relative to the mesh bounds
+//  - normals are octahedral encoded on two 16 bits components
+//  - the color is shared by every vertex of an import so it is stored once
+//  - indices are delta, zigzag then varint coded in blocks of s_IndexBlockSize indices,
+//    every block starts from zero so that the blocks are decoded independently
+// Encoding measures the actual position and normal errors so that they can be reported.
+
+constexpr uint32_t s_IndexBlockSize = 4096;
+
+struct QuantizedVertex
+{
+    uint16_t position[3];
+    int16_t normal[2];
+};
+
+struct MeshEncodingError
+{
+    // Largest distance between a source position and its decoded value, in mesh units
+    float position = 0.0f;
+    // Largest angle between a source normal and its decoded value, in degrees
+    float normal = 0.0f;
+};
+
+// Encoded arrays, either owned by an EncodedMesh or pointing inside a mapped mesh cache
+struct EncodedMeshView
+{
+    std::span<const QuantizedVertex> vertices;
+    // One offset per index block in indexData, plus the end of the last block
+    std::span<const uint64_t> indexBlockOffsets;
+    std::span<const uint8_t> indexData;
+    uint32_t indexCount = 0;
+    MeshBounds bounds;
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+struct EncodedMesh
+{
+    std::vector<QuantizedVertex> vertices;
+    std::vector<uint64_t> indexBlockOffsets;
+    std::vector<uint8_t> indexData;
+    uint32_t indexCount = 0;
+    MeshBounds bounds;
+    glm::vec3 color = glm::vec3(1.0f);
+    MeshEncodingError error;
+
+    EncodedMeshView GetView() const;
+};
+
+// Octahedral mapping of unit vectors to [-1, 1]², shared with the packed vertex layouts
+inline glm::vec2 SignNotZero(glm::vec2 v)
+{
+    return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+inline glm::vec2 EncodeOctahedral(glm::vec3 n)
+{
+    n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    const glm::vec2 p(n.x, n.y);
+    return n.z >= 0.0f ? p : (1.0f - glm::abs(glm::vec2(p.y, p.x))) * SignNotZero(p);
+}
+
+inline glm::vec3 DecodeOctahedral(glm::vec2 p)
+{
+    glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+    if (n.z < 0.0f)
+    {
+        const glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * SignNotZero(glm::vec2(n.x, n.y));
+        n.x = folded.x;
+        n.y = folded.y;
+    }
+    return glm::normalize(n);
+}
+
+inline std::size_t GetIndexBlockCount(std::size_t indexCount) { return (indexCount + s_IndexBlockSize - 1) / s_IndexBlockSize; }
+
+// Fails when the vertices do not share a single color
+bool EncodeMesh(const MeshData& mesh, EncodedMesh& result);
+
+// Pieces of EncodeMesh for the meshes encoded block by block, error accumulates the largest errors met.
+// EncodeVertices fails when a vertex does not have the given color.
+bool EncodeVertices(std::span<const VertexDataPosition3fNormal3fColor3f> vertices, const MeshBounds& bounds, glm::vec3 color, QuantizedVertex* result, MeshEncodingError& error);
+void EncodeIndices(std::span<const uint32_t> indices, std::vector<uint64_t>& blockOffsets, std::vector<uint8_t>& data);
+
+// Decodes the vertices and the index blocks in threadCount chunks (0 means one per core), run in parallel on the thread pool
+bool DecodeMesh(const EncodedMeshView& encoded, MeshData& result, uint32_t threadCount = 0);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHCODEC_HPP
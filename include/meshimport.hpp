@@ -0,0 +1,105 @@
+#ifndef MESHIMPORT_HPP
+#define MESHIMPORT_HPP
+
+#include <chrono>
+#include <functional>
+
+#include <mesh.hpp>
+#include <meshbuilder.hpp>
+#include <objparser.hpp>
+#include <vertexformat.hpp>
+#include <virtualfilesystem.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// State of an OBJ mesh going through the import stages.
+// Each stage only touches the import it is given so that different meshes can be imported concurrently.
+struct MeshImport
+{
+    std::string name;
+    std::string inputFile;
+    MeshImportSettings settings;
+
+    AssetFile source;
+    // Parsed OBJ, left to the importer to release as it may still read the positions once the mesh is built
+    ObjData obj;
+    // Unique vertices of the parsed corners, between WeldObjMesh and FillObjMesh
+    WeldedMesh welded;
+    MeshBounds bounds;
+    MeshData mesh;
+    bool fromCache = false;
+    // Chosen once the final indices are known, the mesh data itself always holds 32 bit indices
+    IndexLayout indexLayout;
+    std::vector<uint16_t> shortIndices;
+    // Index ranges of the levels of detail, the first one is the full mesh, the index layout has a segment per level
+    std::vector<MeshLod> lods;
+    // Meshlets of the full level of detail, empty unless MeshImportSettings::meshlets is set
+    std::vector<Meshlet> meshlets;
+    // Spatial tiles of the full level of detail, empty unless MeshImportSettings::tileGridSize is set
+    std::vector<MeshTile> tiles;
+    // Generated meshes may hold several variants of one model in the same arrays: variant v draws the levels
+    // lods[v * lodsPerVariant, (v + 1) * lodsPerVariant) and, when there are meshlets, meshlets[variantMeshlets[v], variantMeshlets[v + 1])
+    uint32_t variantCount = 1;
+    std::vector<uint32_t> variantMeshlets;
+    // Layout of the vertices in GPU buffers, chosen from the bounds once they are known, packed unless packVertices is cleared
+    bool packVertices = true;
+    VertexLayout vertexLayout;
+    // Vertices of the final mesh in the vertex layout, written by PackMeshVertices
+    std::vector<std::byte> packedVertices;
+
+    std::chrono::time_point<std::chrono::steady_clock> start;
+};
+
+// What the import makes of one part of a mesh besides its full level indices, see ProcessMeshPart
+struct MeshPartResult
+{
+    // The first index of the meshlets is relative to the start of the part
+    std::vector<Meshlet> meshlets;
+    // Indices of the coarser levels in the final numbering of the part, lodIndices[0] staying empty as the full level is the part itself
+    std::vector<std::vector<uint32_t>> lodIndices;
+    std::vector<float> lodErrors;
+    // Former local vertex of every vertex of the final numbering
+    std::vector<uint32_t> order;
+    std::size_t clusterCount = 0;
+};
+
+// Called after every stage that ran with its name, the full level indices as it left them and its time in milliseconds
+using MeshPartStageCallback = std::function<void(const char* stage, std::span<const uint32_t> indices, float time)>;
+
+// Stages the import runs on every part of a mesh, in this order: vertex cache and overdraw optimizations when optimizing,
+// meshlets of the full level when the settings ask for them, coarser levels simplified from the full one in parallel,
+// then the vertex fetch order when optimizing, which renumbers the full level in place and the coarser levels with it.
+// positions and normals are those of the local vertices the indices refer to.
+void ProcessMeshPart(std::vector<uint32_t>& indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+                     const MeshImportSettings& settings, MeshPartResult& result, const MeshPartStageCallback& onStage = nullptr);
+
+// Maps the compiled mesh when it is up to date, the OBJ source otherwise
+void ReadObjMesh(MeshImport& import);
+// Parses the mapped OBJ source, nothing to do for a cached mesh
+void ParseObjMesh(MeshImport& import);
+// Welds the parsed corners into the final vertices, sorts them into tiles, builds the levels of detail and the meshlets, optimizes their order and writes the mesh cache
+void BuildObjMesh(MeshImport& import);
+
+// BuildObjMesh split for the imports written straight into GPU buffers:
+// WeldObjMesh gives the final vertex and index counts, FillObjMesh then writes the final arrays
+// into the given storage on every core and writes the mesh cache, without any CPU copy of the mesh.
+void WeldObjMesh(MeshImport& import);
+// The vertices are written in the given layout, or as VertexDataPosition3fNormal3fColor3f without one, the indices in the given index layout.
+void FillObjMesh(MeshImport& import, void* vertices, const VertexLayout* vertexLayout, void* indices, const IndexLayout& indexLayout);
+// FillObjMesh into a CPU copy of the mesh, for the welded imports that end up uploaded from memory
+void FillObjMeshData(MeshImport& import);
+
+// Writes the 16 bit indices of the final mesh into shortIndices when its index layout uses them
+void BuildShortIndices(MeshImport& import);
+// Writes the vertices of the final mesh into packedVertices in its vertex layout
+void PackMeshVertices(MeshImport& import);
+
+// Vertex layout of the import from the bounds of its final vertices
+VertexLayout ChooseVertexLayout(const MeshImport& import, const MeshBounds& bounds);
+
+// Runs the three stages in a row
+MeshData LoadObjMesh(const std::string& name, const std::string& inputFile, const MeshImportSettings& settings);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHIMPORT_HPP
@@ -0,0 +1,80 @@
+#ifndef MESHLET_HPP
+#define MESHLET_HPP
+
+#include <span>
+#include <glm/glm.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Import time partitioning of indexed triangle lists into meshlets, small clusters of neighbouring triangles
+// that are culled on their own instead of the whole mesh:
+//  - a meshlet is grown from a seed triangle by adding the adjacent triangle that brings the fewest new vertices,
+//    then the one closest to its centre, until it reaches s_MeshletMaxVertices vertices or s_MeshletMaxTriangles triangles
+//  - once no adjacent triangle is left, as with disconnected leaves, it goes on with the next triangle in order when that one is close by
+//  - every meshlet keeps a bounding sphere for frustum culling and a cone bounding the normals of its triangles
+//    for backface culling, both tested by CullMeshlet
+// The limits are the ones usually recommended for mesh shaders, so that the same clusters could feed them.
+
+constexpr uint32_t s_MeshletMaxVertices = 64;
+constexpr uint32_t s_MeshletMaxTriangles = 124;
+
+// Triangles of a meshlet are consecutive in the index buffer
+struct Meshlet
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // Bounding sphere of the triangles, in mesh space
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    // Every triangle faces away from a viewpoint v when dot(center - v, coneAxis) >= coneCutoff * |center - v| + radius,
+    // a cutoff of 1 never culls
+    glm::vec3 coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    float coneCutoff = 1.0f;
+};
+
+// Reorders the triangles so that every meshlet is a run of consecutive indices and returns the meshlets,
+// in index order, their first index being relative to the start of indices
+std::vector<Meshlet> BuildMeshlets(std::span<uint32_t> indices, std::span<const glm::vec3> positions,
+                                   uint32_t maxVertices = s_MeshletMaxVertices, uint32_t maxTriangles = s_MeshletMaxTriangles);
+
+// Bounding sphere and normal cone of the triangles indices[firstIndex, firstIndex + indexCount)
+void ComputeMeshletBounds(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, Meshlet& meshlet);
+
+// Planes of a view frustum, pointing inwards and normalized
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+    // Conservative test of an axis aligned box, boxes crossing the corners of the frustum may pass while outside
+    bool IntersectsBox(const glm::vec3& min, const glm::vec3& max) const;
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+enum class MeshletVisibility
+{
+    Visible,
+    OutsideFrustum,
+    Backfacing
+};
+
+// CPU reference of cluster culling, offset being the position of the mesh origin in world space
+MeshletVisibility CullMeshlet(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& offset = glm::vec3(0.0f));
+
+struct MeshletCullStats
+{
+    uint64_t tested = 0;
+    uint64_t outsideFrustum = 0;
+    uint64_t backfacing = 0;
+
+    inline uint64_t GetRejected() const { return outsideFrustum + backfacing; }
+};
+
+// Appends the position of every visible meshlet to visible
+void CullMeshlets(std::span<const Meshlet> meshlets, const Frustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& offset,
+                  std::vector<uint32_t>& visible, MeshletCullStats& stats);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHLET_HPP
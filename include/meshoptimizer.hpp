@@ -0,0 +1,41 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include <span>
+#include <glm/glm.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Import time reordering of indexed triangle lists, run in this order:
+//  - OptimizeVertexCache reorders the triangles for the post transform vertex cache (Tipsify)
+//  - OptimizeOverdraw reorders the clusters found by the previous step so that the ones likely
+//    to occlude the others are drawn first, without losing much of the cache efficiency
+//  - OptimizeVertexFetch renumbers the vertices in the order the triangles use them
+// Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007.
+
+constexpr uint32_t s_VertexCacheSize = 16;
+
+// Efficiency of a triangle list on a FIFO post transform cache
+struct VertexCacheStats
+{
+    // Average cache miss ratio, vertices transformed per triangle: 3 at worst, about 0.5 at best on a regular grid
+    float acmr = 0.0f;
+    // Average transform to vertex ratio, vertices transformed per referenced vertex: 1 at best
+    float atvr = 0.0f;
+};
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, std::size_t vertexCount, uint32_t cacheSize = s_VertexCacheSize);
+
+// clusterStarts receives the first triangle of every run between two jumps to a vertex out of the cache
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount, std::vector<uint32_t>* clusterStarts = nullptr, uint32_t cacheSize = s_VertexCacheSize);
+
+// The clusters are split further wherever the ACMR of the split stays within threshold times the one of
+// the cluster, then sorted by how much they face away from the center of the mesh
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions, std::span<const uint32_t> clusterStarts, float threshold = 1.05f, uint32_t cacheSize = s_VertexCacheSize);
+
+// Returns the former index of every renumbered vertex, unreferenced vertices are left out
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, std::size_t vertexCount);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHOPTIMIZER_HPP
@@ -0,0 +1,26 @@
+#ifndef MESHSIMPLIFIER_HPP
+#define MESHSIMPLIFIER_HPP
+
+#include <span>
+#include <glm/glm.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Import time simplification of indexed triangle lists by edge collapse, used to build the levels of detail of a mesh.
+// Every collapse moves all the vertices at one position onto a neighbouring position, so the simplified triangles keep
+// referencing the vertices of the source mesh and every level of detail can share a single vertex buffer.
+//  - the cost of a collapse is the squared distance of the moved position to the planes of the triangles merged into
+//    it so far (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997), plus a penalty
+//    on the normals that change when the vertices of a seam pick their closest match at the new position
+//  - positions on an open border only slide along the border, non manifold positions never move
+//  - collapses that would flip a triangle are rejected
+
+// Simplifies the triangles down to targetIndexCount indices, or until no collapse costs less than maxError,
+// and returns the simplified indices. error receives the largest distance estimate between the source
+// and the simplified surfaces, in mesh units.
+std::vector<uint32_t> SimplifyMesh(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+                                   std::size_t targetIndexCount, float maxError = std::numeric_limits<float>::max(), float* error = nullptr);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !MESHSIMPLIFIER_HPP
@@ -0,0 +1,26 @@
+#ifndef OBJPARSER_HPP
+#define OBJPARSER_HPP
+
+#include <tiny_obj_loader.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Geometry of a whole OBJ file, laid out like tinyobj::attrib_t.
+// All the groups are merged in a single triangle list.
+struct ObjData
+{
+    std::vector<float> vertices;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<tinyobj::index_t> indices;
+};
+
+// Parses the file in threadCount newline aligned chunks (0 means one per core), run in parallel on the thread pool.
+// Only v/vn/vt/f records are read, faces are triangulated the same way tinyobj does for
+// triangles and quads, bigger polygons are triangulated as fans.
+bool ParseObjFile(const std::string& inputFile, ObjData& result, uint32_t threadCount = 0);
+bool ParseObj(std::string_view text, ObjData& result, uint32_t threadCount = 0);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !OBJPARSER_HPP
@@ -0,0 +1,68 @@
+#ifndef PALMGENERATOR_HPP
+#define PALMGENERATOR_HPP
+
+#include <mesh.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+struct MeshImport;
+
+// Procedural palms, generated on the loader threads in place of the palm.obj import:
+//  - the trunk is a tapered tube along a parabola bending it away from the vertical
+//  - the fronds leave the top of the trunk all around it, their spine curving down with the droop,
+//    every segment of a spine carries a leaflet on each side, double sided as they are seen from below as well
+//  - the coarser levels of detail are generated directly, with fewer trunk rings and sides and fewer but longer leaflets
+// The variants of a palm are drawn from the same parameters with random heights, bends, frond counts and droops,
+// they share a single vertex and index array so that switching variants between instances costs nothing.
+
+struct PalmParameters
+{
+    float trunkHeight = 12.0f;
+    float trunkRadius = 0.35f;
+    // Radius at the top of the trunk relative to its base
+    float trunkTaper = 0.6f;
+    // Horizontal offset of the top of the trunk relative to its height, towards the bend azimuth
+    float trunkCurvature = 0.15f;
+    float bendAzimuth = 0.0f;
+    uint32_t trunkSegments = 12;
+    uint32_t trunkSides = 10;
+    uint32_t frondCount = 9;
+    // Azimuth of the first frond, the others follow evenly around the trunk
+    float frondPhase = 0.0f;
+    float frondLength = 5.0f;
+    // Length of the longest leaflets, halfway along the fronds
+    float frondWidth = 1.6f;
+    // Angles in radians the fronds rise at when leaving the trunk and their spine turns down by up to their tip
+    float frondElevation = 0.6f;
+    float frondDroop = 1.6f;
+    uint32_t frondSegments = 16;
+};
+
+struct PalmGeneratorSettings
+{
+    PalmParameters parameters;
+    uint32_t variantCount = 4;
+    uint32_t lodCount = 5;
+    uint32_t seed = 1;
+    // Relative spread of the random variations around the parameters
+    float variation = 0.2f;
+};
+
+// Parameters of a variant, the first one keeps the base parameters
+PalmParameters GetPalmVariant(const PalmGeneratorSettings& settings, uint32_t variant);
+
+// Appends every level of detail of a palm to vertices and indices, from the full one to the coarsest,
+// and their index ranges to lods. The error of a level estimates how far its shape strays from the full one.
+void GeneratePalm(const PalmParameters& parameters, uint32_t lodCount, const glm::vec3& color,
+                  std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods);
+
+// Fills the import with the variants instead of reading an OBJ, with the meshlets of the full level of every variant
+// when its settings ask for them. The mesh is not cached, generating takes less time than mapping a cache would.
+void GeneratePalmMesh(MeshImport& import, const PalmGeneratorSettings& settings);
+
+// Hash of every setting the generated palms depend on, which stands for the source stamp of the files baked from them
+uint64_t HashPalmGeneratorSettings(const PalmGeneratorSettings& settings);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !PALMGENERATOR_HPP
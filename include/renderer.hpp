@@ -1,15 +1,20 @@
 #ifndef RENDERER_HPP
 #define RENDERER_HPP
 
+#include <instancefile.hpp>
+#include <meshbuilder.hpp>
+#include <mesh.hpp>
+#include <impostor.hpp>
+#include <vertexformat.hpp>
+#include <palmgenerator.hpp>
+#include <geometryarena.hpp>
+#include <gpuculling.hpp>
+#include <shaderprogram.hpp>
+
 BEGIN_VISUALIZER_NAMESPACE
 
 class Camera;
-
-struct VertexDataPosition3fColor3f
-{
-    glm::vec3 position;
-    glm::vec3 color;
-};
+struct MeshImport;
 
 struct SkyboxInfo
 {
@@ -17,6 +22,75 @@ struct SkyboxInfo
     glm::mat4 projection;
 };
 
+struct RendererSettings
+{
+    // Keeps the decoded skybox faces in a raw cache so that later starts skip the PNG decoding
+    bool skyboxCache = true;
+    // Stores the mesh caches quantized and compressed, several times smaller but slightly lossy
+    bool quantizeMeshes = false;
+    // Reorders the imported meshes for the vertex cache, overdraw and vertex fetch
+    bool optimizeMeshes = true;
+    // Renders the skybox and a coarse terrain right away, the other assets switch in once they are resident
+    bool progressiveLoading = true;
+    // Bytes copied to the GPU per frame while assets stream in, 0 uploads everything as soon as it is ready
+    uint64_t uploadBudget = 16 * 1024 * 1024;
+    // The workers write the final meshes straight into persistently mapped GPU buffers instead of CPU arrays,
+    // no CPU copy of the meshes is left once they are resident and the upload budget does not apply to them
+    bool directUpload = false;
+    // Requests every startup asset from the disk in a single batch before the loaders start
+    bool prefetchAssets = true;
+    // Largest error on screen, in pixels, of the level of detail drawn for each palm, 0 always draws the full mesh
+    float lodThreshold = 1.0f;
+    // Splits the full detail meshes into meshlets at import and culls them one by one against the view
+    bool clusterCulling = true;
+    // Sorts the terrain into a grid of terrainTiles x terrainTiles tiles at import, culled against the view before their meshlets, 0 keeps it whole
+    uint32_t terrainTiles = 16;
+    // Stores the mesh vertices with 16 bit positions and octahedral normals instead of floats, see vertexformat.hpp
+    bool packVertices = true;
+    // Distance from which palms are drawn as impostors, 0 always draws their meshes
+    float impostorDistance = 150.0f;
+    ImpostorSettings impostorSettings;
+    // Generates the palms on the loader threads instead of importing palm.obj, every instance drawing one of the variants
+    bool proceduralPalms = true;
+    PalmGeneratorSettings palmSettings;
+    // Draws the palm meshes with one instanced call per variant and level of detail instead of one call per palm
+    bool instancedPalms = true;
+    // Sub-allocates the desert, palm, terrain placeholder and skybox geometry from one vertex arena and one index arena
+    // in a single shared vertex format, the opaque scene being drawn with one multi-draw indirect call built every frame.
+    // A mesh the arena can't take, with 32 bit indices, positions too large for 16 bits or past its capacity, is drawn
+    // from its own buffers instead, as are the palms when they are not instanced, see GeometryArena
+    bool multiDraw = true;
+    // Capacity of the arenas, in vertices and 16 bit indices
+    uint32_t arenaVertexCapacity = 8 * 1024 * 1024;
+    uint32_t arenaIndexCapacity = 32 * 1024 * 1024;
+    // Culls the terrain tiles and the palm instances and selects the palm levels of detail in a compute shader that writes
+    // the commands of the multi-draw, the CPU no longer touches the instances once they are resident. Requires multiDraw,
+    // the palms being only culled on the GPU when instanced, see GpuCulling
+    bool gpuCulling = true;
+};
+
+// Triangles submitted by the last frame
+struct FrameStats
+{
+    uint64_t submittedTriangles = 0;
+    // Same frame with every mesh drawn at full detail
+    uint64_t fullDetailTriangles = 0;
+    // Instances drawn as impostors, two triangles each
+    uint64_t impostorCount = 0;
+    // Meshlets tested and rejected by cluster culling
+    MeshletCullStats meshlets;
+    // Terrain tiles tested against the view and rejected
+    uint64_t testedTiles = 0;
+    uint64_t culledTiles = 0;
+    // Palms whose bounds are out of the view, skipped by the instanced draws
+    uint64_t culledPalms = 0;
+    uint64_t drawCalls = 0;
+    // Commands of the multi-draw, which only counts as one of drawCalls
+    uint64_t indirectDraws = 0;
+    // Commands written by the GPU culling, whose triangles, impostors and culled palms and tiles are not counted above
+    uint64_t gpuCulledDraws = 0;
+};
+
 struct STBIImgInfo
 {
     int width;
@@ -28,14 +102,10 @@ struct STBIImgInfo
 class Renderer
 {
 public:
-    Renderer(uint32_t width, uint32_t height, const std::shared_ptr<Camera>& camera)
-        : m_ViewportWidth(width)
-        , m_ViewportHeight(height)
-        , m_Camera(camera)
-    {}
+    Renderer(uint32_t width, uint32_t height, const std::shared_ptr<Camera>& camera, const RendererSettings& settings = RendererSettings());
 
     Renderer() = delete;
-    ~Renderer() = default;
+    ~Renderer();
     Renderer(const Renderer&) = delete;
     Renderer(Renderer&&) = delete;
 
@@ -43,31 +113,208 @@ public:
     Renderer& operator=(Renderer&&) = delete;
 
     bool Initialize();
+    // Uploads the assets loaded since the last frame, within the per frame upload budget
+    void StreamAssets();
     void Render();
     void Cleanup();
 
     void UpdateViewport(uint32_t width, uint32_t height);
     void UpdateCamera();
 
+    inline const FrameStats& GetFrameStats() const { return m_FrameStats; }
+
 private:
     void ShaderError(GLuint ID, std::string type);
     void ShaderProgramError(GLuint ID);
     GLuint InitShader(char const* const vertexSrc, char const* const fragmentSrc);
     GLuint InitSkyboxShader();
     GLuint InitDefaultShader();
+    GLuint InitImpostorShader();
+    GLuint InitComputeShader(char const* const computeSrc);
+    // Links and reflects the shaders, then looks up the uniforms the frames set
+    bool InitShaderPrograms();
+
+    struct StreamingState;
+
+    void SetupMeshVertexArray(GLuint vao, GLuint vbo, GLuint ibo, const VertexLayout& layout);
+    // Vertex array of a mesh, the one of the arena for the meshes it holds
+    inline GLuint GetVertexArray(uint32_t meshID) const { return m_InArena[meshID] ? m_ArenaVAO : m_VAO[meshID]; }
+    // Copies the skybox cube into the arena, false when it doesn't fit
+    bool UploadSkyboxMesh();
+    // Sub-allocates a mesh from the arena, false when its layouts don't fit the arena or the arena is full
+    bool AllocateArenaMesh(uint32_t meshID, const MeshImport& import, std::size_t vertexCount, std::size_t indexCount);
+    // Storage of the palm instances drawn from the vertex array of the palm mesh, once both the instances and the mesh are there
+    void AllocatePalmInstanceBuffer();
+    // Instance attributes firstLocation to firstLocation + 2 read the PackedInstance records of vbo through the given binding
+    void SetupInstanceAttributes(GLuint vao, GLuint binding, GLuint vbo, uint32_t firstLocation);
+    // Transform and tint of the meshes drawn without instance buffer
+    void SetInstanceUniforms(const glm::vec3& position = glm::vec3(0.0f), float rotation = 0.0f, const glm::vec3& scale = glm::vec3(1.0f), const glm::vec3& tint = glm::vec3(1.0f));
+    // Uniforms of the default shader decoding the vertex layout and replacing the vertex colours, the first position decoding being the one
+    // of the draws made right away. While the draws are recorded the colour goes in the untransformed instance the next draws read,
+    // and the positions get a decoding of their own, which that instance and the palm instances select with their last byte
+    void SetMeshUniforms(const VertexLayout& layout, const glm::vec3& color);
+    // Uniforms of the draws from the arena, their colours being in the tints and their position decodings selected by their instances
+    void SetArenaUniforms(std::span<const glm::vec3> positionOffsets, std::span<const glm::vec3> positionScales);
+    // allocated when MapMeshStorage already gave the mesh its storage but couldn't map it
+    void QueueMeshUpload(uint32_t meshID, MeshImport& import, bool allocated = false);
+    void UploadPlaceholder(const MeshData& mesh);
+    uint64_t FlushUploads(uint64_t budget);
+    void MapMeshStorage(uint32_t meshID, MeshImport& import);
+    void FillMappedMesh(uint32_t meshID, MeshImport& import);
+    void PublishMappedMesh(uint32_t meshID);
+    bool PollMappedMeshes(bool wait);
+    // Draws indexCount indices from firstIndex relative to baseVertex, instanced when instanceCount is not 0,
+    // or appends them to the indirect commands of the frame while the opaque scene is recorded
+    void SubmitDraw(GLenum indexType, uint32_t firstIndex, uint32_t indexCount, uint32_t baseVertex, uint32_t instanceCount = 0, uint32_t baseInstance = 0);
+    // Draws the recorded commands with a single multi-draw call and stops recording
+    void SubmitRecordedDraws();
+    // Returns the number of triangles drawn
+    uint32_t DrawMesh(uint32_t meshID, uint32_t lod = 0);
+    // Draws indices[firstIndex, firstIndex + indexCount) of a level of detail, split along its index ranges
+    uint32_t DrawIndices(uint32_t meshID, uint32_t lod, uint32_t firstIndex, uint32_t indexCount);
+    // Draws the meshlets of the full level of detail of a variant that pass cluster culling, offset being the mesh position
+    uint32_t DrawMeshlets(uint32_t meshID, uint32_t variant, const Frustum& frustum, const glm::vec3& offset);
+    // Draws the runs of consecutive meshlets listed in m_VisibleMeshlets, positions in meshlets
+    uint32_t DrawVisibleMeshlets(uint32_t meshID, std::span<const Meshlet> meshlets);
+    // Draws the tiles of the full level of detail in the view, through cluster culling of their own meshlets if they have some
+    uint32_t DrawTiles(uint32_t meshID, const Frustum& frustum);
+    // Draws instanceCount instances of a level of detail, their positions starting at baseInstance in the bound instance buffer
+    uint32_t DrawMeshInstanced(uint32_t meshID, uint32_t lod, uint32_t instanceCount, uint32_t baseInstance);
+    // Variant of the palm mesh an instance draws, from its species
+    inline uint32_t GetPalmVariant(std::size_t instance) const { return m_TransfoPalm.GetStreams().species[instance] % m_VariantCount[1]; }
+    // Instance of an impostor, the layer of the atlas of its variant in the last byte
+    inline PackedInstance PackImpostorInstance(const InstanceStreams& instances, std::size_t instance) const
+    {
+        return PackInstance(instances.positions[instance], instances.rotations[instance], instances.scales[instance], instances.tints[instance], GetPalmVariant(instance) % m_ImpostorLayerCount);
+    }
+    // Pixels covered on screen by one unit at a distance of one
+    float GetPixelsPerUnit() const;
+    void SelectPalmLods();
+    // Draws the palm meshes in view with an instanced call per variant and level of detail, queues the others for the impostors
+    uint32_t DrawPalmInstances(const Frustum& frustum);
+    // Renders every variant of the palm mesh into its layer of the impostor atlas and caches it
+    void BakePalmImpostor();
+    // Source of the palm impostor cache: palm.obj, or the generator settings standing for it with an empty stamp
+    std::string GetPalmImpostorCachePath() const;
+    bool GetPalmImpostorStamp(FileStamp& stamp) const;
+    // Hash of the settings the palm impostor is baked with besides its source: mesh colour, levels of detail and vertex encoding
+    uint64_t HashPalmImpostorSettings() const;
+    // Draws the impostors queued by DrawPalmInstances, or the ones the GPU culling selected
+    void DrawPalmImpostors();
+    // Sets the scene of the GPU culling again once a mesh or the palm instances became resident
+    void PrepareGpuCulling();
+    // Runs the GPU culling and draws the commands it wrote with a single multi-draw call
+    void DrawGpuCulledScene();
+    void FinishStreaming();
+
+    GLuint m_UBO, m_VBO[3], m_IBO[3], m_VAO[3], m_Texture;
+    // Default, skybox and impostor shaders
+    ShaderProgram m_ShaderProgram[3];
+    // Uniforms of the shaders, resolved once they are linked
+    struct DefaultUniforms
+    {
+        ShaderProgram::Uniform<bool> instanced;
+        ShaderProgram::Uniform<glm::vec3> transfoModif;
+        ShaderProgram::Uniform<glm::vec4> instanceScaleRotation;
+        ShaderProgram::Uniform<glm::vec3> instanceTint;
+        ShaderProgram::Uniform<glm::vec3> meshColor;
+        ShaderProgram::Uniform<glm::vec3> positionOffset;
+        ShaderProgram::Uniform<glm::vec3> positionScale;
+        ShaderProgram::Uniform<bool> octahedralNormals;
+    } m_DefaultUniforms;
+    struct SkyboxUniforms
+    {
+        ShaderProgram::Uniform<glm::mat4> view;
+        ShaderProgram::Uniform<glm::mat4> projection;
+    } m_SkyboxUniforms;
+    struct ImpostorUniforms
+    {
+        ShaderProgram::Uniform<glm::vec3> cameraPosition;
+        ShaderProgram::Uniform<glm::vec3> impostorCenter;
+        ShaderProgram::Uniform<float> impostorRadius;
+        ShaderProgram::Uniform<float> framesPerSide;
+    } m_ImpostorUniforms;
+    GLuint m_PlaceholderVBO, m_PlaceholderIBO, m_PlaceholderVAO;
 
-    GLuint m_UBO, m_VBO[3], m_IBO[3], m_VAO[3], m_ShaderProgram[2], m_Texture;
+    uint32_t m_IndexCount[2] = {};
+    IndexLayout m_IndexLayout[2];
+    std::vector<MeshLod> m_MeshLods[2];
+    std::vector<Meshlet> m_Meshlets[2];
+    // Variants of every mesh, see MeshImport::variantCount, the palm instances cycle through them
+    uint32_t m_VariantCount[2] = { 1, 1 };
+    std::vector<uint32_t> m_VariantMeshlets[2];
+    std::vector<uint32_t> m_VisibleMeshlets;
+    std::vector<MeshTile> m_Tiles[2];
+    std::vector<uint32_t> m_VisibleTiles;
+    // Level of detail of its variant drawn for every palm instance, or s_ImpostorLod, kept from frame to frame for the hysteresis
+    std::vector<uint8_t> m_PalmLods;
+    // Instances of the palms drawn as meshes this frame, sorted by draw, and where every draw starts
+    GLuint m_PalmInstanceVBO;
+    bool m_PalmInstanceStorage = false;
+    std::vector<PackedInstance> m_PalmInstances;
+    std::vector<uint32_t> m_PalmDrawStarts;
+    std::vector<uint32_t> m_PalmInstanceDraws;
+    FrameStats m_FrameStats;
+    MeshBounds m_MeshBounds[2];
+    VertexLayout m_VertexLayouts[2];
+    glm::vec3 m_MeshColors[2] = { glm::vec3(1.0f), glm::vec3(1.0f) };
+    VertexLayout m_PlaceholderLayout;
+    glm::vec3 m_PlaceholderColor = glm::vec3(1.0f);
 
-    uint32_t m_IndexCount[2];
+    // Colour and depth atlases of the palm impostor, array textures with a layer per variant
+    GLuint m_ImpostorTextures[2];
+    uint32_t m_ImpostorLayerCount = 1;
+    GLuint m_ImpostorVAO, m_ImpostorInstanceVBO;
+    glm::vec3 m_ImpostorCenter = glm::vec3(0.0f);
+    float m_ImpostorRadius = 0.0f;
+    bool m_ImpostorReady = false;
+    // Instances of the palms drawn as impostors this frame
+    std::vector<PackedInstance> m_ImpostorInstances;
+    uint32_t m_PlaceholderIndexCount = 0;
+
+    // Every static mesh when drawing with multiDraw, the vertex array reading it also reads the instances of the frame at binding 1
+    GeometryArena m_Arena;
+    GLuint m_ArenaVAO = 0, m_DrawInstanceVBO = 0, m_IndirectBuffer = 0;
+    // Desert, palm and skybox meshes held by the arena, the ones it couldn't take falling back to their own buffers,
+    // drawn right away instead of recorded
+    bool m_InArena[3] = {};
+    // Where the meshes start in the arena, they stay at 0 in their own buffers
+    GeometryArena::Allocation m_MeshAllocations[2];
+    GeometryArena::Allocation m_PlaceholderAllocation;
+    // Same as m_InArena for the placeholder terrain
+    bool m_PlaceholderInArena = false;
+    GeometryArena::Allocation m_SkyboxAllocation;
+    // Set while the opaque scene is recorded into m_DrawCommands instead of drawn
+    bool m_RecordDraws = false;
+    std::vector<DrawElementsIndirectCommand> m_DrawCommands;
+    // Instances the commands of the frame read, the untransformed ones of the non instanced draws carrying the colour of their mesh
+    std::vector<PackedInstance> m_DrawInstances;
+    uint32_t m_RecordedInstance = 0;
+    glm::vec3 m_RecordedColor = glm::vec3(1.0f);
+    // Position decodings of the recorded meshes, after the one of the draws made right away
+    std::vector<glm::vec3> m_PositionOffsets;
+    std::vector<glm::vec3> m_PositionScales;
+    uint8_t m_RecordedPositionDecode = 0;
+
+    // Terrain and palms once resident when culling on the GPU, drawn through the arena with the culled instances at binding 1
+    GpuCulling m_GpuCulling;
+    GLuint m_CulledVAO = 0;
+    // Bit 0 once the terrain is part of the GPU culling scene, bit 1 once the palms are
+    uint32_t m_GpuCulledMeshes = 0;
 
     glm::mat4* m_UBOData;
 
     SkyboxInfo m_SkyboxInfo;
 
-    std::vector<glm::vec4> m_TransfoPalm;
+    InstanceData m_TransfoPalm;
 
     std::shared_ptr<Camera> m_Camera;
     uint32_t m_ViewportWidth, m_ViewportHeight;
+
+    RendererSettings m_Settings;
+
+    // Alive until every asset is resident on the GPU
+    std::unique_ptr<StreamingState> m_Streaming;
 };
 
 END_VISUALIZER_NAMESPACE
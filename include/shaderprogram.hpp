@@ -0,0 +1,90 @@
+#ifndef SHADERPROGRAM_HPP
+#define SHADERPROGRAM_HPP
+
+#include <span>
+
+#include <glm/glm.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Linked program whose interface is reflected once, right after linking: every active uniform with its location and type,
+// and the binding of every uniform block and shader storage block. Names are only looked up while the renderer sets up,
+// in the reflected tables: the uniforms are then set through typed handles, without any string or GL query per frame.
+class ShaderProgram
+{
+public:
+    // Location of a uniform of type T, -1 when the program doesn't use it, which the setters ignore like glUniform does
+    template<typename T>
+    struct Uniform
+    {
+        GLint location = -1;
+    };
+
+    ShaderProgram() = default;
+    ~ShaderProgram();
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram(ShaderProgram&&) = delete;
+
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(ShaderProgram&&) = delete;
+
+    // Takes ownership of a program linked by Renderer::InitShader and reflects it, false when it failed to link
+    bool Create(GLuint program);
+    void Destroy();
+
+    void Use() const;
+
+    // Handle of an active uniform, checked against the reflected type, arrays being named without their [0]
+    template<typename T>
+    Uniform<T> GetUniform(std::string_view name) const { return Uniform<T>{ FindUniform(name, GetUniformType<T>()) }; }
+    // Bindings of the blocks, -1 when the program has no such block
+    GLint GetUniformBlockBinding(std::string_view name) const;
+    GLint GetStorageBlockBinding(std::string_view name) const;
+
+    // The setters write the program directly, it doesn't need to be in use
+    void Set(Uniform<bool> uniform, bool value) const;
+    void Set(Uniform<int32_t> uniform, int32_t value) const;
+    void Set(Uniform<uint32_t> uniform, uint32_t value) const;
+    void Set(Uniform<float> uniform, float value) const;
+    void Set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+    // Elements of an array from the first one
+    void Set(Uniform<glm::vec3> uniform, std::span<const glm::vec3> values) const;
+    void Set(Uniform<glm::vec4> uniform, const glm::vec4& value) const;
+    void Set(Uniform<glm::mat4> uniform, const glm::mat4& value) const;
+
+    inline GLuint GetID() const { return m_Program; }
+
+private:
+    struct Resource
+    {
+        std::string name;
+        // Location of a uniform, binding of a block
+        GLint index = -1;
+        GLenum type = 0;
+    };
+
+    template<typename T>
+    static constexpr GLenum GetUniformType();
+
+    // Location of a uniform, reporting the ones missing or of another type
+    GLint FindUniform(std::string_view name, GLenum type) const;
+    static GLint FindBlock(const std::vector<Resource>& blocks, std::string_view name);
+
+    GLuint m_Program = 0;
+    std::vector<Resource> m_Uniforms;
+    std::vector<Resource> m_UniformBlocks;
+    std::vector<Resource> m_StorageBlocks;
+};
+
+template<> constexpr GLenum ShaderProgram::GetUniformType<bool>() { return GL_BOOL; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<int32_t>() { return GL_INT; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<uint32_t>() { return GL_UNSIGNED_INT; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<float>() { return GL_FLOAT; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<glm::vec3>() { return GL_FLOAT_VEC3; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<glm::vec4>() { return GL_FLOAT_VEC4; }
+template<> constexpr GLenum ShaderProgram::GetUniformType<glm::mat4>() { return GL_FLOAT_MAT4; }
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !SHADERPROGRAM_HPP
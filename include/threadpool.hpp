@@ -0,0 +1,109 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Fixed set of worker threads consuming a FIFO of tasks.
+// Pending tasks are still run when the pool is destroyed.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    // Runs function(i) for i in [0, count) on the workers and the calling thread, and returns once every call returned.
+    // The calling thread takes indices too, so a task of the pool may split its work without waiting on workers busy with others.
+    template<typename Function>
+    void ParallelFor(std::size_t count, Function&& function);
+
+    inline uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+    // Pool the calling thread is a worker of, nullptr on any other thread
+    static ThreadPool* GetCurrent();
+    // Pool of the threads that are not workers of a pool, created on first use
+    static ThreadPool& GetShared();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_Threads;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Stopping = false;
+};
+
+template<typename Function>
+void ThreadPool::ParallelFor(std::size_t count, Function&& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Shared with the tasks of the loop, which may only start once it is over
+    struct Loop
+    {
+        std::atomic<std::size_t> next = 0;
+        std::atomic<std::size_t> done = 0;
+        std::mutex mutex;
+        std::condition_variable condition;
+    };
+
+    const std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+
+    //function is only called for the indices taken while the caller still waits for them:
+    auto run = [loop, count, &function]() {
+        for (std::size_t i = loop->next++; i < count; i = loop->next++)
+        {
+            function(i);
+
+            if (++loop->done == count)
+            {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->condition.notify_all();
+            }
+        }
+    };
+
+    const std::size_t taskCount = std::min<std::size_t>(count - 1, m_Threads.size());
+
+    for (std::size_t i = 0; i < taskCount; ++i)
+    {
+        Submit(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->condition.wait(lock, [&loop, count]() { return loop->done == count; });
+}
+
+// ThreadPool::ParallelFor on the pool of the calling worker, or on the shared pool from any other thread,
+// so that nested loops never add threads to the ones of the pools
+template<typename Function>
+void ParallelFor(std::size_t count, Function&& function)
+{
+    ThreadPool* pool = ThreadPool::GetCurrent();
+
+    (pool ? *pool : ThreadPool::GetShared()).ParallelFor(count, std::forward<Function>(function));
+}
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !THREADPOOL_HPP
@@ -6,10 +6,38 @@
 
 BEGIN_VISUALIZER_NAMESPACE
 
-bool LoadFile(const std::string& fileName, std::string& result);
+class AssetFile;
+struct InstanceArrays;
+
+// Identifies a version of a source asset, used to invalidate the files compiled from it
+struct FileStamp
+{
+    uint64_t size = 0;
+    int64_t writeTime = 0;
+};
+
+bool GetFileStamp(const std::string& fileName, FileStamp& stamp);
+// FNV-1a, the settings baked into a compiled file are hashed field by field from s_HashSeed
+constexpr uint64_t s_HashSeed = 0xCBF29CE484222325ull;
+void HashBytes(uint64_t& hash, const void* data, std::size_t size);
+// The loaders below resolve their file through the VirtualFileSystem
+bool LoadFile(const std::string& fileName, AssetFile& result);
 void DisplayLastWinAPIError();
-tinyobj::ObjReader LoadObjFile(std::string inputFile, tinyobj::ObjReaderConfig readerConfig = tinyobj::ObjReaderConfig());
-std::vector<glm::vec4> LoadTransfoFile(std::string inputFile);
+// Peak working set of the process so far, in bytes
+std::size_t GetPeakMemoryUsage();
+// Content of an OBJ file as tinyobj loads it, the mtllib lines being ignored
+struct TinyObjMesh
+{
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    bool valid = false;
+};
+TinyObjMesh LoadObjFile(std::string inputFile, tinyobj::ObjReaderConfig readerConfig = tinyobj::ObjReaderConfig());
+// Instances of a transform file: a line count then a line per instance, "x y z w" optionally followed by
+// "rotation scaleX scaleY scaleZ r g b species". w scales the instance uniformly on top of the scale of each axis,
+// the instances without species take the FNV-1a hash of the bytes of their position as one (see HashBytes).
+InstanceArrays LoadTransfoFile(std::string inputFile);
 
 END_VISUALIZER_NAMESPACE
 
@@ -0,0 +1,85 @@
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+
+#include <span>
+
+#include <mesh.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Layouts of the mesh vertices in GPU buffers, the CPU side always holds VertexDataPosition3fNormal3fColor3f:
+//  - positions are either floats or 16 bit unsigned normalized values relative to the mesh bounds,
+//    rescaled by the vertex shader from positionOffset and positionScale
+//  - normals are either floats or octahedral encoded in the x and y components of a signed 10_10_10_2 word,
+//    its w component being 0 for the vertices without normal
+//  - the color is the same for every vertex of an import, it is a uniform of the mesh instead of an attribute
+// The layout of a mesh is chosen at import from its bounds, the vertex arrays are set up from its attribute list.
+
+// Largest position error allowed by the 16 bit positions, in mesh units
+constexpr float s_MaxPackedPositionError = 0.005f;
+
+constexpr uint32_t s_PositionAttribute = 0;
+constexpr uint32_t s_NormalAttribute = 1;
+// Per instance attributes of the instanced draws, read from their own buffer of PackedInstance rather than from the vertex layout
+constexpr uint32_t s_InstancePositionAttribute = 2;
+constexpr uint32_t s_InstanceScaleRotationAttribute = 3;
+constexpr uint32_t s_InstanceTintAttribute = 4;
+
+enum class VertexPositionFormat : uint8_t
+{
+    Float3,
+    Unorm16
+};
+
+enum class VertexNormalFormat : uint8_t
+{
+    Float3,
+    Octahedral10
+};
+
+struct VertexFormat
+{
+    VertexPositionFormat position = VertexPositionFormat::Float3;
+    VertexNormalFormat normal = VertexNormalFormat::Float3;
+};
+
+enum class VertexAttributeType : uint8_t
+{
+    Float,
+    UnsignedShort,
+    Int2_10_10_10
+};
+
+struct VertexAttribute
+{
+    uint32_t location = 0;
+    uint32_t componentCount = 0;
+    VertexAttributeType type = VertexAttributeType::Float;
+    bool normalized = false;
+    uint32_t offset = 0;
+};
+
+struct VertexLayout
+{
+    VertexFormat format;
+    uint32_t stride = 0;
+    std::vector<VertexAttribute> attributes;
+    // Positions decode as positionOffset + attribute * positionScale
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+
+    static VertexLayout Create(const VertexFormat& format, const MeshBounds& bounds);
+
+    // Writes the vertices in this layout, destination holding vertices.size() * stride bytes
+    void PackVertices(std::span<const VertexDataPosition3fNormal3fColor3f> vertices, void* destination) const;
+};
+
+// The packed formats when pack is set, 16 bit positions only when their error stays under maxPositionError
+VertexFormat ChooseVertexFormat(const MeshBounds& bounds, bool pack, float maxPositionError = s_MaxPackedPositionError);
+// Format of a vertex arena, the one ChooseVertexFormat picks for the meshes whose bounds allow 16 bit positions,
+// every mesh in the arena keeping the positionOffset and positionScale of its own layout
+VertexFormat GetSharedVertexFormat(bool pack);
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !VERTEXFORMAT_HPP
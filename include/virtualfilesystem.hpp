@@ -0,0 +1,98 @@
+#ifndef VIRTUALFILESYSTEM_HPP
+#define VIRTUALFILESYSTEM_HPP
+
+#include <span>
+
+#include <utils.hpp>
+#include <assetpack.hpp>
+#include <mappedfile.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+// Read-only view of an asset resolved by the VirtualFileSystem.
+// It points either inside the mounted asset pack or in a loose file mapped on its own,
+// the view stays valid as long as the object is alive.
+class AssetFile
+{
+public:
+    AssetFile() = default;
+
+    AssetFile(const AssetFile&) = delete;
+    AssetFile(AssetFile&& other) noexcept;
+
+    AssetFile& operator=(const AssetFile&) = delete;
+    AssetFile& operator=(AssetFile&& other) noexcept;
+
+    void Close();
+
+    inline bool IsOpen() const { return !m_Data.empty(); }
+    inline bool IsPacked() const { return IsOpen() && !m_Mapping.IsOpen(); }
+
+    inline const uint8_t* GetData() const { return m_Data.data(); }
+    inline std::size_t GetSize() const { return m_Data.size(); }
+
+    inline std::string_view GetView() const { return std::string_view(reinterpret_cast<const char*>(m_Data.data()), m_Data.size()); }
+
+private:
+    friend class VirtualFileSystem;
+
+    MappedFile m_Mapping;
+    std::span<const uint8_t> m_Data;
+};
+
+// Resolves the asset paths, relative to the resource directory, first in the mounted
+// asset pack then in the resource directory itself. Every asset is handed out as a view,
+// either in the pack mapping or in a mapping of the loose file.
+// Mounting happens at startup, lookups can then be made from any thread.
+class VirtualFileSystem
+{
+public:
+    inline static VirtualFileSystem& GetInstance()
+    {
+        static VirtualFileSystem instance;
+        return instance;
+    }
+
+    VirtualFileSystem(const VirtualFileSystem&) = delete;
+    VirtualFileSystem(VirtualFileSystem&&) = delete;
+
+    VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+    VirtualFileSystem& operator=(VirtualFileSystem&&) = delete;
+
+    bool MountPack(const std::string& packFile);
+    void SetResourceDirectory(const std::string& resourceDirectory);
+
+    bool Open(const std::string& path, AssetFile& file) const;
+    // Skips the pack
+    bool OpenLoose(const std::string& path, AssetFile& file) const;
+    bool GetFileStamp(const std::string& path, FileStamp& stamp) const;
+
+    // Files compiled from the assets are read from the pack, then from the resource directory when read rejects the packed copy:
+    // a cache packed before a settings or format change must not hide the up to date one written since
+    template<typename Read>
+    bool OpenCompiled(const std::string& path, Read&& read) const
+    {
+        AssetFile file;
+
+        if (Open(path, file) && read(file))
+        {
+            return true;
+        }
+
+        return file.IsPacked() && OpenLoose(path, file) && read(file);
+    }
+
+    // Where the files compiled from the assets are written, packs are read-only
+    std::string GetLoosePath(const std::string& path) const;
+
+private:
+    VirtualFileSystem() = default;
+    ~VirtualFileSystem() = default;
+
+    AssetPack m_Pack;
+    std::string m_ResourceDirectory;
+};
+
+END_VISUALIZER_NAMESPACE
+
+#endif // !VIRTUALFILESYSTEM_HPP
@@ -0,0 +1,281 @@
+#include <assetpack.hpp>
+#include <filesystem>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_AssetPackMagic = 0x4B415056; // "VPAK"
+    constexpr uint32_t s_AssetPackVersion = 1;
+    constexpr uint64_t s_AssetPackTableAlignment = 64;
+    // Blobs start on a page so that each of them is mapped on its own pages
+    constexpr uint64_t s_AssetPackPageSize = 4096;
+
+    struct AssetPackHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t pageSize;
+        uint64_t tableOffset;
+        uint64_t pathsOffset;
+        uint64_t pathsSize;
+    };
+
+    struct AssetPackEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+        int64_t writeTime;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    struct PackedFile
+    {
+        std::string path;
+        std::filesystem::path sourceFile;
+        FileStamp stamp;
+    };
+
+    constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    inline const AssetPackHeader& GetHeader(const MappedFile& mapping)
+    {
+        return *reinterpret_cast<const AssetPackHeader*>(mapping.GetData());
+    }
+
+    inline std::span<const AssetPackEntry> GetTable(const MappedFile& mapping)
+    {
+        const AssetPackHeader& header = GetHeader(mapping);
+        return std::span<const AssetPackEntry>(reinterpret_cast<const AssetPackEntry*>(mapping.GetData() + header.tableOffset), header.entryCount);
+    }
+
+    inline std::string_view GetPath(const MappedFile& mapping, const AssetPackEntry& entry)
+    {
+        const AssetPackHeader& header = GetHeader(mapping);
+        return std::string_view(reinterpret_cast<const char*>(mapping.GetData() + header.pathsOffset + entry.pathOffset), entry.pathLength);
+    }
+}
+
+bool AssetPack::Open(const std::string& packFile)
+{
+    Close();
+
+    MappedFile mapping;
+
+    if (!mapping.Open(packFile) || mapping.GetSize() < sizeof(AssetPackHeader))
+    {
+        return false;
+    }
+
+    const AssetPackHeader& header = GetHeader(mapping);
+
+    if (header.magic != s_AssetPackMagic || header.version != s_AssetPackVersion)
+    {
+        std::cerr << "Not an asset pack: " << packFile << '\n';
+        return false;
+    }
+
+    if (header.tableOffset % alignof(AssetPackEntry) != 0 ||
+        header.tableOffset + uint64_t(header.entryCount) * sizeof(AssetPackEntry) > mapping.GetSize() ||
+        header.pathsOffset + header.pathsSize > mapping.GetSize())
+    {
+        std::cerr << "Truncated asset pack: " << packFile << '\n';
+        return false;
+    }
+
+    for (const AssetPackEntry& entry : GetTable(mapping))
+    {
+        if (entry.offset + entry.size > mapping.GetSize() || uint64_t(entry.pathOffset) + entry.pathLength > header.pathsSize)
+        {
+            std::cerr << "Invalid asset pack entry in " << packFile << '\n';
+            return false;
+        }
+    }
+
+    m_EntryCount = header.entryCount;
+    m_Mapping = std::move(mapping);
+
+    return true;
+}
+
+void AssetPack::Close()
+{
+    m_Mapping.Close();
+    m_EntryCount = 0;
+}
+
+bool AssetPack::Find(std::string_view path, std::span<const uint8_t>& data, FileStamp& stamp) const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    const std::span<const AssetPackEntry> table = GetTable(m_Mapping);
+
+    const auto entry = std::lower_bound(table.begin(), table.end(), path, [this](const AssetPackEntry& entry, std::string_view path) {
+        return GetPath(m_Mapping, entry) < path;
+    });
+
+    if (entry == table.end() || GetPath(m_Mapping, *entry) != path)
+    {
+        return false;
+    }
+
+    data = std::span<const uint8_t>(m_Mapping.GetData() + entry->offset, entry->size);
+    stamp.size = entry->size;
+    stamp.writeTime = entry->writeTime;
+
+    return true;
+}
+
+bool BuildAssetPack(const std::string& resourceDirectory, const std::string& packFile)
+{
+    const std::string tempFile = packFile + ".tmp";
+
+    std::vector<PackedFile> files;
+    std::error_code error;
+
+    //the pack usually lives in the directory it is built from:
+    std::error_code packError;
+    const std::filesystem::path packPath = std::filesystem::weakly_canonical(packFile, packError);
+
+    for (std::filesystem::recursive_directory_iterator it(resourceDirectory, error), end; !error && it != end; it.increment(error))
+    {
+        std::error_code fileError;
+
+        if (!it->is_regular_file(fileError) || it->path().extension() == ".tmp" || std::filesystem::weakly_canonical(it->path(), fileError) == packPath)
+        {
+            continue;
+        }
+
+        PackedFile file;
+        file.path = std::filesystem::relative(it->path(), resourceDirectory, fileError).generic_string();
+        file.sourceFile = it->path();
+
+        if (!GetFileStamp(file.sourceFile.string(), file.stamp))
+        {
+            std::cerr << "Cannot stat file: " << file.sourceFile.string() << '\n';
+            return false;
+        }
+
+        files.push_back(std::move(file));
+    }
+
+    if (error)
+    {
+        std::cerr << "Cannot list resource directory: " << resourceDirectory << " (" << error.message() << ")\n";
+        return false;
+    }
+
+    std::sort(files.begin(), files.end(), [](const PackedFile& a, const PackedFile& b) { return a.path < b.path; });
+
+    AssetPackHeader header = {};
+    header.magic = s_AssetPackMagic;
+    header.version = s_AssetPackVersion;
+    header.entryCount = static_cast<uint32_t>(files.size());
+    header.pageSize = static_cast<uint32_t>(s_AssetPackPageSize);
+    header.tableOffset = AlignUp(sizeof(AssetPackHeader), s_AssetPackTableAlignment);
+    header.pathsOffset = header.tableOffset + files.size() * sizeof(AssetPackEntry);
+
+    std::vector<AssetPackEntry> table;
+    table.reserve(files.size());
+
+    std::string paths;
+
+    for (const PackedFile& file : files)
+    {
+        AssetPackEntry entry = {};
+        entry.size = file.stamp.size;
+        entry.writeTime = file.stamp.writeTime;
+        entry.pathOffset = static_cast<uint32_t>(paths.size());
+        entry.pathLength = static_cast<uint32_t>(file.path.size());
+
+        paths += file.path;
+        table.push_back(entry);
+    }
+
+    header.pathsSize = paths.size();
+
+    uint64_t offset = header.pathsOffset + header.pathsSize;
+
+    for (AssetPackEntry& entry : table)
+    {
+        offset = AlignUp(offset, s_AssetPackPageSize);
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    static_assert(sizeof(AssetPackHeader) <= s_AssetPackTableAlignment);
+
+    {
+        std::ofstream ofs(tempFile, std::ios::binary | std::ios::trunc);
+
+        if (!ofs)
+        {
+            std::cerr << "Cannot create asset pack: " << tempFile << '\n';
+            return false;
+        }
+
+        const char zeros[s_AssetPackPageSize] = {};
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(AssetPackHeader));
+        ofs.write(zeros, header.tableOffset - sizeof(AssetPackHeader));
+        ofs.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(AssetPackEntry));
+        ofs.write(paths.data(), paths.size());
+
+        uint64_t written = header.pathsOffset + header.pathsSize;
+
+        for (std::size_t i = 0; i < files.size() && ofs; ++i)
+        {
+            ofs.write(zeros, table[i].offset - written);
+            written = table[i].offset;
+
+            if (table[i].size == 0)
+            {
+                continue;
+            }
+
+            MappedFile source;
+
+            if (!source.Open(files[i].sourceFile.string()) || source.GetSize() != table[i].size)
+            {
+                std::cerr << "File changed while packing: " << files[i].sourceFile.string() << '\n';
+                ofs.close();
+                std::filesystem::remove(tempFile, error);
+                return false;
+            }
+
+            ofs.write(reinterpret_cast<const char*>(source.GetData()), source.GetSize());
+            written += source.GetSize();
+
+            std::cout << "packed " << files[i].path << " (" << source.GetSize() << " bytes)\n";
+        }
+
+        if (!ofs)
+        {
+            std::cerr << "Couldn't write asset pack: " << tempFile << '\n';
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempFile, packFile, error);
+
+    if (error)
+    {
+        std::cerr << "Couldn't move asset pack in place: " << packFile << " (" << error.message() << ")\n";
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    std::cout << files.size() << " files packed in " << packFile << '\n';
+
+    return true;
+}
+
+END_VISUALIZER_NAMESPACE
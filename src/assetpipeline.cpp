@@ -0,0 +1,153 @@
+#include <assetpipeline.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+AssetPipeline::AssetPipeline(ThreadPool& threadPool)
+    : m_ThreadPool(threadPool)
+{}
+
+AssetPipeline::TaskID AssetPipeline::AddTask(const std::string& name, Queue queue, std::function<void()> work, std::initializer_list<TaskID> dependencies)
+{
+    if (m_Started)
+    {
+        std::cerr << "AssetPipeline: cannot add " << name << " once the pipeline is started\n";
+        return std::numeric_limits<TaskID>::max();
+    }
+
+    const TaskID id = static_cast<TaskID>(m_Tasks.size());
+
+    Task task;
+    task.name = name;
+    task.queue = queue;
+    task.work = std::move(work);
+
+    for (TaskID dependency : dependencies)
+    {
+        if (dependency < id)
+        {
+            m_Tasks[dependency].dependents.push_back(id);
+            ++task.remainingDependencies;
+        }
+    }
+
+    m_Tasks.push_back(std::move(task));
+
+    return id;
+}
+
+void AssetPipeline::Start()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Started = true;
+    m_StartTime = std::chrono::steady_clock::now();
+
+    for (TaskID id = 0; id < m_Tasks.size(); ++id)
+    {
+        if (m_Tasks[id].remainingDependencies == 0)
+        {
+            Schedule(id);
+        }
+    }
+}
+
+// Called with m_Mutex held
+void AssetPipeline::Schedule(TaskID id)
+{
+    if (m_Tasks[id].queue == Queue::Worker)
+    {
+        m_ThreadPool.Submit([this, id]() { Run(id); });
+    }
+    else
+    {
+        m_MainThreadTasks.push_back(id);
+        m_Condition.notify_all();
+    }
+}
+
+void AssetPipeline::Run(TaskID id)
+{
+    Task& task = m_Tasks[id];
+
+    // A failing task must not stall the tasks depending on it, they have to cope with missing data
+    try
+    {
+        if (!m_Cancelled)
+        {
+            task.work();
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << "Asset task " << task.name << " failed: " << exception.what() << '\n';
+    }
+
+    task.work = nullptr;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_StartTime;
+    std::cout << "asset task " << task.name << " done at " << elapsed.count() << " ms\n";
+
+    for (TaskID dependent : task.dependents)
+    {
+        if (--m_Tasks[dependent].remainingDependencies == 0)
+        {
+            Schedule(dependent);
+        }
+    }
+
+    ++m_CompletedTaskCount;
+    m_Condition.notify_all();
+}
+
+uint32_t AssetPipeline::ProcessMainThreadTasks(bool wait)
+{
+    uint32_t processedCount = 0;
+
+    while (true)
+    {
+        TaskID id;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            if (wait && processedCount == 0)
+            {
+                m_Condition.wait(lock, [this]() { return !m_MainThreadTasks.empty() || m_CompletedTaskCount == m_Tasks.size(); });
+            }
+
+            if (m_MainThreadTasks.empty())
+            {
+                return processedCount;
+            }
+
+            id = m_MainThreadTasks.front();
+            m_MainThreadTasks.pop_front();
+        }
+
+        Run(id);
+        ++processedCount;
+    }
+}
+
+void AssetPipeline::Finish()
+{
+    while (!IsComplete())
+    {
+        ProcessMainThreadTasks(true);
+    }
+}
+
+void AssetPipeline::Cancel()
+{
+    m_Cancelled = true;
+}
+
+bool AssetPipeline::IsComplete() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_CompletedTaskCount == m_Tasks.size();
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,93 @@
+#include <assetprefetch.hpp>
+#include <threadpool.hpp>
+#include <Windows.h>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Bytes touched by a single fallback task
+    constexpr std::size_t s_TouchChunkSize = 4 * 1024 * 1024;
+    constexpr std::size_t s_PageSize = 4096;
+
+    using PrefetchVirtualMemoryFunction = BOOL(WINAPI*)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+
+    // Only exported from Windows 8 on
+    PrefetchVirtualMemoryFunction GetPrefetchVirtualMemory()
+    {
+        static const PrefetchVirtualMemoryFunction function = reinterpret_cast<PrefetchVirtualMemoryFunction>(GetProcAddress(GetModuleHandle("kernel32.dll"), "PrefetchVirtualMemory"));
+        return function;
+    }
+
+    void TouchPages(const uint8_t* data, std::size_t size)
+    {
+        volatile uint32_t sink = 0;
+
+        for (std::size_t offset = 0; offset < size; offset += s_PageSize)
+        {
+            sink = sink + data[offset];
+        }
+    }
+}
+
+bool AssetPrefetch::Add(const std::string& path)
+{
+    AssetFile file;
+
+    if (!VirtualFileSystem::GetInstance().Open(path, file))
+    {
+        return false;
+    }
+
+    m_Size += file.GetSize();
+    m_Files.push_back(std::move(file));
+
+    return true;
+}
+
+void AssetPrefetch::Submit(ThreadPool& threadPool)
+{
+    if (m_Files.empty())
+    {
+        return;
+    }
+
+    if (const PrefetchVirtualMemoryFunction prefetchVirtualMemory = GetPrefetchVirtualMemory())
+    {
+        std::vector<WIN32_MEMORY_RANGE_ENTRY> ranges;
+        ranges.reserve(m_Files.size());
+
+        for (const AssetFile& file : m_Files)
+        {
+            ranges.push_back(WIN32_MEMORY_RANGE_ENTRY { const_cast<uint8_t*>(file.GetData()), file.GetSize() });
+        }
+
+        if (prefetchVirtualMemory(GetCurrentProcess(), ranges.size(), ranges.data(), 0))
+        {
+            return;
+        }
+
+        std::cerr << "Couldn't prefetch the assets, falling back to the thread pool\n";
+        DisplayLastWinAPIError();
+    }
+
+    //one task per chunk so that every worker reads a different part of the batch:
+    for (const AssetFile& file : m_Files)
+    {
+        for (std::size_t offset = 0; offset < file.GetSize(); offset += s_TouchChunkSize)
+        {
+            const uint8_t* data = file.GetData() + offset;
+            const std::size_t size = std::min(s_TouchChunkSize, file.GetSize() - offset);
+
+            threadPool.Submit([data, size]() { TouchPages(data, size); });
+        }
+    }
+}
+
+void AssetPrefetch::Release()
+{
+    m_Files.clear();
+    m_Size = 0;
+}
+
+END_VISUALIZER_NAMESPACE
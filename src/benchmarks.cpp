@@ -0,0 +1,239 @@
+#include <utils.hpp>
+#include <objparser.hpp>
+#include <mesh.hpp>
+#include <meshbuilder.hpp>
+#include <meshoptimizer.hpp>
+#include <meshlet.hpp>
+#include <meshimport.hpp>
+#include <benchmarks.hpp>
+#include <chrono>
+#include <cmath>
+
+#pragma warning(push, 0)
+#include <glm/gtc/matrix_transform.hpp>
+#pragma warning(pop, 0)
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_BenchmarkRunCount = 3;
+
+    template<typename Function>
+    float MeasureMilliseconds(Function&& function)
+    {
+        const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    float MaxDifference(const std::vector<tinyobj::real_t>& expected, const std::vector<float>& actual)
+    {
+        float difference = 0.0f;
+
+        for (std::size_t i = 0; i < std::min(expected.size(), actual.size()); ++i)
+        {
+            difference = std::max(difference, std::abs(expected[i] - actual[i]));
+        }
+
+        return difference;
+    }
+
+    void PrintVertexCacheStats(const char* stage, std::span<const uint32_t> indices, std::size_t vertexCount, float time)
+    {
+        std::cout << stage << ':';
+
+        for (const uint32_t cacheSize : { 16u, 32u })
+        {
+            const VertexCacheStats stats = AnalyzeVertexCache(indices, vertexCount, cacheSize);
+            std::cout << " ACMR" << cacheSize << ' ' << stats.acmr << ", ATVR" << cacheSize << ' ' << stats.atvr << ',';
+        }
+
+        std::cout << ' ' << time << " ms\n";
+    }
+
+    // Fraction of the meshlets rejected by cluster culling, averaged over cameras at the given positions looking at the given targets
+    void PrintMeshletCullStats(const char* poses, std::span<const Meshlet> meshlets, std::span<const glm::vec3> cameras, std::span<const glm::vec3> targets, float far)
+    {
+        //same projection as the default camera:
+        const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, far);
+        MeshletCullStats stats;
+        std::vector<uint32_t> visible;
+
+        for (std::size_t i = 0; i < cameras.size(); ++i)
+        {
+            const glm::vec3 direction = glm::normalize(targets[i] - cameras[i]);
+            const glm::vec3 up = std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            const Frustum frustum = Frustum::FromMatrix(projection * glm::lookAt(cameras[i], targets[i], up));
+            CullMeshlets(meshlets, frustum, cameras[i], glm::vec3(0.0f), visible, stats);
+        }
+
+        const float tested = static_cast<float>(std::max<uint64_t>(stats.tested, 1));
+        std::cout << poses << ": " << 100.0f * stats.GetRejected() / tested << "% of the meshlets culled ("
+                  << 100.0f * stats.outsideFrustum / tested << "% outside the frustum, " << 100.0f * stats.backfacing / tested << "% backfacing)\n";
+    }
+
+    bool SameIndex(const tinyobj::index_t& a, const tinyobj::index_t& b)
+    {
+        return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+    }
+}
+
+void RunObjParserBenchmark(const std::string& inputFile)
+{
+    std::cout << "OBJ parser benchmark: " << inputFile << '\n';
+
+    TinyObjMesh tinyObj;
+    const float tinyObjTime = MeasureMilliseconds([&]() { tinyObj = LoadObjFile(inputFile); });
+
+    std::vector<tinyobj::index_t> expectedIndices;
+    for (const tinyobj::shape_t& shape : tinyObj.shapes)
+    {
+        expectedIndices.insert(expectedIndices.end(), shape.mesh.indices.begin(), shape.mesh.indices.end());
+    }
+
+    std::cout << "tinyobj: " << tinyObjTime << " ms\n";
+
+    const uint32_t maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    float singleThreadTime = 0.0f;
+    ObjData obj;
+
+    for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreadCount))
+    {
+        float bestTime = std::numeric_limits<float>::max();
+
+        for (uint32_t run = 0; run < s_BenchmarkRunCount; ++run)
+        {
+            obj = ObjData();
+
+            bool parsed = false;
+            bestTime = std::min(bestTime, MeasureMilliseconds([&]() { parsed = ParseObjFile(inputFile, obj, threadCount); }));
+
+            if (!parsed)
+            {
+                std::cerr << "Parallel parser failed\n";
+                return;
+            }
+        }
+
+        if (threadCount == 1)
+        {
+            singleThreadTime = bestTime;
+        }
+
+        std::cout << "parallel parser, " << threadCount << " thread(s): " << bestTime << " ms"
+                  << " (x" << tinyObjTime / bestTime << " vs tinyobj, x" << singleThreadTime / bestTime << " vs 1 thread)\n";
+
+        if (threadCount == maxThreadCount)
+        {
+            break;
+        }
+    }
+
+    const tinyobj::attrib_t& attrib = tinyObj.attrib;
+
+    const bool sameCounts = attrib.vertices.size() == obj.vertices.size() &&
+                            attrib.normals.size() == obj.normals.size() &&
+                            attrib.texcoords.size() == obj.texcoords.size() &&
+                            expectedIndices.size() == obj.indices.size();
+
+    const bool sameIndices = sameCounts && std::equal(expectedIndices.begin(), expectedIndices.end(), obj.indices.begin(), SameIndex);
+
+    std::cout << "vertices: " << attrib.vertices.size() / 3 << " / " << obj.vertices.size() / 3
+              << ", normals: " << attrib.normals.size() / 3 << " / " << obj.normals.size() / 3
+              << ", texcoords: " << attrib.texcoords.size() / 2 << " / " << obj.texcoords.size() / 2
+              << ", indices: " << expectedIndices.size() << " / " << obj.indices.size() << '\n';
+    std::cout << "max difference, positions: " << MaxDifference(attrib.vertices, obj.vertices)
+              << ", normals: " << MaxDifference(attrib.normals, obj.normals)
+              << ", texcoords: " << MaxDifference(attrib.texcoords, obj.texcoords) << '\n';
+    std::cout << (sameIndices ? "indices match tinyobj\n" : "indices DIFFER from tinyobj\n");
+}
+
+void RunMeshOptimizationReport(const std::string& inputFile)
+{
+    std::cout << "Mesh optimization report: " << inputFile << '\n';
+
+    ObjData obj;
+    if (!ParseObjFile(inputFile, obj))
+    {
+        std::cerr << "Couldn't parse " << inputFile << '\n';
+        return;
+    }
+
+    WeldedMesh welded;
+    WeldVertices(obj.indices, WeldPosition | WeldNormal, obj.vertices.size() / 3, welded);
+
+    std::vector<glm::vec3> positions(welded.vertices.size());
+    std::vector<glm::vec3> normals(welded.vertices.size(), glm::vec3(0.0f));
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        const tinyobj::index_t& vertex = welded.vertices[i];
+        positions[i] = glm::vec3(obj.vertices[3 * vertex.vertex_index], obj.vertices[3 * vertex.vertex_index + 1], obj.vertices[3 * vertex.vertex_index + 2]);
+
+        if (vertex.normal_index >= 0)
+        {
+            normals[i] = glm::vec3(obj.normals[3 * vertex.normal_index], obj.normals[3 * vertex.normal_index + 1], obj.normals[3 * vertex.normal_index + 2]);
+        }
+    }
+
+    std::cout << "triangles: " << welded.indices.size() / 3 << ", vertices: " << welded.vertices.size() << '\n';
+
+    std::vector<uint32_t> indices = welded.indices;
+    PrintVertexCacheStats("source order", indices, positions.size(), 0.0f);
+
+    //the stages the import runs on every part, in its order, the whole mesh standing for a single part:
+    MeshImportSettings settings;
+    settings.optimize = true;
+    settings.meshlets = true;
+    settings.lodCount = s_MaxMeshLodCount;
+    MeshPartResult result;
+    ProcessMeshPart(indices, positions, normals, settings, result, [&positions](const char* stage, std::span<const uint32_t> stageIndices, float time) {
+        PrintVertexCacheStats(stage, stageIndices, positions.size(), time);
+    });
+    std::cout << "clusters: " << result.clusterCount << '\n';
+
+    //levels of detail as the palm import builds them, each one simplified from the full mesh:
+    for (uint32_t lod = 1; lod < result.lodIndices.size(); ++lod)
+    {
+        std::cout << "LOD " << lod << ": " << result.lodIndices[lod].size() / 3 << " triangles, error " << result.lodErrors[lod] << '\n';
+    }
+
+    //meshlets culled from a few typical viewpoints:
+    const std::vector<Meshlet>& meshlets = result.meshlets;
+
+    MeshBounds bounds;
+    for (const glm::vec3& position : positions)
+    {
+        bounds.Extend(position);
+    }
+    const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    const float radius = std::max(glm::length(bounds.max - bounds.min) * 0.5f, 1e-3f);
+    const std::size_t coneCount = std::count_if(meshlets.begin(), meshlets.end(), [](const Meshlet& meshlet) { return meshlet.coneCutoff < 1.0f; });
+    std::cout << "meshlets: " << meshlets.size() << ", " << (meshlets.empty() ? 0.0f : static_cast<float>(indices.size() / 3) / meshlets.size()) << " triangles per meshlet, "
+              << coneCount << " with a normal cone\n";
+
+    //around the mesh, all of it in view, from the horizon and from above, then from its centre looking along the horizon:
+    std::vector<glm::vec3> cameras, targets;
+    for (const float elevation : { 0.0f, 45.0f })
+    {
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            const float azimuth = glm::radians(45.0f * i);
+            cameras.push_back(center + 2.0f * radius * glm::vec3(std::cos(azimuth) * std::cos(glm::radians(elevation)), std::sin(glm::radians(elevation)), std::sin(azimuth) * std::cos(glm::radians(elevation))));
+            targets.push_back(center);
+        }
+    }
+    PrintMeshletCullStats("orbiting cameras", meshlets, cameras, targets, 4.0f * radius);
+    cameras.clear();
+    targets.clear();
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        const float azimuth = glm::radians(45.0f * i);
+        cameras.push_back(center);
+        targets.push_back(center + glm::vec3(std::cos(azimuth), 0.0f, std::sin(azimuth)));
+    }
+    PrintMeshletCullStats("cameras inside", meshlets, cameras, targets, 4.0f * radius);
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,264 @@
+#include <GL/glew.h>
+
+#include <cubemap.hpp>
+#include <glutils.hpp>
+#include <filesystem>
+#include <utility>
+
+#include "stb_image.hpp"
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_CubemapCacheMagic = 0x42554356; // "VCUB"
+    constexpr uint32_t s_CubemapCacheVersion = 1;
+    constexpr uint32_t s_CubemapCacheAlignment = 64;
+
+    struct CubemapCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t faceSize;
+        uint32_t channels;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t dataOffset;
+    };
+
+    // Position of every face in the horizontal cross, in face units
+    const std::array<glm::ivec2, CubemapImage::FaceCount> s_CrossLayout =
+    {
+        glm::ivec2(2, 1), // Right
+        glm::ivec2(0, 1), // Left
+        glm::ivec2(1, 0), // Up
+        glm::ivec2(1, 2), // Down
+        glm::ivec2(1, 1), // Front
+        glm::ivec2(3, 1)  // Back
+    };
+}
+
+CubemapImage::~CubemapImage()
+{
+    Release();
+}
+
+CubemapImage::CubemapImage(CubemapImage&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+CubemapImage& CubemapImage::operator=(CubemapImage&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+
+        m_DecodedPixels = std::exchange(other.m_DecodedPixels, nullptr);
+        m_Mapping = std::move(other.m_Mapping);
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_RowLength = other.m_RowLength;
+        m_FaceSize = other.m_FaceSize;
+        m_Channels = other.m_Channels;
+        m_FaceOffsets = other.m_FaceOffsets;
+    }
+
+    return *this;
+}
+
+void CubemapImage::Release()
+{
+    if (m_DecodedPixels)
+    {
+        stbi_image_free(m_DecodedPixels);
+        m_DecodedPixels = nullptr;
+    }
+
+    m_Mapping.Close();
+    m_Data = nullptr;
+}
+
+bool CubemapImage::FromCross(unsigned char* pixels, int width, int height, int channels, CubemapImage& image)
+{
+    image.Release();
+
+    if (!pixels)
+    {
+        return false;
+    }
+
+    image.m_DecodedPixels = pixels;
+
+    if (width / 4 != height / 3 || width % 4 != 0 || height % 3 != 0)
+    {
+        std::cerr << "Cube map cross must be 4 faces wide and 3 faces high, got " << width << " * " << height << '\n';
+        image.Release();
+        return false;
+    }
+
+    if (channels != 3 && channels != 4)
+    {
+        std::cerr << "Unsupported cube map channel count: " << channels << '\n';
+        image.Release();
+        return false;
+    }
+
+    image.m_Data = pixels;
+    image.m_RowLength = width;
+    image.m_FaceSize = width / 4;
+    image.m_Channels = channels;
+
+    for (int face = 0; face < FaceCount; ++face)
+    {
+        image.m_FaceOffsets[face] = s_CrossLayout[face] * image.m_FaceSize;
+    }
+
+    return true;
+}
+
+bool CubemapImage::LoadCache(const std::string& cacheFile, const FileStamp& sourceStamp, CubemapImage& image)
+{
+    //a packed copy out of date falls back to the loose one:
+    return VirtualFileSystem::GetInstance().OpenCompiled(cacheFile, [&](AssetFile& mapping) {
+        if (mapping.GetSize() < sizeof(CubemapCacheHeader))
+        {
+            return false;
+        }
+
+        CubemapCacheHeader header;
+        std::memcpy(&header, mapping.GetData(), sizeof(CubemapCacheHeader));
+
+        if (header.magic != s_CubemapCacheMagic ||
+            header.version != s_CubemapCacheVersion ||
+            header.sourceSize != sourceStamp.size ||
+            header.sourceWriteTime != sourceStamp.writeTime ||
+            (header.channels != 3 && header.channels != 4))
+        {
+            return false;
+        }
+
+        const uint64_t faceBytes = uint64_t(header.faceSize) * header.faceSize * header.channels;
+
+        if (header.dataOffset + faceBytes * FaceCount > mapping.GetSize())
+        {
+            std::cerr << "Truncated cube map cache: " << cacheFile << '\n';
+            return false;
+        }
+
+        image.Release();
+
+        image.m_Data = mapping.GetData() + header.dataOffset;
+        image.m_Mapping = std::move(mapping);
+        image.m_RowLength = static_cast<int>(header.faceSize);
+        image.m_FaceSize = static_cast<int>(header.faceSize);
+        image.m_Channels = static_cast<int>(header.channels);
+
+        // Faces are stacked vertically
+        for (int face = 0; face < FaceCount; ++face)
+        {
+            image.m_FaceOffsets[face] = glm::ivec2(0, face * image.m_FaceSize);
+        }
+
+        return true;
+    });
+}
+
+bool CubemapImage::WriteCache(const std::string& cacheFile, const FileStamp& sourceStamp) const
+{
+    if (!IsValid())
+    {
+        return false;
+    }
+
+    CubemapCacheHeader header = {};
+    header.magic = s_CubemapCacheMagic;
+    header.version = s_CubemapCacheVersion;
+    header.faceSize = static_cast<uint32_t>(m_FaceSize);
+    header.channels = static_cast<uint32_t>(m_Channels);
+    header.sourceSize = sourceStamp.size;
+    header.sourceWriteTime = sourceStamp.writeTime;
+    header.dataOffset = s_CubemapCacheAlignment;
+
+    static_assert(sizeof(CubemapCacheHeader) <= s_CubemapCacheAlignment);
+
+    const std::string outputFile = VirtualFileSystem::GetInstance().GetLoosePath(cacheFile);
+    const std::string tempFile = outputFile + ".tmp";
+
+    {
+        std::ofstream ofs(tempFile, std::ios::binary | std::ios::trunc);
+
+        if (!ofs)
+        {
+            std::cerr << "Cannot create cube map cache: " << tempFile << '\n';
+            return false;
+        }
+
+        const char zeros[s_CubemapCacheAlignment] = {};
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(CubemapCacheHeader));
+        ofs.write(zeros, header.dataOffset - sizeof(CubemapCacheHeader));
+
+        const std::size_t pixelSize = static_cast<std::size_t>(m_Channels);
+        const std::size_t rowBytes = m_FaceSize * pixelSize;
+
+        for (int face = 0; face < FaceCount; ++face)
+        {
+            for (int row = 0; row < m_FaceSize; ++row)
+            {
+                const std::size_t offset = ((m_FaceOffsets[face].y + row) * std::size_t(m_RowLength) + m_FaceOffsets[face].x) * pixelSize;
+                ofs.write(reinterpret_cast<const char*>(m_Data + offset), rowBytes);
+            }
+        }
+
+        if (!ofs)
+        {
+            std::cerr << "Couldn't write cube map cache: " << tempFile << '\n';
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFile, outputFile, error);
+
+    if (error)
+    {
+        std::cerr << "Couldn't move cube map cache in place: " << outputFile << " (" << error.message() << ")\n";
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    return true;
+}
+
+void CubemapImage::Upload() const
+{
+    if (!IsValid())
+    {
+        return;
+    }
+
+    const GLenum format = m_Channels == 4 ? GL_RGBA : GL_RGB;
+    const GLint internalFormat = m_Channels == 4 ? GL_RGBA8 : GL_RGB8;
+
+    GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+    GL_CALL(glPixelStorei, GL_UNPACK_ROW_LENGTH, m_RowLength);
+
+    for (int face = 0; face < FaceCount; ++face)
+    {
+        GL_CALL(glPixelStorei, GL_UNPACK_SKIP_PIXELS, m_FaceOffsets[face].x);
+        GL_CALL(glPixelStorei, GL_UNPACK_SKIP_ROWS, m_FaceOffsets[face].y);
+        GL_CALL(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, internalFormat, m_FaceSize, m_FaceSize, 0, format, GL_UNSIGNED_BYTE, m_Data);
+    }
+
+    GL_CALL(glPixelStorei, GL_UNPACK_SKIP_ROWS, 0);
+    GL_CALL(glPixelStorei, GL_UNPACK_SKIP_PIXELS, 0);
+    GL_CALL(glPixelStorei, GL_UNPACK_ROW_LENGTH, 0);
+    GL_CALL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+}
+
+std::string GetCubemapCachePath(const std::string& sourceFile)
+{
+    return sourceFile + ".vcube";
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,118 @@
+#include <GL/glew.h>
+
+#include <geometryarena.hpp>
+#include <glutils.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr GLbitfield s_ArenaStorageFlags = GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT;
+}
+
+GeometryArena::~GeometryArena()
+{
+    Destroy();
+}
+
+void GeometryArena::Create(const VertexLayout& layout, uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    Destroy();
+
+    m_Layout = layout;
+    m_VertexCapacity = vertexCapacity;
+    m_IndexCapacity = indexCapacity;
+
+    GL_CALL(glCreateBuffers, 1, &m_VertexBuffer);
+    GL_CALL(glCreateBuffers, 1, &m_IndexBuffer);
+    GL_CALL(glNamedBufferStorage, m_VertexBuffer, std::size_t(vertexCapacity) * layout.stride, nullptr, s_ArenaStorageFlags);
+    GL_CALL(glNamedBufferStorage, m_IndexBuffer, std::size_t(indexCapacity) * sizeof(uint16_t), nullptr, s_ArenaStorageFlags);
+}
+
+void GeometryArena::Destroy()
+{
+    if (!m_VertexBuffer)
+    {
+        return;
+    }
+
+    Unmap();
+
+    GL_CALL(glDeleteBuffers, 1, &m_VertexBuffer);
+    GL_CALL(glDeleteBuffers, 1, &m_IndexBuffer);
+
+    m_VertexBuffer = m_IndexBuffer = 0;
+    m_VertexCapacity = m_IndexCapacity = 0;
+    m_VertexCount = m_IndexCount = 0;
+}
+
+bool GeometryArena::Allocate(uint32_t vertexCount, uint32_t indexCount, Allocation& allocation)
+{
+    if (vertexCount > m_VertexCapacity - m_VertexCount || indexCount > m_IndexCapacity - m_IndexCount)
+    {
+        return false;
+    }
+
+    allocation.baseVertex = m_VertexCount;
+    allocation.firstIndex = m_IndexCount;
+    m_VertexCount += vertexCount;
+    m_IndexCount += indexCount;
+
+    return true;
+}
+
+bool GeometryArena::Map()
+{
+    if (m_MappedVertices)
+    {
+        return true;
+    }
+
+    constexpr GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+    void* vertices = GL_CALL(glMapNamedBufferRange, m_VertexBuffer, 0, std::size_t(m_VertexCapacity) * m_Layout.stride, access);
+    void* indices = GL_CALL(glMapNamedBufferRange, m_IndexBuffer, 0, std::size_t(m_IndexCapacity) * sizeof(uint16_t), access);
+
+    if (!vertices || !indices)
+    {
+        if (vertices)
+        {
+            GL_CALL(glUnmapNamedBuffer, m_VertexBuffer);
+        }
+        if (indices)
+        {
+            GL_CALL(glUnmapNamedBuffer, m_IndexBuffer);
+        }
+        return false;
+    }
+
+    m_MappedVertices = static_cast<std::byte*>(vertices);
+    m_MappedIndices = static_cast<uint16_t*>(indices);
+
+    return true;
+}
+
+void GeometryArena::Unmap()
+{
+    if (!m_MappedVertices)
+    {
+        return;
+    }
+
+    GL_CALL(glUnmapNamedBuffer, m_VertexBuffer);
+    GL_CALL(glUnmapNamedBuffer, m_IndexBuffer);
+
+    m_MappedVertices = nullptr;
+    m_MappedIndices = nullptr;
+}
+
+void GeometryArena::FlushVertices(uint32_t firstVertex, uint32_t vertexCount)
+{
+    GL_CALL(glFlushMappedNamedBufferRange, m_VertexBuffer, std::size_t(firstVertex) * m_Layout.stride, std::size_t(vertexCount) * m_Layout.stride);
+}
+
+void GeometryArena::FlushIndices(uint32_t firstIndex, uint32_t indexCount)
+{
+    GL_CALL(glFlushMappedNamedBufferRange, m_IndexBuffer, std::size_t(firstIndex) * sizeof(uint16_t), std::size_t(indexCount) * sizeof(uint16_t));
+}
+
+END_VISUALIZER_NAMESPACE
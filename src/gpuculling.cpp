@@ -0,0 +1,382 @@
+#include <GL/glew.h>
+
+#include <gpuculling.hpp>
+#include <glutils.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_GroupSize = 64;
+
+    // Elements are never read back, an empty array still gets a buffer so that every binding is valid
+    GLuint CreateBuffer(std::size_t size, const void* data)
+    {
+        GLuint buffer;
+        GL_CALL(glCreateBuffers, 1, &buffer);
+        GL_CALL(glNamedBufferStorage, buffer, std::max<std::size_t>(size, sizeof(uint32_t)), size > 0 ? data : nullptr, GL_DYNAMIC_STORAGE_BIT);
+        return buffer;
+    }
+
+    template<typename T>
+    GLuint CreateBuffer(const std::vector<T>& elements)
+    {
+        return CreateBuffer(elements.size() * sizeof(T), elements.data());
+    }
+
+    GLuint GetGroupCount(uint32_t invocationCount)
+    {
+        return (invocationCount + s_GroupSize - 1) / s_GroupSize;
+    }
+}
+
+const char* GpuCulling::GetShaderSource()
+{
+    return R"(#version 450 core
+
+layout(local_size_x = 64) in;
+
+layout(std140, binding = 0) uniform Matrix
+{
+    mat4 modelViewProjection;
+};
+
+// See PackedInstance, the scale and rotation as two pairs of half floats, the tint and the variant as four bytes
+struct PackedInstance
+{
+    float position[3];
+    uint scaleRotation[2];
+    uint tintSpecies;
+};
+
+// Level of detail of every instance as in Renderer::m_PalmLods, the draw it ends up in and its slot among the instances of that draw
+struct InstanceState
+{
+    uint lod;
+    uint draw;
+    uint slot;
+};
+
+layout(std430, binding = 0) readonly buffer Instances { PackedInstance instances[]; };
+layout(std430, binding = 1) buffer InstanceStates { InstanceState instanceStates[]; };
+// Instance count of every draw followed by where every draw starts in the culled instances
+layout(std430, binding = 2) buffer DrawCounts { uint drawCounts[]; };
+layout(std430, binding = 3) readonly buffer LodErrors { float lodErrors[]; };
+layout(std430, binding = 4) readonly buffer CommandDraws { uint commandDraws[]; };
+// Minimum then maximum corner of every tile
+layout(std430, binding = 5) readonly buffer TileBounds { vec4 tileBounds[]; };
+// DrawElementsIndirectCommand of the tiles and the palms, five each, then the DrawArraysIndirectCommand of the impostors
+layout(std430, binding = 6) buffer Commands { uint commands[]; };
+layout(std430, binding = 7) writeonly buffer CulledInstances { PackedInstance culledInstances[]; };
+
+// 0 culls the instances, 1 writes the commands, 2 scatters the instances
+uniform uint cullPass;
+uniform uint instanceCount;
+uniform uint tileCommandCount;
+uniform uint palmCommandCount;
+// Draws of the palm meshes, the impostors being the next one
+uniform uint drawCount;
+uniform uint lodsPerVariant;
+uniform vec3 cameraPosition;
+uniform vec3 palmCenter;
+uniform float palmRadius;
+uniform vec3 palmColor;
+uniform uint palmPositionDecode;
+uniform float pixelsPerUnit;
+uniform float lodThreshold;
+uniform float lodHysteresis;
+uniform float impostorDistance;
+
+// Same as s_ImpostorLod
+const uint impostorLod = 0xFF;
+const uint noDraw = 0xFFFFFFFF;
+
+vec4 planes[6];
+
+// Same planes as Frustum::FromMatrix
+void ExtractPlanes()
+{
+    const mat4 rows = transpose(modelViewProjection);
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; ++i)
+        planes[i] /= length(planes[i].xyz);
+}
+
+bool IntersectsBox(vec3 minCorner, vec3 maxCorner)
+{
+    for (int i = 0; i < 6; ++i) {
+        const vec3 corner = mix(minCorner, maxCorner, greaterThanEqual(planes[i].xyz, vec3(0.0)));
+        if (dot(planes[i].xyz, corner) + planes[i].w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+bool IntersectsSphere(vec3 center, float radius)
+{
+    for (int i = 0; i < 6; ++i) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius)
+            return false;
+    }
+    return true;
+}
+
+// Same rotation as the default shader
+mat3 RotationY(float angle)
+{
+    const float c = cos(angle);
+    const float s = sin(angle);
+    return mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+}
+
+// Same selection as Renderer::SelectPalmLods, then the same culling as Renderer::DrawPalmInstances
+void CullInstance(uint i)
+{
+    const PackedInstance instance = instances[i];
+    const vec3 position = vec3(instance.position[0], instance.position[1], instance.position[2]);
+    const vec2 scaleXY = unpackHalf2x16(instance.scaleRotation[0]);
+    const vec2 scaleZRotation = unpackHalf2x16(instance.scaleRotation[1]);
+    const vec3 scale = vec3(scaleXY, scaleZRotation.x);
+    const float maxScale = max(abs(scale.x), max(abs(scale.y), abs(scale.z)));
+    const uint firstLod = (instance.tintSpecies >> 24) * lodsPerVariant;
+    const float cameraDistance = max(distance(position, cameraPosition), 1e-3);
+
+    uint lod = instanceStates[i].lod;
+    uint draw = noDraw;
+    const float switchDistance = lod == impostorLod ? impostorDistance * (1.0 - lodHysteresis) : impostorDistance;
+    if (impostorDistance > 0.0 && cameraDistance > switchDistance) {
+        lod = impostorLod;
+        draw = drawCount;
+    }
+    else {
+        const uint lastLod = lodThreshold > 0.0 ? lodsPerVariant - 1 : 0;
+        lod = lod == impostorLod ? lastLod : min(lod, lastLod);
+        const float errorToPixels = pixelsPerUnit / cameraDistance * maxScale;
+        while (lod < lastLod && lodErrors[firstLod + lod + 1] * errorToPixels < lodThreshold * (1.0 - lodHysteresis))
+            ++lod;
+        while (lod > 0 && lodErrors[firstLod + lod] * errorToPixels > lodThreshold)
+            --lod;
+        if (IntersectsSphere(position + RotationY(scaleZRotation.y) * (palmCenter * scale), palmRadius * maxScale))
+            draw = firstLod + lod;
+    }
+
+    instanceStates[i].lod = lod;
+    instanceStates[i].draw = draw;
+    if (draw != noDraw)
+        instanceStates[i].slot = atomicAdd(drawCounts[draw], 1);
+}
+
+void WriteCommands(uint i)
+{
+    //the draws follow each other in the culled instances after the terrain instance:
+    if (i == 0) {
+        uint start = 1;
+        for (uint draw = 0; draw <= drawCount; ++draw) {
+            drawCounts[drawCount + 1 + draw] = start;
+            start += drawCounts[draw];
+        }
+        const uint impostorCommand = (tileCommandCount + palmCommandCount) * 5;
+        commands[impostorCommand + 1] = drawCounts[drawCount];
+        commands[impostorCommand + 3] = start - drawCounts[drawCount];
+    }
+    if (i < tileCommandCount)
+        commands[i * 5 + 1] = IntersectsBox(tileBounds[2 * i].xyz, tileBounds[2 * i + 1].xyz) ? 1 : 0;
+    if (i < palmCommandCount) {
+        //the starts above are not visible to the other invocations yet:
+        const uint draw = commandDraws[i];
+        uint start = 1;
+        for (uint previous = 0; previous < draw; ++previous)
+            start += drawCounts[previous];
+        const uint command = (tileCommandCount + i) * 5;
+        commands[command + 1] = drawCounts[draw];
+        commands[command + 4] = start;
+    }
+}
+
+void ScatterInstance(uint i)
+{
+    const InstanceState state = instanceStates[i];
+    if (state.draw == noDraw)
+        return;
+
+    //the meshes take their colour from the tints and their position decoding from the last byte like the recorded draws,
+    //the impostors keep both their colour and their variant:
+    PackedInstance instance = instances[i];
+    if (state.draw < drawCount) {
+        const vec4 tintSpecies = unpackUnorm4x8(instance.tintSpecies);
+        instance.tintSpecies = (packUnorm4x8(vec4(tintSpecies.rgb * palmColor, 0.0)) & 0x00FFFFFFu) | (palmPositionDecode << 24);
+    }
+    culledInstances[drawCounts[drawCount + 1 + state.draw] + state.slot] = instance;
+}
+
+void main()
+{
+    const uint i = gl_GlobalInvocationID.x;
+    ExtractPlanes();
+    if (cullPass == 0) {
+        if (i < instanceCount)
+            CullInstance(i);
+    }
+    else if (cullPass == 1)
+        WriteCommands(i);
+    else if (i < instanceCount)
+        ScatterInstance(i);
+})";
+}
+
+GpuCulling::~GpuCulling()
+{
+    Destroy();
+}
+
+bool GpuCulling::Create(GLuint program)
+{
+    Destroy();
+
+    if (!m_Program.Create(program))
+    {
+        return false;
+    }
+
+    m_Uniforms.cullPass = m_Program.GetUniform<uint32_t>("cullPass");
+    m_Uniforms.instanceCount = m_Program.GetUniform<uint32_t>("instanceCount");
+    m_Uniforms.tileCommandCount = m_Program.GetUniform<uint32_t>("tileCommandCount");
+    m_Uniforms.palmCommandCount = m_Program.GetUniform<uint32_t>("palmCommandCount");
+    m_Uniforms.drawCount = m_Program.GetUniform<uint32_t>("drawCount");
+    m_Uniforms.lodsPerVariant = m_Program.GetUniform<uint32_t>("lodsPerVariant");
+    m_Uniforms.cameraPosition = m_Program.GetUniform<glm::vec3>("cameraPosition");
+    m_Uniforms.palmCenter = m_Program.GetUniform<glm::vec3>("palmCenter");
+    m_Uniforms.palmRadius = m_Program.GetUniform<float>("palmRadius");
+    m_Uniforms.palmColor = m_Program.GetUniform<glm::vec3>("palmColor");
+    m_Uniforms.palmPositionDecode = m_Program.GetUniform<uint32_t>("palmPositionDecode");
+    m_Uniforms.pixelsPerUnit = m_Program.GetUniform<float>("pixelsPerUnit");
+    m_Uniforms.lodThreshold = m_Program.GetUniform<float>("lodThreshold");
+    m_Uniforms.lodHysteresis = m_Program.GetUniform<float>("lodHysteresis");
+    m_Uniforms.impostorDistance = m_Program.GetUniform<float>("impostorDistance");
+
+    //the buffers are bound by index, the blocks of the shader must sit at the same bindings:
+    if (m_Program.GetStorageBlockBinding("Commands") != CommandBuffer || m_Program.GetStorageBlockBinding("CulledInstances") != CulledInstanceBuffer)
+    {
+        std::cerr << "GPU culling: storage blocks not at the expected bindings" << std::endl;
+    }
+
+    return true;
+}
+
+void GpuCulling::Destroy()
+{
+    if (m_Buffers[0])
+    {
+        GL_CALL(glDeleteBuffers, BufferCount, m_Buffers);
+        std::fill(std::begin(m_Buffers), std::end(m_Buffers), 0);
+    }
+    m_Program.Destroy();
+
+    m_TileCommandCount = m_PalmCommandCount = m_InstanceCount = m_DrawCount = 0;
+}
+
+void GpuCulling::SetScene(const GpuCullingScene& scene)
+{
+    if (m_Buffers[0])
+    {
+        GL_CALL(glDeleteBuffers, BufferCount, m_Buffers);
+    }
+
+    m_TileCommandCount = static_cast<uint32_t>(scene.tileCommands.size());
+    m_PalmCommandCount = static_cast<uint32_t>(scene.palmCommands.size());
+    m_InstanceCount = static_cast<uint32_t>(scene.instances.size());
+    m_DrawCount = static_cast<uint32_t>(scene.lodErrors.size());
+
+    //what the scene is made of only changes with it:
+    m_Program.Set(m_Uniforms.instanceCount, m_InstanceCount);
+    m_Program.Set(m_Uniforms.tileCommandCount, m_TileCommandCount);
+    m_Program.Set(m_Uniforms.palmCommandCount, m_PalmCommandCount);
+    m_Program.Set(m_Uniforms.drawCount, m_DrawCount);
+    m_Program.Set(m_Uniforms.lodsPerVariant, scene.lodsPerVariant);
+    m_Program.Set(m_Uniforms.palmCenter, scene.palmCenter);
+    m_Program.Set(m_Uniforms.palmRadius, scene.palmRadius);
+    m_Program.Set(m_Uniforms.palmColor, scene.palmColor);
+    m_Program.Set(m_Uniforms.palmPositionDecode, scene.palmPositionDecode);
+
+    //the commands are written once, the pass only ever touches their instance counts and base instances:
+    std::vector<uint32_t> commands((m_TileCommandCount + m_PalmCommandCount) * 5 + 4, 0);
+    std::memcpy(commands.data(), scene.tileCommands.data(), scene.tileCommands.size() * sizeof(DrawElementsIndirectCommand));
+    std::memcpy(commands.data() + m_TileCommandCount * 5, scene.palmCommands.data(), scene.palmCommands.size() * sizeof(DrawElementsIndirectCommand));
+    commands[commands.size() - 4] = 4;
+
+    std::vector<glm::vec4> tileBounds;
+    tileBounds.reserve(scene.tileBounds.size() * 2);
+    for (const MeshBounds& bounds : scene.tileBounds)
+    {
+        tileBounds.push_back(glm::vec4(bounds.min, 1.0f));
+        tileBounds.push_back(glm::vec4(bounds.max, 1.0f));
+    }
+
+    m_Buffers[InstanceBuffer] = CreateBuffer(scene.instances);
+    m_Buffers[InstanceStateBuffer] = CreateBuffer(std::vector<uint32_t>(std::size_t(m_InstanceCount) * 3, 0));
+    m_Buffers[DrawCountBuffer] = CreateBuffer((m_DrawCount + 1) * 2 * sizeof(uint32_t), nullptr);
+    m_Buffers[LodErrorBuffer] = CreateBuffer(scene.lodErrors);
+    m_Buffers[CommandDrawBuffer] = CreateBuffer(scene.palmCommandDraws);
+    m_Buffers[TileBoundsBuffer] = CreateBuffer(tileBounds);
+    m_Buffers[CommandBuffer] = CreateBuffer(commands);
+
+    //the terrain commands all read the first instance, the pass writes the palms after it:
+    m_Buffers[CulledInstanceBuffer] = CreateBuffer((1 + std::size_t(m_InstanceCount)) * sizeof(PackedInstance), nullptr);
+    GL_CALL(glNamedBufferSubData, m_Buffers[CulledInstanceBuffer], 0, sizeof(PackedInstance), &scene.terrainInstance);
+}
+
+void GpuCulling::Dispatch(const GpuCullingParameters& parameters)
+{
+    if (!m_Program.GetID() || !m_Buffers[0])
+    {
+        return;
+    }
+
+    m_Program.Use();
+    m_Program.Set(m_Uniforms.cameraPosition, parameters.cameraPosition);
+    m_Program.Set(m_Uniforms.pixelsPerUnit, parameters.pixelsPerUnit);
+    m_Program.Set(m_Uniforms.lodThreshold, parameters.lodThreshold);
+    m_Program.Set(m_Uniforms.lodHysteresis, parameters.lodHysteresis);
+    m_Program.Set(m_Uniforms.impostorDistance, parameters.impostorDistance);
+
+    for (uint32_t buffer = 0; buffer < BufferCount; ++buffer)
+    {
+        GL_CALL(glBindBufferBase, GL_SHADER_STORAGE_BUFFER, buffer, m_Buffers[buffer]);
+    }
+
+    //the counts start over every frame, the levels of detail are kept for the hysteresis:
+    GL_CALL(glClearNamedBufferData, m_Buffers[DrawCountBuffer], GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    if (m_InstanceCount > 0)
+    {
+        m_Program.Set(m_Uniforms.cullPass, 0u);
+        GL_CALL(glDispatchCompute, GetGroupCount(m_InstanceCount), 1, 1);
+        GL_CALL(glMemoryBarrier, GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    m_Program.Set(m_Uniforms.cullPass, 1u);
+    GL_CALL(glDispatchCompute, GetGroupCount(std::max({ m_TileCommandCount, m_PalmCommandCount, 1u })), 1, 1);
+    GL_CALL(glMemoryBarrier, GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (m_InstanceCount > 0)
+    {
+        m_Program.Set(m_Uniforms.cullPass, 2u);
+        GL_CALL(glDispatchCompute, GetGroupCount(m_InstanceCount), 1, 1);
+    }
+
+    //the draws read the commands and the culled instances as soon as the pass is done:
+    GL_CALL(glMemoryBarrier, GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    for (uint32_t buffer = 0; buffer < BufferCount; ++buffer)
+    {
+        GL_CALL(glBindBufferBase, GL_SHADER_STORAGE_BUFFER, buffer, 0);
+    }
+    GL_CALL(glUseProgram, 0);
+}
+
+END_VISUALIZER_NAMESPACE
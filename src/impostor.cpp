@@ -0,0 +1,233 @@
+#include <GL/glew.h>
+
+#include <impostor.hpp>
+#include <glutils.hpp>
+#include <filesystem>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_ImpostorCacheMagic = 0x504D4956; // "VIMP"
+    constexpr uint32_t s_ImpostorCacheVersion = 3;
+    constexpr uint32_t s_ImpostorCacheAlignment = 128;
+    // Colour mipmaps down to frames of 8 pixels, smaller ones would bleed between neighbouring frames
+    constexpr uint32_t s_MaxImpostorMipLevels = 5;
+
+    struct ImpostorCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t framesPerSide;
+        uint32_t frameSize;
+        uint32_t layerCount;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t settingsHash;
+        glm::vec3 center;
+        float radius;
+        // Colour atlases of every layer followed by the depth atlases
+        uint64_t dataOffset;
+    };
+
+    GLsizei GetMipLevelCount(uint32_t frameSize)
+    {
+        GLsizei levels = 1;
+
+        while ((frameSize >> levels) > 0 && levels < GLsizei(s_MaxImpostorMipLevels))
+        {
+            ++levels;
+        }
+
+        return levels;
+    }
+}
+
+void ImpostorAtlas::AllocateTextures(GLuint colorTexture, GLuint depthTexture, const ImpostorSettings& settings, uint32_t layerCount)
+{
+    const GLsizei size = static_cast<GLsizei>(settings.GetAtlasSize());
+
+    GL_CALL(glTextureStorage3D, colorTexture, GetMipLevelCount(settings.frameSize), GL_RGBA8, size, size, static_cast<GLsizei>(layerCount));
+    GL_CALL(glTextureParameteri, colorTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    GL_CALL(glTextureParameteri, colorTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GL_CALL(glTextureParameteri, colorTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    GL_CALL(glTextureParameteri, colorTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Depths are not interpolated across the silhouettes
+    GL_CALL(glTextureStorage3D, depthTexture, 1, GL_DEPTH_COMPONENT16, size, size, static_cast<GLsizei>(layerCount));
+    GL_CALL(glTextureParameteri, depthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    GL_CALL(glTextureParameteri, depthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    GL_CALL(glTextureParameteri, depthTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    GL_CALL(glTextureParameteri, depthTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GL_CALL(glTextureParameteri, depthTexture, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+}
+
+ImpostorAtlas ImpostorAtlas::FromTextures(GLuint colorTexture, GLuint depthTexture, const ImpostorSettings& settings, uint32_t layerCount, const glm::vec3& center, float radius)
+{
+    const std::size_t pixelCount = std::size_t(settings.GetAtlasSize()) * settings.GetAtlasSize() * layerCount;
+
+    ImpostorAtlas atlas;
+    atlas.m_Pixels.resize(pixelCount * (4 + sizeof(uint16_t)));
+    atlas.m_Settings = settings;
+    atlas.m_LayerCount = layerCount;
+    atlas.m_Center = center;
+    atlas.m_Radius = radius;
+
+    uint8_t* color = atlas.m_Pixels.data();
+    uint8_t* depth = color + pixelCount * 4;
+
+    GL_CALL(glGetTextureImage, colorTexture, 0, GL_RGBA, GL_UNSIGNED_BYTE, static_cast<GLsizei>(pixelCount * 4), color);
+    GL_CALL(glGetTextureImage, depthTexture, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, static_cast<GLsizei>(pixelCount * sizeof(uint16_t)), depth);
+
+    atlas.m_Color = color;
+    atlas.m_Depth = reinterpret_cast<const uint16_t*>(depth);
+
+    return atlas;
+}
+
+bool ImpostorAtlas::LoadCache(const std::string& cacheFile, const FileStamp& sourceStamp, uint64_t settingsHash, const ImpostorSettings& settings, ImpostorAtlas& atlas)
+{
+    //a packed copy out of date falls back to the loose one:
+    return VirtualFileSystem::GetInstance().OpenCompiled(cacheFile, [&](AssetFile& mapping) {
+        if (mapping.GetSize() < sizeof(ImpostorCacheHeader))
+        {
+            return false;
+        }
+
+        ImpostorCacheHeader header;
+        std::memcpy(&header, mapping.GetData(), sizeof(ImpostorCacheHeader));
+
+        if (header.magic != s_ImpostorCacheMagic ||
+            header.version != s_ImpostorCacheVersion ||
+            header.framesPerSide != settings.framesPerSide ||
+            header.frameSize != settings.frameSize ||
+            header.layerCount == 0 ||
+            header.sourceSize != sourceStamp.size ||
+            header.sourceWriteTime != sourceStamp.writeTime ||
+            header.settingsHash != settingsHash)
+        {
+            return false;
+        }
+
+        const uint64_t pixelCount = uint64_t(settings.GetAtlasSize()) * settings.GetAtlasSize() * header.layerCount;
+
+        if (header.dataOffset + pixelCount * (4 + sizeof(uint16_t)) > mapping.GetSize())
+        {
+            std::cerr << "Truncated impostor cache: " << cacheFile << '\n';
+            return false;
+        }
+
+        atlas = ImpostorAtlas();
+        atlas.m_Color = mapping.GetData() + header.dataOffset;
+        atlas.m_Depth = reinterpret_cast<const uint16_t*>(atlas.m_Color + pixelCount * 4);
+        atlas.m_Mapping = std::move(mapping);
+        atlas.m_Settings = settings;
+        atlas.m_LayerCount = header.layerCount;
+        atlas.m_Center = header.center;
+        atlas.m_Radius = header.radius;
+
+        return true;
+    });
+}
+
+bool ImpostorAtlas::WriteCache(const std::string& cacheFile, const FileStamp& sourceStamp, uint64_t settingsHash) const
+{
+    if (!IsValid())
+    {
+        return false;
+    }
+
+    ImpostorCacheHeader header = {};
+    header.magic = s_ImpostorCacheMagic;
+    header.version = s_ImpostorCacheVersion;
+    header.framesPerSide = m_Settings.framesPerSide;
+    header.frameSize = m_Settings.frameSize;
+    header.layerCount = m_LayerCount;
+    header.sourceSize = sourceStamp.size;
+    header.sourceWriteTime = sourceStamp.writeTime;
+    header.settingsHash = settingsHash;
+    header.center = m_Center;
+    header.radius = m_Radius;
+    header.dataOffset = s_ImpostorCacheAlignment;
+
+    static_assert(sizeof(ImpostorCacheHeader) <= s_ImpostorCacheAlignment);
+
+    const std::string outputFile = VirtualFileSystem::GetInstance().GetLoosePath(cacheFile);
+    const std::string tempFile = outputFile + ".tmp";
+    const std::size_t pixelCount = std::size_t(m_Settings.GetAtlasSize()) * m_Settings.GetAtlasSize() * m_LayerCount;
+
+    {
+        std::ofstream ofs(tempFile, std::ios::binary | std::ios::trunc);
+
+        if (!ofs)
+        {
+            std::cerr << "Cannot create impostor cache: " << tempFile << '\n';
+            return false;
+        }
+
+        const char zeros[s_ImpostorCacheAlignment] = {};
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(ImpostorCacheHeader));
+        ofs.write(zeros, header.dataOffset - sizeof(ImpostorCacheHeader));
+        ofs.write(reinterpret_cast<const char*>(m_Color), pixelCount * 4);
+        ofs.write(reinterpret_cast<const char*>(m_Depth), pixelCount * sizeof(uint16_t));
+
+        if (!ofs)
+        {
+            std::cerr << "Couldn't write impostor cache: " << tempFile << '\n';
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFile, outputFile, error);
+
+    if (error)
+    {
+        std::cerr << "Couldn't move impostor cache in place: " << outputFile << " (" << error.message() << ")\n";
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    return true;
+}
+
+void ImpostorAtlas::Upload(GLuint colorTexture, GLuint depthTexture) const
+{
+    if (!IsValid())
+    {
+        return;
+    }
+
+    const GLsizei size = static_cast<GLsizei>(m_Settings.GetAtlasSize());
+
+    const GLsizei layerCount = static_cast<GLsizei>(m_LayerCount);
+
+    AllocateTextures(colorTexture, depthTexture, m_Settings, m_LayerCount);
+
+    GL_CALL(glTextureSubImage3D, colorTexture, 0, 0, 0, 0, size, size, layerCount, GL_RGBA, GL_UNSIGNED_BYTE, m_Color);
+    GL_CALL(glGenerateTextureMipmap, colorTexture);
+    GL_CALL(glTextureSubImage3D, depthTexture, 0, 0, 0, 0, size, size, layerCount, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, m_Depth);
+}
+
+glm::vec3 DecodeImpostorDirection(const glm::vec2& coords)
+{
+    const glm::vec2 e = coords * 2.0f - 1.0f;
+    const glm::vec2 p = glm::vec2(e.x + e.y, e.x - e.y) * 0.5f;
+
+    return glm::normalize(glm::vec3(p.x, 1.0f - glm::abs(p.x) - glm::abs(p.y), p.y));
+}
+
+void GetImpostorViewBasis(const glm::vec3& direction, glm::vec3& right, glm::vec3& up)
+{
+    // The view straight from above has no horizontal direction to start from
+    right = glm::abs(direction.y) > 0.999f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), direction));
+    up = glm::cross(direction, right);
+}
+
+std::string GetImpostorCachePath(const std::string& sourceFile)
+{
+    return sourceFile + ".vimpostor";
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,234 @@
+#include <instancefile.hpp>
+#include <filesystem>
+
+#pragma warning(push, 0)
+#include <glm/gtc/packing.hpp>
+#pragma warning(pop, 0)
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_InstanceFileMagic = 0x54534E56; // "VNST"
+    constexpr uint32_t s_InstanceFileVersion = 3;
+    constexpr uint64_t s_InstanceFileAlignment = 64;
+
+    enum InstanceStream : uint32_t
+    {
+        PositionStream,
+        RotationStream,
+        ScaleStream,
+        TintStream,
+        SpeciesStream,
+        StreamCount
+    };
+
+    constexpr uint32_t s_StreamStrides[StreamCount] = { sizeof(glm::vec3), sizeof(float), sizeof(glm::vec3), sizeof(glm::vec3), sizeof(uint32_t) };
+
+    struct InstanceFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;
+        uint32_t streamStrides[StreamCount];
+        uint64_t streamOffsets[StreamCount];
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+    };
+
+    constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    template<typename T>
+    inline std::span<const T> GetStream(const uint8_t* data, const InstanceFileHeader& header, InstanceStream stream)
+    {
+        return std::span<const T>(reinterpret_cast<const T*>(data + header.streamOffsets[stream]), header.count);
+    }
+
+    inline uint8_t PackUnorm8(float value)
+    {
+        return static_cast<uint8_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+    }
+}
+
+void InstanceArrays::Resize(std::size_t count)
+{
+    positions.resize(count);
+    rotations.resize(count);
+    scales.resize(count);
+    tints.resize(count);
+    species.resize(count);
+}
+
+InstanceData InstanceData::FromBuffer(InstanceArrays&& instances)
+{
+    InstanceData data;
+
+    data.m_Instances = std::move(instances);
+    data.m_Streams.positions = data.m_Instances.positions;
+    data.m_Streams.rotations = data.m_Instances.rotations;
+    data.m_Streams.scales = data.m_Instances.scales;
+    data.m_Streams.tints = data.m_Instances.tints;
+    data.m_Streams.species = data.m_Instances.species;
+
+    return data;
+}
+
+InstanceData InstanceData::FromMapping(AssetFile&& mapping, const InstanceStreams& instances)
+{
+    InstanceData data;
+
+    data.m_Mapping = std::move(mapping);
+    data.m_Streams = instances;
+
+    return data;
+}
+
+PackedInstance PackInstance(const glm::vec3& position, float rotation, const glm::vec3& scale, const glm::vec3& tint, uint32_t species)
+{
+    PackedInstance packed;
+    packed.position = position;
+    packed.scaleRotation[0] = glm::packHalf1x16(scale.x);
+    packed.scaleRotation[1] = glm::packHalf1x16(scale.y);
+    packed.scaleRotation[2] = glm::packHalf1x16(scale.z);
+    packed.scaleRotation[3] = glm::packHalf1x16(rotation);
+    packed.tintSpecies[0] = PackUnorm8(tint.r);
+    packed.tintSpecies[1] = PackUnorm8(tint.g);
+    packed.tintSpecies[2] = PackUnorm8(tint.b);
+    packed.tintSpecies[3] = static_cast<uint8_t>(std::min(species, 255u));
+
+    return packed;
+}
+
+PackedInstance PackInstance(const InstanceStreams& instances, std::size_t index, const glm::vec3& color)
+{
+    return PackInstance(instances.positions[index], instances.rotations[index], instances.scales[index], instances.tints[index] * color, instances.species[index]);
+}
+
+std::string GetInstanceFilePath(const std::string& sourceFile)
+{
+    return sourceFile + ".vinst";
+}
+
+bool LoadInstanceFile(const std::string& instanceFile, InstanceData& instances, const FileStamp* sourceStamp)
+{
+    //a packed copy out of date falls back to the loose one:
+    return VirtualFileSystem::GetInstance().OpenCompiled(instanceFile, [&](AssetFile& mapping) {
+        if (mapping.GetSize() < sizeof(InstanceFileHeader))
+        {
+            return false;
+        }
+
+        InstanceFileHeader header;
+        std::memcpy(&header, mapping.GetData(), sizeof(InstanceFileHeader));
+
+        if (header.magic != s_InstanceFileMagic || header.version != s_InstanceFileVersion || !std::equal(header.streamStrides, header.streamStrides + StreamCount, s_StreamStrides))
+        {
+            return false;
+        }
+
+        if (sourceStamp && (header.sourceSize != sourceStamp->size || header.sourceWriteTime != sourceStamp->writeTime))
+        {
+            return false;
+        }
+
+        for (uint32_t stream = 0; stream < StreamCount; ++stream)
+        {
+            if (header.streamOffsets[stream] % s_InstanceFileAlignment != 0 || header.streamOffsets[stream] + header.count * s_StreamStrides[stream] > mapping.GetSize())
+            {
+                std::cerr << "Invalid instance file: " << instanceFile << '\n';
+                return false;
+            }
+        }
+
+        const uint8_t* data = mapping.GetData();
+
+        InstanceStreams streams;
+        streams.positions = GetStream<glm::vec3>(data, header, PositionStream);
+        streams.rotations = GetStream<float>(data, header, RotationStream);
+        streams.scales = GetStream<glm::vec3>(data, header, ScaleStream);
+        streams.tints = GetStream<glm::vec3>(data, header, TintStream);
+        streams.species = GetStream<uint32_t>(data, header, SpeciesStream);
+
+        instances = InstanceData::FromMapping(std::move(mapping), streams);
+
+        return true;
+    });
+}
+
+bool WriteInstanceFile(const std::string& instanceFile, const InstanceStreams& instances, const FileStamp* sourceStamp)
+{
+    const std::span<const std::byte> streams[StreamCount] = {
+        std::as_bytes(instances.positions),
+        std::as_bytes(instances.rotations),
+        std::as_bytes(instances.scales),
+        std::as_bytes(instances.tints),
+        std::as_bytes(instances.species)
+    };
+
+    InstanceFileHeader header = {};
+    header.magic = s_InstanceFileMagic;
+    header.version = s_InstanceFileVersion;
+    header.count = instances.GetCount();
+    std::copy(s_StreamStrides, s_StreamStrides + StreamCount, header.streamStrides);
+
+    //every stream starts on its own aligned offset:
+    uint64_t offset = AlignUp(sizeof(InstanceFileHeader), s_InstanceFileAlignment);
+
+    for (uint32_t stream = 0; stream < StreamCount; ++stream)
+    {
+        header.streamOffsets[stream] = offset;
+        offset = AlignUp(offset + streams[stream].size(), s_InstanceFileAlignment);
+    }
+
+    if (sourceStamp)
+    {
+        header.sourceSize = sourceStamp->size;
+        header.sourceWriteTime = sourceStamp->writeTime;
+    }
+
+    const std::string outputFile = VirtualFileSystem::GetInstance().GetLoosePath(instanceFile);
+    const std::string tempFile = outputFile + ".tmp";
+
+    {
+        std::ofstream ofs(tempFile, std::ios::binary | std::ios::trunc);
+
+        if (!ofs)
+        {
+            std::cerr << "Cannot create instance file: " << tempFile << '\n';
+            return false;
+        }
+
+        const char zeros[s_InstanceFileAlignment] = {};
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(InstanceFileHeader));
+
+        for (uint32_t stream = 0; stream < StreamCount; ++stream)
+        {
+            ofs.write(zeros, header.streamOffsets[stream] - (stream == 0 ? sizeof(InstanceFileHeader) : header.streamOffsets[stream - 1] + streams[stream - 1].size()));
+            ofs.write(reinterpret_cast<const char*>(streams[stream].data()), streams[stream].size());
+        }
+
+        if (!ofs)
+        {
+            std::cerr << "Couldn't write instance file: " << tempFile << '\n';
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFile, outputFile, error);
+
+    if (error)
+    {
+        std::cerr << "Couldn't move instance file in place: " << outputFile << " (" << error.message() << ")\n";
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    return true;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -2,6 +2,8 @@
 #include <cxxopts.hpp>
 
 #include <window.hpp>
+#include <benchmarks.hpp>
+#include <virtualfilesystem.hpp>
 
 int32_t main(int32_t argc, char** argv)
 {
@@ -9,6 +11,28 @@ int32_t main(int32_t argc, char** argv)
 
     options.add_options()
         ("d,debug", "Enables OpenGL debugging mode", cxxopts::value<bool>()->default_value("false"))
+        ("skybox-cache", "Keeps the decoded skybox faces in a raw cache next to the source image", cxxopts::value<bool>()->default_value("true"))
+        ("quantize-meshes", "Stores the mesh caches with quantized vertices and compressed indices", cxxopts::value<bool>()->default_value("false"))
+        ("optimize-meshes", "Reorders the imported meshes for the vertex cache, overdraw and vertex fetch", cxxopts::value<bool>()->default_value("true"))
+        ("progressive-loading", "Renders the skybox and a coarse terrain right away then streams the other assets in", cxxopts::value<bool>()->default_value("true"))
+        ("upload-budget", "Bytes uploaded to the GPU per frame while assets stream in, 0 for no limit", cxxopts::value<uint64_t>()->default_value("16777216"))
+        ("prefetch-assets", "Requests every startup asset from the disk in a single batch before loading them", cxxopts::value<bool>()->default_value("true"))
+        ("direct-upload", "Writes the meshes straight into mapped GPU buffers, without any CPU copy", cxxopts::value<bool>()->default_value("false"))
+        ("lod-threshold", "Largest error on screen, in pixels, of the palm levels of detail, 0 always draws the full meshes", cxxopts::value<float>()->default_value("1"))
+        ("cluster-culling", "Splits the meshes into meshlets at import and culls each one against the view", cxxopts::value<bool>()->default_value("true"))
+        ("terrain-tiles", "Sorts the terrain into a grid of N x N tiles culled against the view, 0 keeps it whole", cxxopts::value<uint32_t>()->default_value("16"))
+        ("pack-vertices", "Stores the mesh vertices with 16 bit positions and octahedral normals instead of floats", cxxopts::value<bool>()->default_value("true"))
+        ("procedural-palms", "Generates the palms at startup instead of importing palm.obj", cxxopts::value<bool>()->default_value("true"))
+        ("palm-variants", "Number of generated palm variants the instances cycle through", cxxopts::value<uint32_t>()->default_value("4"))
+        ("instanced-palms", "Draws the palm meshes with one instanced call per variant and level of detail instead of one call per palm", cxxopts::value<bool>()->default_value("true"))
+        ("multi-draw", "Draws the static meshes from a single vertex and index arena with one multi-draw indirect call", cxxopts::value<bool>()->default_value("true"))
+        ("gpu-culling", "Culls the terrain tiles and palms and selects the palm levels of detail in a compute shader writing the multi-draw commands", cxxopts::value<bool>()->default_value("true"))
+        ("impostor-distance", "Distance from which palms are drawn as a single textured quad, 0 always draws their meshes", cxxopts::value<float>()->default_value("150"))
+        ("res", "Directory the assets are loaded from when they are not in the asset pack", cxxopts::value<std::string>()->default_value("../../res/"))
+        ("pack", "Asset pack mounted before the resource directory", cxxopts::value<std::string>()->default_value("../../res/assets.vpak"))
+        ("build-pack", "Packs every file of the resource directory in the asset pack then exits", cxxopts::value<bool>()->default_value("false"))
+        ("benchmark-obj", "Compares the parallel OBJ parser with tinyobj on the given file then exits", cxxopts::value<std::string>())
+        ("analyze-mesh", "Reports the vertex cache efficiency of the given OBJ file before and after each optimization, its levels of detail and how many of its meshlets get culled then exits", cxxopts::value<std::string>())
         ("h,help", "Print usage")
         ;
 
@@ -20,6 +44,31 @@ int32_t main(int32_t argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    if (commandLineOptions.count("benchmark-obj"))
+    {
+        visualizer::RunObjParserBenchmark(commandLineOptions["benchmark-obj"].as<std::string>());
+        return EXIT_SUCCESS;
+    }
+
+    if (commandLineOptions.count("analyze-mesh"))
+    {
+        visualizer::RunMeshOptimizationReport(commandLineOptions["analyze-mesh"].as<std::string>());
+        return EXIT_SUCCESS;
+    }
+
+    const std::string resourceDirectory = commandLineOptions["res"].as<std::string>();
+    const std::string packFile = commandLineOptions["pack"].as<std::string>();
+
+    if (commandLineOptions["build-pack"].as<bool>())
+    {
+        return visualizer::BuildAssetPack(resourceDirectory, packFile) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    //every asset path is relative to the resource directory, the pack is optional:
+    visualizer::VirtualFileSystem& fileSystem = visualizer::VirtualFileSystem::GetInstance();
+    fileSystem.SetResourceDirectory(resourceDirectory);
+    fileSystem.MountPack(packFile);
+
     auto &window = visualizer::Window::GetInstance();
 
     if (!window.InitWindow("OpenGL forest - 3D Programming Course", 1280, 720, commandLineOptions))
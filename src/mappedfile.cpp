@@ -0,0 +1,111 @@
+#include <mappedfile.hpp>
+#include <utils.hpp>
+#include <Windows.h>
+#include <utility>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+MappedFile::MappedFile(const std::string& fileName)
+{
+    Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_FileHandle(std::exchange(other.m_FileHandle, nullptr))
+    , m_MappingHandle(std::exchange(other.m_MappingHandle, nullptr))
+    , m_Data(std::exchange(other.m_Data, nullptr))
+    , m_Size(std::exchange(other.m_Size, 0))
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+
+        m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+        m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& fileName)
+{
+    Close();
+
+    HANDLE file = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mapping)
+    {
+        std::cerr << "Couldn't create file mapping: " << fileName << '\n';
+        DisplayLastWinAPIError();
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (!data)
+    {
+        std::cerr << "Couldn't map view of file: " << fileName << '\n';
+        DisplayLastWinAPIError();
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_FileHandle = file;
+    m_MappingHandle = mapping;
+    m_Data = static_cast<const uint8_t*>(data);
+    m_Size = static_cast<std::size_t>(fileSize.QuadPart);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+    {
+        UnmapViewOfFile(m_Data);
+        m_Data = nullptr;
+    }
+
+    if (m_MappingHandle)
+    {
+        CloseHandle(m_MappingHandle);
+        m_MappingHandle = nullptr;
+    }
+
+    if (m_FileHandle)
+    {
+        CloseHandle(m_FileHandle);
+        m_FileHandle = nullptr;
+    }
+
+    m_Size = 0;
+}
+
+END_VISUALIZER_NAMESPACE
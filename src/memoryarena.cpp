@@ -0,0 +1,69 @@
+#include <memoryarena.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Blocks allocated when the reservation runs out
+    constexpr std::size_t s_MinBlockSize = 1024 * 1024;
+}
+
+MemoryArena::MemoryArena(std::size_t capacity)
+{
+    Reserve(capacity);
+}
+
+void MemoryArena::Reserve(std::size_t capacity)
+{
+    if (capacity == 0 || (!m_Blocks.empty() && m_Blocks.back().size - m_Blocks.back().used >= capacity))
+    {
+        return;
+    }
+
+    Block block;
+    block.data = std::make_unique_for_overwrite<std::byte[]>(capacity);
+    block.size = capacity;
+
+    m_Capacity += capacity;
+    m_Blocks.push_back(std::move(block));
+}
+
+void MemoryArena::Release()
+{
+    m_Blocks.clear();
+    m_UsedSize = 0;
+    m_Capacity = 0;
+}
+
+void* MemoryArena::Allocate(std::size_t size, std::size_t alignment)
+{
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (!m_Blocks.empty())
+        {
+            Block& block = m_Blocks.back();
+
+            const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            const uintptr_t aligned = (base + block.used + alignment - 1) & ~uintptr_t(alignment - 1);
+            const std::size_t end = static_cast<std::size_t>(aligned - base) + size;
+
+            if (end <= block.size)
+            {
+                m_UsedSize += end - block.used;
+                block.used = end;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+
+        Reserve(std::max(size + alignment - 1, s_MinBlockSize));
+    }
+
+    return nullptr;
+}
+
+END_VISUALIZER_NAMESPACE
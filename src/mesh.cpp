@@ -0,0 +1,141 @@
+#include <mesh.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+MeshData MeshData::FromBuffers(std::vector<VertexDataPosition3fNormal3fColor3f>&& vertices, std::vector<uint32_t>&& indices)
+{
+    MeshData mesh;
+
+    mesh.m_Vertices = std::move(vertices);
+    mesh.m_Indices = std::move(indices);
+
+    for (const VertexDataPosition3fNormal3fColor3f& vertex : mesh.m_Vertices)
+    {
+        mesh.m_Bounds.Extend(vertex.position);
+    }
+
+    mesh.m_VertexView = mesh.m_Vertices;
+    mesh.m_IndexView = mesh.m_Indices;
+
+    return mesh;
+}
+
+MeshData MeshData::FromMapping(AssetFile&& mapping, std::span<const VertexDataPosition3fNormal3fColor3f> vertices, std::span<const uint32_t> indices, const MeshBounds& bounds)
+{
+    MeshData mesh;
+
+    mesh.m_Mapping = std::move(mapping);
+    mesh.m_VertexView = vertices;
+    mesh.m_IndexView = indices;
+    mesh.m_Bounds = bounds;
+
+    return mesh;
+}
+
+namespace
+{
+    // getPosition(i) gives the position of the i-th of the vertexCount terrain vertices
+    template<typename GetPosition>
+    MeshData GeneratePlaceholder(std::size_t vertexCount, GetPosition&& getPosition, const MeshBounds& bounds, glm::vec3 color, uint32_t resolution)
+    {
+        const glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3(std::numeric_limits<float>::epsilon()));
+        const uint32_t side = resolution + 1;
+
+        std::vector<float> heights(std::size_t(side) * side, 0.0f);
+        std::vector<uint32_t> sampleCounts(std::size_t(side) * side, 0);
+
+        for (std::size_t i = 0; i < vertexCount; ++i)
+        {
+            const glm::vec3 position = getPosition(i);
+            const uint32_t x = std::min(static_cast<uint32_t>((position.x - bounds.min.x) / extent.x * resolution + 0.5f), resolution);
+            const uint32_t z = std::min(static_cast<uint32_t>((position.z - bounds.min.z) / extent.z * resolution + 0.5f), resolution);
+
+            heights[z * side + x] += position.y;
+            ++sampleCounts[z * side + x];
+        }
+
+        // Grid points without any terrain vertex around them lie on the bottom of the bounds
+        for (std::size_t i = 0; i < heights.size(); ++i)
+        {
+            heights[i] = sampleCounts[i] > 0 ? heights[i] / sampleCounts[i] : bounds.min.y;
+        }
+
+        const glm::vec2 cellSize = glm::vec2(extent.x, extent.z) / static_cast<float>(resolution);
+
+        std::vector<VertexDataPosition3fNormal3fColor3f> vertices;
+        vertices.reserve(heights.size());
+
+        for (uint32_t z = 0; z < side; ++z)
+        {
+            for (uint32_t x = 0; x < side; ++x)
+            {
+                const uint32_t x0 = x > 0 ? x - 1 : x;
+                const uint32_t x1 = x < resolution ? x + 1 : x;
+                const uint32_t z0 = z > 0 ? z - 1 : z;
+                const uint32_t z1 = z < resolution ? z + 1 : z;
+
+                const float slopeX = (heights[z * side + x1] - heights[z * side + x0]) / ((x1 - x0) * cellSize.x);
+                const float slopeZ = (heights[z1 * side + x] - heights[z0 * side + x]) / ((z1 - z0) * cellSize.y);
+
+                vertices.push_back(VertexDataPosition3fNormal3fColor3f {
+                    glm::vec3(bounds.min.x + x * cellSize.x, heights[z * side + x], bounds.min.z + z * cellSize.y),
+                    glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ)),
+                    color
+                });
+            }
+        }
+
+        std::vector<uint32_t> indices;
+        indices.reserve(std::size_t(resolution) * resolution * 6);
+
+        // Counter clockwise seen from above (+y)
+        for (uint32_t z = 0; z < resolution; ++z)
+        {
+            for (uint32_t x = 0; x < resolution; ++x)
+            {
+                const uint32_t i00 = z * side + x;
+                const uint32_t i10 = i00 + 1;
+                const uint32_t i01 = i00 + side;
+                const uint32_t i11 = i01 + 1;
+
+                indices.insert(indices.end(), { i00, i01, i10, i10, i01, i11 });
+            }
+        }
+
+        return MeshData::FromBuffers(std::move(vertices), std::move(indices));
+    }
+}
+
+MeshData GenerateTerrainPlaceholder(const MeshData& terrain, uint32_t resolution)
+{
+    const std::span<const VertexDataPosition3fNormal3fColor3f> vertices = terrain.GetVertices();
+
+    if (vertices.empty() || resolution == 0)
+    {
+        return MeshData();
+    }
+
+    return GeneratePlaceholder(vertices.size(), [vertices](std::size_t i) { return vertices[i].position; }, terrain.GetBounds(), vertices.front().color, resolution);
+}
+
+MeshData GenerateTerrainPlaceholder(std::span<const float> positions, glm::vec3 color, uint32_t resolution)
+{
+    const std::size_t vertexCount = positions.size() / 3;
+
+    if (vertexCount == 0 || resolution == 0)
+    {
+        return MeshData();
+    }
+
+    auto getPosition = [positions](std::size_t i) { return glm::vec3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]); };
+
+    MeshBounds bounds;
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        bounds.Extend(getPosition(i));
+    }
+
+    return GeneratePlaceholder(vertexCount, getPosition, bounds, color, resolution);
+}
+
+END_VISUALIZER_NAMESPACE
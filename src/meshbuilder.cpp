@@ -0,0 +1,273 @@
+#include <meshbuilder.hpp>
+#include <bit>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_EmptySlot = std::numeric_limits<uint32_t>::max();
+    // Vertices a range of 16 bit indices can reach from its base vertex
+    constexpr uint32_t s_ShortIndexVertexCount = 65536;
+    // Ranges allowed per range the vertex count requires at the very least
+    constexpr std::size_t s_MaxShortIndexRangeFactor = 2;
+
+    inline tinyobj::index_t MaskCorner(const tinyobj::index_t& corner, uint32_t attributes)
+    {
+        return tinyobj::index_t{
+            (attributes & WeldPosition) ? corner.vertex_index : -1,
+            (attributes & WeldNormal) ? corner.normal_index : -1,
+            (attributes & WeldTexcoord) ? corner.texcoord_index : -1
+        };
+    }
+
+    inline uint32_t HashCorner(const tinyobj::index_t& corner)
+    {
+        uint64_t hash = static_cast<uint32_t>(corner.vertex_index);
+        hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.normal_index);
+        hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(corner.texcoord_index);
+
+        // Final avalanche so that consecutive indices spread over the whole table
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+
+        return static_cast<uint32_t>(hash);
+    }
+
+    inline bool SameCorner(const tinyobj::index_t& a, const tinyobj::index_t& b)
+    {
+        return a.vertex_index == b.vertex_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+    }
+
+    // Slots only store the id of the unique vertex, the key itself is read back from the vertex array
+    class CornerTable
+    {
+    public:
+        explicit CornerTable(std::size_t expectedCount)
+        {
+            Resize(std::bit_ceil(std::max<std::size_t>(expectedCount * 2, 16)));
+        }
+
+        uint32_t FindOrInsert(const tinyobj::index_t& corner, std::vector<tinyobj::index_t>& vertices)
+        {
+            // Keep the load factor under 1/2 so that probe sequences stay short
+            if ((vertices.size() + 1) * 2 > m_Slots.size())
+            {
+                Grow(vertices);
+            }
+
+            std::size_t slot = HashCorner(corner) & m_Mask;
+
+            while (m_Slots[slot] != s_EmptySlot)
+            {
+                if (SameCorner(vertices[m_Slots[slot]], corner))
+                {
+                    return m_Slots[slot];
+                }
+                slot = (slot + 1) & m_Mask;
+            }
+
+            const uint32_t id = static_cast<uint32_t>(vertices.size());
+            m_Slots[slot] = id;
+            vertices.push_back(corner);
+
+            return id;
+        }
+
+    private:
+        void Resize(std::size_t slotCount)
+        {
+            m_Slots.assign(slotCount, s_EmptySlot);
+            m_Mask = slotCount - 1;
+        }
+
+        void Grow(const std::vector<tinyobj::index_t>& vertices)
+        {
+            Resize(m_Slots.size() * 2);
+
+            for (uint32_t id = 0; id < vertices.size(); ++id)
+            {
+                std::size_t slot = HashCorner(vertices[id]) & m_Mask;
+
+                while (m_Slots[slot] != s_EmptySlot)
+                {
+                    slot = (slot + 1) & m_Mask;
+                }
+
+                m_Slots[slot] = id;
+            }
+        }
+
+        std::vector<uint32_t> m_Slots;
+        std::size_t m_Mask = 0;
+    };
+}
+
+void WeldVertices(std::span<const tinyobj::index_t> corners, uint32_t attributes, std::size_t expectedVertexCount, WeldedMesh& result)
+{
+    result.vertices.clear();
+    result.vertices.reserve(expectedVertexCount);
+    result.indices.resize(corners.size());
+
+    CornerTable table(expectedVertexCount);
+
+    for (std::size_t i = 0; i < corners.size(); ++i)
+    {
+        result.indices[i] = table.FindOrInsert(MaskCorner(corners[i], attributes), result.vertices);
+    }
+}
+
+std::vector<uint32_t> SplitTriangles(std::span<const uint32_t> indices, std::size_t vertexCount, uint32_t maxVertexCount)
+{
+    std::vector<uint32_t> partStarts(1, 0);
+    std::vector<uint32_t> partStamps(vertexCount, s_EmptySlot);
+    uint32_t part = 0;
+    uint32_t partVertexCount = 0;
+
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        uint32_t newVertexCount = 0;
+        for (std::size_t corner = i; corner < i + 3; ++corner)
+        {
+            newVertexCount += partStamps[indices[corner]] != part;
+        }
+
+        if (partVertexCount + newVertexCount > maxVertexCount)
+        {
+            partStarts.push_back(static_cast<uint32_t>(i / 3));
+            ++part;
+            partVertexCount = 0;
+        }
+
+        for (std::size_t corner = i; corner < i + 3; ++corner)
+        {
+            if (partStamps[indices[corner]] != part)
+            {
+                partStamps[indices[corner]] = part;
+                ++partVertexCount;
+            }
+        }
+    }
+
+    return partStarts;
+}
+
+IndexLayout ChooseIndexLayout(std::span<const uint32_t> indices, std::span<const uint32_t> segmentStarts)
+{
+    const uint32_t wholeList = 0;
+
+    if (segmentStarts.empty())
+    {
+        segmentStarts = std::span<const uint32_t>(&wholeList, 1);
+    }
+
+    auto segmentEnd = [&](std::size_t segment) {
+        return segment + 1 < segmentStarts.size() ? std::size_t(segmentStarts[segment + 1]) : indices.size();
+    };
+
+    //32 bit indices draw every segment at once:
+    IndexLayout layout;
+
+    for (std::size_t segment = 0; segment < segmentStarts.size(); ++segment)
+    {
+        layout.segmentRanges.push_back(static_cast<uint32_t>(segment));
+        layout.ranges.push_back(IndexRange{ segmentStarts[segment], static_cast<uint32_t>(segmentEnd(segment) - segmentStarts[segment]), 0 });
+    }
+
+    layout.segmentRanges.push_back(static_cast<uint32_t>(segmentStarts.size()));
+
+    if (indices.empty())
+    {
+        return layout;
+    }
+
+    const uint32_t vertexCount = *std::max_element(indices.begin(), indices.end()) + 1;
+    const std::size_t requiredRangeCount = (vertexCount + s_ShortIndexVertexCount - 1) / s_ShortIndexVertexCount * segmentStarts.size();
+
+    std::vector<IndexRange> ranges;
+    std::vector<uint32_t> segmentRanges;
+
+    for (std::size_t segment = 0; segment < segmentStarts.size(); ++segment)
+    {
+        const std::size_t segmentStart = segmentStarts[segment];
+        const std::size_t end = segmentEnd(segment);
+
+        segmentRanges.push_back(static_cast<uint32_t>(ranges.size()));
+
+        if (segmentStart == end)
+        {
+            continue;
+        }
+
+        uint32_t rangeMin = indices[segmentStart];
+        uint32_t rangeMax = indices[segmentStart];
+        std::size_t rangeStart = segmentStart;
+
+        //a triangle that would stretch the current range over too many vertices starts the next one:
+        for (std::size_t i = segmentStart; i + 2 < end; i += 3)
+        {
+            const uint32_t triangleMin = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+            const uint32_t triangleMax = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+
+            if (triangleMax - triangleMin >= s_ShortIndexVertexCount)
+            {
+                return layout;
+            }
+
+            if (std::max(rangeMax, triangleMax) - std::min(rangeMin, triangleMin) >= s_ShortIndexVertexCount)
+            {
+                ranges.push_back(IndexRange{ static_cast<uint32_t>(rangeStart), static_cast<uint32_t>(i - rangeStart), rangeMin });
+
+                if (ranges.size() >= requiredRangeCount * s_MaxShortIndexRangeFactor)
+                {
+                    return layout;
+                }
+
+                rangeStart = i;
+                rangeMin = triangleMin;
+                rangeMax = triangleMax;
+            }
+            else
+            {
+                rangeMin = std::min(rangeMin, triangleMin);
+                rangeMax = std::max(rangeMax, triangleMax);
+            }
+        }
+
+        ranges.push_back(IndexRange{ static_cast<uint32_t>(rangeStart), static_cast<uint32_t>(end - rangeStart), rangeMin });
+    }
+
+    segmentRanges.push_back(static_cast<uint32_t>(ranges.size()));
+
+    layout.shortIndices = true;
+    layout.ranges = std::move(ranges);
+    layout.segmentRanges = std::move(segmentRanges);
+
+    return layout;
+}
+
+void WriteIndices(std::span<const uint32_t> indices, const IndexLayout& layout, std::size_t first, std::size_t last, void* destination)
+{
+    if (!layout.shortIndices)
+    {
+        std::copy(indices.begin() + first, indices.begin() + last, static_cast<uint32_t*>(destination) + first);
+        return;
+    }
+
+    uint16_t* result = static_cast<uint16_t*>(destination);
+
+    //start from the range holding the first index:
+    auto range = std::upper_bound(layout.ranges.begin(), layout.ranges.end(), first, [](std::size_t index, const IndexRange& r) { return index < r.firstIndex; }) - 1;
+
+    for (std::size_t i = first; i < last; ++range)
+    {
+        const std::size_t rangeEnd = std::min<std::size_t>(range->firstIndex + range->indexCount, last);
+
+        for (; i < rangeEnd; ++i)
+        {
+            result[i] = static_cast<uint16_t>(indices[i] - range->baseVertex);
+        }
+    }
+}
+
+END_VISUALIZER_NAMESPACE
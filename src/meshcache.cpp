@@ -0,0 +1,358 @@
+#include <utils.hpp>
+#include <meshcache.hpp>
+#include <meshcodec.hpp>
+#include <virtualfilesystem.hpp>
+#include <chrono>
+#include <filesystem>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_MeshCacheMagic = 0x48534D56; // "VMSH"
+    constexpr uint32_t s_MeshCacheVersion = 7;
+    constexpr uint64_t s_MeshCacheAlignment = 64;
+    // Vertices generated and written at once by WriteMeshCache
+    constexpr std::size_t s_MeshCacheVertexBlockSize = 64 * 1024;
+
+    struct MeshCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t settingsHash;
+        uint32_t vertexStride;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t encoding;
+        uint64_t vertexOffset;
+        uint32_t meshletCount;
+        uint64_t meshletOffset;
+        uint32_t tileCount;
+        uint64_t tileOffset;
+        // Quantized caches: the index block offsets followed by the index blocks
+        uint64_t indexOffset;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        MeshEncodingError encodingError;
+        uint32_t lodCount;
+        MeshLod lods[s_MaxMeshLodCount];
+    };
+
+    enum MeshEncoding : uint32_t
+    {
+        RawEncoding = 0,
+        QuantizedEncoding = 1
+    };
+
+    uint64_t HashImportSettings(const MeshImportSettings& settings)
+    {
+        uint64_t hash = s_HashSeed;
+
+        HashBytes(hash, &settings.color.x, sizeof(float));
+        HashBytes(hash, &settings.color.y, sizeof(float));
+        HashBytes(hash, &settings.color.z, sizeof(float));
+        HashBytes(hash, &settings.quantize, sizeof(bool));
+        HashBytes(hash, &settings.optimize, sizeof(bool));
+        HashBytes(hash, &settings.lodCount, sizeof(uint32_t));
+        HashBytes(hash, &settings.meshlets, sizeof(bool));
+        HashBytes(hash, &settings.tileGridSize, sizeof(uint32_t));
+
+        return hash;
+    }
+
+    constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+std::string GetMeshCachePath(const std::string& sourceFile)
+{
+    return sourceFile + ".vmesh";
+}
+
+bool LoadMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, MeshData& mesh)
+{
+    FileStamp stamp;
+
+    if (!VirtualFileSystem::GetInstance().GetFileStamp(sourceFile, stamp))
+    {
+        return false;
+    }
+
+    //a packed copy out of date falls back to the loose one:
+    return VirtualFileSystem::GetInstance().OpenCompiled(GetMeshCachePath(sourceFile), [&](AssetFile& mapping) {
+        if (mapping.GetSize() < sizeof(MeshCacheHeader))
+        {
+            return false;
+        }
+
+        MeshCacheHeader header;
+        std::memcpy(&header, mapping.GetData(), sizeof(MeshCacheHeader));
+
+        const MeshEncoding expectedEncoding = settings.quantize ? QuantizedEncoding : RawEncoding;
+        const uint32_t expectedStride = settings.quantize ? sizeof(QuantizedVertex) : sizeof(VertexDataPosition3fNormal3fColor3f);
+
+        if (header.magic != s_MeshCacheMagic ||
+            header.version != s_MeshCacheVersion ||
+            header.encoding != expectedEncoding ||
+            header.vertexStride != expectedStride ||
+            header.sourceSize != stamp.size ||
+            header.sourceWriteTime != stamp.writeTime ||
+            header.settingsHash != HashImportSettings(settings))
+        {
+            return false;
+        }
+
+        const uint64_t vertexBytes = uint64_t(header.vertexCount) * header.vertexStride;
+        const uint64_t indexBytes = header.encoding == QuantizedEncoding ? (GetIndexBlockCount(header.indexCount) + 1) * sizeof(uint64_t) : uint64_t(header.indexCount) * sizeof(uint32_t);
+
+        const uint64_t meshletBytes = uint64_t(header.meshletCount) * sizeof(Meshlet);
+        const uint64_t tileBytes = uint64_t(header.tileCount) * sizeof(MeshTile);
+
+        if (header.vertexOffset + vertexBytes > mapping.GetSize() || header.meshletOffset + meshletBytes > mapping.GetSize() ||
+            header.tileOffset + tileBytes > mapping.GetSize() || header.indexOffset + indexBytes > mapping.GetSize())
+        {
+            std::cerr << "Truncated mesh cache: " << GetMeshCachePath(sourceFile) << '\n';
+            return false;
+        }
+
+        const bool lodsValid = header.lodCount <= s_MaxMeshLodCount && std::all_of(header.lods, header.lods + header.lodCount, [&header](const MeshLod& lod) {
+            return uint64_t(lod.firstIndex) + lod.indexCount <= header.indexCount;
+        });
+
+        const uint8_t* data = mapping.GetData();
+
+        std::vector<Meshlet> meshlets(header.meshletCount);
+        std::memcpy(meshlets.data(), data + header.meshletOffset, meshletBytes);
+
+        const bool meshletsValid = std::all_of(meshlets.begin(), meshlets.end(), [&header](const Meshlet& meshlet) {
+            return uint64_t(meshlet.firstIndex) + meshlet.indexCount <= header.indexCount;
+        });
+
+        std::vector<MeshTile> tiles(header.tileCount);
+        std::memcpy(tiles.data(), data + header.tileOffset, tileBytes);
+
+        const bool tilesValid = std::all_of(tiles.begin(), tiles.end(), [&header](const MeshTile& tile) {
+            return uint64_t(tile.firstIndex) + tile.indexCount <= header.indexCount && uint64_t(tile.firstMeshlet) + tile.meshletCount <= header.meshletCount;
+        });
+
+        if (!lodsValid || !meshletsValid || !tilesValid)
+        {
+            std::cerr << "Corrupted mesh cache: " << GetMeshCachePath(sourceFile) << '\n';
+            return false;
+        }
+
+        std::vector<MeshLod> lods(header.lods, header.lods + header.lodCount);
+
+        MeshBounds bounds;
+        bounds.min = header.boundsMin;
+        bounds.max = header.boundsMax;
+
+        if (header.encoding == QuantizedEncoding)
+        {
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+            const uint64_t indexDataOffset = header.indexOffset + indexBytes;
+
+            EncodedMeshView encoded;
+            encoded.vertices = std::span<const QuantizedVertex>(reinterpret_cast<const QuantizedVertex*>(data + header.vertexOffset), header.vertexCount);
+            encoded.indexBlockOffsets = std::span<const uint64_t>(reinterpret_cast<const uint64_t*>(data + header.indexOffset), GetIndexBlockCount(header.indexCount) + 1);
+            encoded.indexData = std::span<const uint8_t>(data + indexDataOffset, mapping.GetSize() - indexDataOffset);
+            encoded.indexCount = header.indexCount;
+            encoded.bounds = bounds;
+            encoded.color = settings.color;
+
+            //the decoded arrays are owned by the mesh, the mapping can go:
+            if (!DecodeMesh(encoded, mesh))
+            {
+                std::cerr << "Corrupted mesh cache: " << GetMeshCachePath(sourceFile) << '\n';
+                return false;
+            }
+
+            mesh.SetLods(std::move(lods));
+            mesh.SetMeshlets(std::move(meshlets));
+            mesh.SetTiles(std::move(tiles));
+
+            const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "mesh cache decoded in " << elapsed.count() << " ms (" << mapping.GetSize() << " bytes, max position error "
+                      << header.encodingError.position << ", max normal error " << header.encodingError.normal << " deg)\n";
+
+            return true;
+        }
+
+        std::span<const VertexDataPosition3fNormal3fColor3f> vertices(reinterpret_cast<const VertexDataPosition3fNormal3fColor3f*>(data + header.vertexOffset), header.vertexCount);
+        std::span<const uint32_t> indices(reinterpret_cast<const uint32_t*>(data + header.indexOffset), header.indexCount);
+
+        mesh = MeshData::FromMapping(std::move(mapping), vertices, indices, bounds);
+        mesh.SetLods(std::move(lods));
+        mesh.SetMeshlets(std::move(meshlets));
+        mesh.SetTiles(std::move(tiles));
+
+        return true;
+    });
+}
+
+bool WriteMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, const MeshData& mesh)
+{
+    const std::span<const VertexDataPosition3fNormal3fColor3f> vertices = mesh.GetVertices();
+
+    MeshCacheSource source;
+    source.vertexCount = vertices.size();
+    source.generateVertices = [vertices](std::size_t first, std::span<VertexDataPosition3fNormal3fColor3f> block) {
+        std::copy_n(vertices.begin() + first, block.size(), block.begin());
+    };
+    source.indices = mesh.GetIndices();
+    source.bounds = mesh.GetBounds();
+    source.lods = mesh.GetLods();
+    source.meshlets = mesh.GetMeshlets();
+    source.tiles = mesh.GetTiles();
+
+    return WriteMeshCache(sourceFile, settings, source);
+}
+
+bool WriteMeshCache(const std::string& sourceFile, const MeshImportSettings& settings, const MeshCacheSource& mesh)
+{
+    FileStamp stamp;
+
+    if (!VirtualFileSystem::GetInstance().GetFileStamp(sourceFile, stamp))
+    {
+        return false;
+    }
+
+    const std::span<const uint32_t> indices = mesh.indices;
+
+    if (mesh.lods.size() > s_MaxMeshLodCount)
+    {
+        std::cerr << "Too many levels of detail for the mesh cache: " << sourceFile << '\n';
+        return false;
+    }
+
+    //the index blocks are small enough to be encoded upfront, the vertices are encoded block by block while writing:
+    std::vector<uint64_t> indexBlockOffsets;
+    std::vector<uint8_t> indexBlockData;
+
+    if (settings.quantize)
+    {
+        EncodeIndices(indices, indexBlockOffsets, indexBlockData);
+    }
+
+    const std::size_t vertexStride = settings.quantize ? sizeof(QuantizedVertex) : sizeof(VertexDataPosition3fNormal3fColor3f);
+    const std::size_t indexBytes = settings.quantize ? indexBlockOffsets.size() * sizeof(uint64_t) : indices.size_bytes();
+
+    MeshCacheHeader header = {};
+    header.magic = s_MeshCacheMagic;
+    header.version = s_MeshCacheVersion;
+    header.sourceSize = stamp.size;
+    header.sourceWriteTime = stamp.writeTime;
+    header.settingsHash = HashImportSettings(settings);
+    header.vertexStride = static_cast<uint32_t>(vertexStride);
+    header.vertexCount = static_cast<uint32_t>(mesh.vertexCount);
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.encoding = settings.quantize ? QuantizedEncoding : RawEncoding;
+    header.vertexOffset = AlignUp(sizeof(MeshCacheHeader), s_MeshCacheAlignment);
+    //the meshlets and the tiles go before the indices, the compressed index blocks run to the end of the file:
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+    header.meshletOffset = AlignUp(header.vertexOffset + mesh.vertexCount * vertexStride, s_MeshCacheAlignment);
+    header.tileCount = static_cast<uint32_t>(mesh.tiles.size());
+    header.tileOffset = AlignUp(header.meshletOffset + mesh.meshlets.size_bytes(), s_MeshCacheAlignment);
+    header.indexOffset = AlignUp(header.tileOffset + mesh.tiles.size_bytes(), s_MeshCacheAlignment);
+    header.boundsMin = mesh.bounds.min;
+    header.boundsMax = mesh.bounds.max;
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    std::copy(mesh.lods.begin(), mesh.lods.end(), header.lods);
+
+    // Write to a temporary file first so that an interrupted write never leaves a valid looking cache behind
+    const std::string cacheFile = VirtualFileSystem::GetInstance().GetLoosePath(GetMeshCachePath(sourceFile));
+    const std::string tempFile = cacheFile + ".tmp";
+
+    {
+        std::ofstream ofs(tempFile, std::ios::binary | std::ios::trunc);
+
+        if (!ofs)
+        {
+            std::cerr << "Cannot create mesh cache: " << tempFile << '\n';
+            return false;
+        }
+
+        const char zeros[s_MeshCacheAlignment] = {};
+
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+        ofs.write(zeros, header.vertexOffset - sizeof(MeshCacheHeader));
+
+        std::vector<VertexDataPosition3fNormal3fColor3f> vertexBlock(std::min(mesh.vertexCount, s_MeshCacheVertexBlockSize));
+        std::vector<QuantizedVertex> quantizedBlock(settings.quantize ? vertexBlock.size() : 0);
+
+        for (std::size_t first = 0; first < mesh.vertexCount && ofs; first += vertexBlock.size())
+        {
+            const std::span<VertexDataPosition3fNormal3fColor3f> block(vertexBlock.data(), std::min(vertexBlock.size(), mesh.vertexCount - first));
+            mesh.generateVertices(first, block);
+
+            if (!settings.quantize)
+            {
+                ofs.write(reinterpret_cast<const char*>(block.data()), block.size_bytes());
+            }
+            else if (EncodeVertices(block, mesh.bounds, settings.color, quantizedBlock.data(), header.encodingError))
+            {
+                ofs.write(reinterpret_cast<const char*>(quantizedBlock.data()), block.size() * sizeof(QuantizedVertex));
+            }
+            else
+            {
+                std::cerr << "Cannot quantize a mesh with per vertex colors: " << sourceFile << '\n';
+                ofs.setstate(std::ios::failbit);
+            }
+        }
+
+        ofs.write(zeros, header.meshletOffset - header.vertexOffset - mesh.vertexCount * vertexStride);
+        ofs.write(reinterpret_cast<const char*>(mesh.meshlets.data()), mesh.meshlets.size_bytes());
+        ofs.write(zeros, header.tileOffset - header.meshletOffset - mesh.meshlets.size_bytes());
+        ofs.write(reinterpret_cast<const char*>(mesh.tiles.data()), mesh.tiles.size_bytes());
+        ofs.write(zeros, header.indexOffset - header.tileOffset - mesh.tiles.size_bytes());
+
+        if (settings.quantize)
+        {
+            ofs.write(reinterpret_cast<const char*>(indexBlockOffsets.data()), indexBytes);
+            ofs.write(reinterpret_cast<const char*>(indexBlockData.data()), indexBlockData.size());
+        }
+        else
+        {
+            ofs.write(reinterpret_cast<const char*>(indices.data()), indexBytes);
+        }
+
+        //the encoding errors are only known once every vertex went through:
+        ofs.seekp(0);
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+
+        if (!ofs)
+        {
+            std::cerr << "Couldn't write mesh cache: " << tempFile << '\n';
+            ofs.close();
+            std::error_code error;
+            std::filesystem::remove(tempFile, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempFile, cacheFile, error);
+
+    if (error)
+    {
+        std::cerr << "Couldn't move mesh cache in place: " << cacheFile << " (" << error.message() << ")\n";
+        std::filesystem::remove(tempFile, error);
+        return false;
+    }
+
+    if (settings.quantize)
+    {
+        std::cout << "mesh cache quantized: " << mesh.vertexCount * sizeof(VertexDataPosition3fNormal3fColor3f) + indices.size_bytes() << " -> "
+                  << mesh.vertexCount * vertexStride + indexBytes + indexBlockData.size() << " bytes, max position error "
+                  << header.encodingError.position << ", max normal error " << header.encodingError.normal << " deg\n";
+    }
+
+    return true;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,288 @@
+#include <meshcodec.hpp>
+#include <threadpool.hpp>
+#include <atomic>
+#include <cmath>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Vertex or index counts under which decoding is not worth a thread
+    constexpr std::size_t s_MinVerticesPerThread = 64 * 1024;
+    constexpr std::size_t s_MinIndexBlocksPerThread = 16;
+
+    constexpr float s_PositionScale = 65535.0f;
+    constexpr float s_NormalScale = 32767.0f;
+    // Never produced by the snorm encoding, marks the vertices without normal
+    constexpr int16_t s_NoNormal = std::numeric_limits<int16_t>::min();
+
+    inline glm::vec3 GetQuantizationStep(const MeshBounds& bounds)
+    {
+        return glm::max(bounds.max - bounds.min, glm::vec3(0.0f)) / s_PositionScale;
+    }
+
+    inline QuantizedVertex QuantizeVertex(const VertexDataPosition3fNormal3fColor3f& vertex, const MeshBounds& bounds, glm::vec3 step)
+    {
+        QuantizedVertex quantized;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float q = step[axis] > 0.0f ? std::round((vertex.position[axis] - bounds.min[axis]) / step[axis]) : 0.0f;
+            quantized.position[axis] = static_cast<uint16_t>(std::clamp(q, 0.0f, s_PositionScale));
+        }
+
+        const float length = glm::length(vertex.normal);
+
+        if (length > 0.0f)
+        {
+            const glm::vec2 octahedral = EncodeOctahedral(vertex.normal / length);
+            quantized.normal[0] = static_cast<int16_t>(std::round(std::clamp(octahedral.x, -1.0f, 1.0f) * s_NormalScale));
+            quantized.normal[1] = static_cast<int16_t>(std::round(std::clamp(octahedral.y, -1.0f, 1.0f) * s_NormalScale));
+        }
+        else
+        {
+            quantized.normal[0] = quantized.normal[1] = s_NoNormal;
+        }
+
+        return quantized;
+    }
+
+    inline VertexDataPosition3fNormal3fColor3f DequantizeVertex(const QuantizedVertex& quantized, const MeshBounds& bounds, glm::vec3 step, glm::vec3 color)
+    {
+        const glm::vec3 position = bounds.min + glm::vec3(quantized.position[0], quantized.position[1], quantized.position[2]) * step;
+        const glm::vec3 normal = quantized.normal[0] == s_NoNormal ? glm::vec3(0.0f) : DecodeOctahedral(glm::vec2(quantized.normal[0], quantized.normal[1]) / s_NormalScale);
+
+        return VertexDataPosition3fNormal3fColor3f { position, normal, color };
+    }
+
+    inline void WriteVarint(std::vector<uint8_t>& data, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            data.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline bool ReadVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+
+        for (uint32_t shift = 0; p < end && shift < 64; shift += 7)
+        {
+            const uint8_t byte = *p++;
+            value |= uint64_t(byte & 0x7F) << shift;
+
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline uint64_t ZigZag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    bool DecodeIndexBlock(const EncodedMeshView& encoded, std::size_t block, uint32_t* indices)
+    {
+        const uint8_t* p = encoded.indexData.data() + encoded.indexBlockOffsets[block];
+        const uint8_t* end = encoded.indexData.data() + encoded.indexBlockOffsets[block + 1];
+        const std::size_t count = std::min<std::size_t>(s_IndexBlockSize, encoded.indexCount - block * s_IndexBlockSize);
+
+        int64_t previous = 0;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            uint64_t delta;
+
+            if (!ReadVarint(p, end, delta))
+            {
+                return false;
+            }
+
+            previous += UnZigZag(delta);
+
+            if (previous < 0 || static_cast<uint64_t>(previous) >= encoded.vertices.size())
+            {
+                return false;
+            }
+
+            indices[i] = static_cast<uint32_t>(previous);
+        }
+
+        return p == end;
+    }
+}
+
+EncodedMeshView EncodedMesh::GetView() const
+{
+    EncodedMeshView view;
+
+    view.vertices = vertices;
+    view.indexBlockOffsets = indexBlockOffsets;
+    view.indexData = indexData;
+    view.indexCount = indexCount;
+    view.bounds = bounds;
+    view.color = color;
+
+    return view;
+}
+
+bool EncodeVertices(std::span<const VertexDataPosition3fNormal3fColor3f> vertices, const MeshBounds& bounds, glm::vec3 color, QuantizedVertex* result, MeshEncodingError& error)
+{
+    const glm::vec3 step = GetQuantizationStep(bounds);
+
+    for (const VertexDataPosition3fNormal3fColor3f& vertex : vertices)
+    {
+        if (vertex.color != color)
+        {
+            return false;
+        }
+
+        const QuantizedVertex quantized = QuantizeVertex(vertex, bounds, step);
+        *result++ = quantized;
+
+        //measure what the decoder actually gives back rather than the theoretical step:
+        const VertexDataPosition3fNormal3fColor3f decoded = DequantizeVertex(quantized, bounds, step, color);
+        error.position = std::max(error.position, glm::distance(vertex.position, decoded.position));
+
+        const float length = glm::length(vertex.normal);
+        if (length > 0.0f)
+        {
+            const float cosine = std::clamp(glm::dot(vertex.normal / length, decoded.normal), -1.0f, 1.0f);
+            error.normal = std::max(error.normal, glm::degrees(std::acos(cosine)));
+        }
+    }
+
+    return true;
+}
+
+void EncodeIndices(std::span<const uint32_t> indices, std::vector<uint64_t>& blockOffsets, std::vector<uint8_t>& data)
+{
+    const std::size_t blockCount = GetIndexBlockCount(indices.size());
+
+    blockOffsets.clear();
+    blockOffsets.reserve(blockCount + 1);
+    data.clear();
+    data.reserve(indices.size() * 2);
+
+    for (std::size_t block = 0; block < blockCount; ++block)
+    {
+        blockOffsets.push_back(data.size());
+
+        const std::size_t first = block * s_IndexBlockSize;
+        const std::size_t last = std::min(first + s_IndexBlockSize, indices.size());
+        int64_t previous = 0;
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            WriteVarint(data, ZigZag(int64_t(indices[i]) - previous));
+            previous = indices[i];
+        }
+    }
+
+    blockOffsets.push_back(data.size());
+}
+
+bool EncodeMesh(const MeshData& mesh, EncodedMesh& result)
+{
+    const std::span<const VertexDataPosition3fNormal3fColor3f> vertices = mesh.GetVertices();
+    const std::span<const uint32_t> indices = mesh.GetIndices();
+
+    result = EncodedMesh();
+
+    if (vertices.empty())
+    {
+        return false;
+    }
+
+    result.color = vertices.front().color;
+    result.bounds = mesh.GetBounds();
+    result.indexCount = static_cast<uint32_t>(indices.size());
+    result.vertices.resize(vertices.size());
+
+    if (!EncodeVertices(vertices, result.bounds, result.color, result.vertices.data(), result.error))
+    {
+        return false;
+    }
+
+    EncodeIndices(indices, result.indexBlockOffsets, result.indexData);
+
+    return true;
+}
+
+bool DecodeMesh(const EncodedMeshView& encoded, MeshData& result, uint32_t threadCount)
+{
+    const std::size_t vertexCount = encoded.vertices.size();
+    const std::size_t blockCount = GetIndexBlockCount(encoded.indexCount);
+
+    if (encoded.indexBlockOffsets.size() != blockCount + 1 || encoded.indexBlockOffsets.back() > encoded.indexData.size())
+    {
+        return false;
+    }
+
+    for (std::size_t block = 0; block < blockCount; ++block)
+    {
+        if (encoded.indexBlockOffsets[block] > encoded.indexBlockOffsets[block + 1])
+        {
+            return false;
+        }
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const std::size_t chunkCount = std::clamp<std::size_t>(std::max(vertexCount / s_MinVerticesPerThread, blockCount / s_MinIndexBlocksPerThread), 1, threadCount);
+
+    std::vector<VertexDataPosition3fNormal3fColor3f> vertices(vertexCount);
+    std::vector<uint32_t> indices(encoded.indexCount);
+    std::atomic<bool> valid = true;
+
+    const glm::vec3 step = GetQuantizationStep(encoded.bounds);
+
+    //every chunk takes a slice of the vertices and a slice of the index blocks:
+    ParallelFor(chunkCount, [&](std::size_t chunk)
+    {
+        const std::size_t firstVertex = vertexCount * chunk / chunkCount;
+        const std::size_t lastVertex = vertexCount * (chunk + 1) / chunkCount;
+
+        for (std::size_t i = firstVertex; i < lastVertex; ++i)
+        {
+            vertices[i] = DequantizeVertex(encoded.vertices[i], encoded.bounds, step, encoded.color);
+        }
+
+        const std::size_t firstBlock = blockCount * chunk / chunkCount;
+        const std::size_t lastBlock = blockCount * (chunk + 1) / chunkCount;
+
+        for (std::size_t block = firstBlock; block < lastBlock && valid; ++block)
+        {
+            if (!DecodeIndexBlock(encoded, block, indices.data() + block * s_IndexBlockSize))
+            {
+                valid = false;
+            }
+        }
+    });
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    result = MeshData::FromBuffers(std::move(vertices), std::move(indices));
+
+    return true;
+}
+
+END_VISUALIZER_NAMESPACE
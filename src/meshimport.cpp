@@ -0,0 +1,454 @@
+#include <meshimport.hpp>
+#include <meshcache.hpp>
+#include <threadpool.hpp>
+#include <meshoptimizer.hpp>
+#include <meshsimplifier.hpp>
+#include <meshlet.hpp>
+#include <numeric>
+
+#pragma warning(push, 0)
+#include <glm/gtc/type_ptr.hpp>
+#pragma warning(pop, 0)
+
+BEGIN_VISUALIZER_NAMESPACE
+
+void ProcessMeshPart(std::vector<uint32_t>& indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+                     const MeshImportSettings& settings, MeshPartResult& result, const MeshPartStageCallback& onStage)
+{
+    const uint32_t lodCount = std::clamp(settings.lodCount, 1u, s_MaxMeshLodCount);
+    const std::size_t vertexCount = positions.size();
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+    auto endStage = [&](const char* stage) {
+        const std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+        if (onStage)
+            onStage(stage, indices, std::chrono::duration<float, std::milli>(end - start).count());
+        start = end;
+    };
+
+    result.meshlets.clear();
+    result.lodIndices.assign(lodCount, std::vector<uint32_t>());
+    result.lodErrors.assign(lodCount, 0.0f);
+    result.clusterCount = 0;
+
+    if (settings.optimize) {
+        std::vector<uint32_t> clusterStarts;
+        OptimizeVertexCache(indices, vertexCount, &clusterStarts);
+        result.clusterCount = clusterStarts.size();
+        endStage("vertex cache");
+        OptimizeOverdraw(indices, positions, clusterStarts);
+        endStage("overdraw");
+    }
+
+    if (settings.meshlets) {
+        result.meshlets = BuildMeshlets(indices, positions);
+        endStage("meshlets");
+    }
+
+    //every level is simplified from the full part so that its error is measured against the full surface, all of them in parallel:
+    if (lodCount > 1) {
+        ParallelFor(lodCount - 1, [&](std::size_t i) {
+            const std::size_t lod = i + 1;
+            result.lodIndices[lod] = SimplifyMesh(indices, positions, normals, (indices.size() / 3 >> lod) * 3, std::numeric_limits<float>::max(), &result.lodErrors[lod]);
+            if (settings.optimize)
+                OptimizeVertexCache(result.lodIndices[lod], vertexCount);
+        });
+        endStage("levels of detail");
+    }
+
+    if (settings.optimize) {
+        result.order = OptimizeVertexFetch(indices, vertexCount);
+        endStage("vertex fetch");
+    }
+    else {
+        //the renumbering already is in first use order:
+        result.order.resize(vertexCount);
+        std::iota(result.order.begin(), result.order.end(), 0);
+    }
+
+    //the coarser levels only use vertices of the full part, they follow its new numbering:
+    std::vector<uint32_t> newLocalIDs(vertexCount);
+    for (uint32_t i = 0; i < result.order.size(); ++i)
+        newLocalIDs[result.order[i]] = i;
+    for (uint32_t lod = 1; lod < lodCount; ++lod) {
+        for (uint32_t& index : result.lodIndices[lod])
+            index = newLocalIDs[index];
+    }
+}
+
+namespace
+{
+    // Vertex count under which filling the final arrays is not worth a thread
+    constexpr std::size_t s_MinFillVerticesPerThread = 64 * 1024;
+
+    // Sorts the welded triangles into a grid of gridSize x gridSize tiles over the x and z extent of the mesh by their centre,
+    // keeping their order within every tile, then splits them into parts that never straddle two tiles.
+    // Returns the first triangle of every part, tileParts receiving the first part of every tile holding triangles.
+    std::vector<uint32_t> SplitTrianglesIntoTiles(MeshImport& import, uint32_t gridSize, std::vector<uint32_t>& tileParts)
+    {
+        WeldedMesh& welded = import.welded;
+        const ObjData& obj = import.obj;
+        const std::size_t triangleCount = welded.indices.size() / 3;
+
+        MeshBounds bounds;
+        for (const tinyobj::index_t& vertex : welded.vertices)
+            bounds.Extend(glm::make_vec3(&obj.vertices[3 * vertex.vertex_index]));
+        const glm::vec2 cellScale = glm::vec2(static_cast<float>(gridSize)) / glm::max(glm::vec2(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z), glm::vec2(std::numeric_limits<float>::min()));
+
+        //counting sort of the triangles by tile, rows along the x axis:
+        std::vector<uint32_t> triangleTiles(triangleCount);
+        std::vector<uint32_t> tileStarts(std::size_t(gridSize) * gridSize + 1, 0);
+        for (std::size_t triangle = 0; triangle < triangleCount; ++triangle) {
+            glm::vec3 center(0.0f);
+            for (std::size_t corner = 3 * triangle; corner < 3 * triangle + 3; ++corner)
+                center += glm::make_vec3(&obj.vertices[3 * welded.vertices[welded.indices[corner]].vertex_index]);
+            const glm::ivec2 cell = glm::clamp(glm::ivec2((glm::vec2(center.x, center.z) / 3.0f - glm::vec2(bounds.min.x, bounds.min.z)) * cellScale), glm::ivec2(0), glm::ivec2(gridSize - 1));
+            triangleTiles[triangle] = cell.y * gridSize + cell.x;
+            ++tileStarts[triangleTiles[triangle] + 1];
+        }
+        std::partial_sum(tileStarts.begin(), tileStarts.end(), tileStarts.begin());
+
+        std::vector<uint32_t> cursors(tileStarts.begin(), tileStarts.end() - 1);
+        std::vector<uint32_t> sorted(welded.indices.size());
+        for (std::size_t triangle = 0; triangle < triangleCount; ++triangle)
+            std::copy_n(welded.indices.begin() + 3 * triangle, 3, sorted.begin() + 3 * std::size_t(cursors[triangleTiles[triangle]]++));
+        welded.indices = std::move(sorted);
+
+        //the 16 bit parts of the sorted list are cut again at every tile start, which only makes them smaller:
+        const std::vector<uint32_t> splitStarts = SplitTriangles(welded.indices, welded.vertices.size());
+        std::vector<uint32_t> partStarts;
+        std::set_union(splitStarts.begin(), splitStarts.end(), tileStarts.begin(), tileStarts.end() - 1, std::back_inserter(partStarts));
+        partStarts.erase(std::unique(partStarts.begin(), partStarts.end()), partStarts.end());
+        //the empty tiles at the end of the grid start past the last triangle:
+        while (partStarts.size() > 1 && partStarts.back() >= triangleCount)
+            partStarts.pop_back();
+
+        tileParts.clear();
+        for (std::size_t tile = 0; tile + 1 < tileStarts.size(); ++tile) {
+            if (tileStarts[tile] < tileStarts[tile + 1])
+                tileParts.push_back(static_cast<uint32_t>(std::lower_bound(partStarts.begin(), partStarts.end(), tileStarts[tile]) - partStarts.begin()));
+        }
+
+        return partStarts;
+    }
+
+    // Splits the welded mesh into parts that each fit 16 bit indices, then runs ProcessMeshPart on every part.
+    // Every part gets its own block of vertices, the vertices shared by several parts are duplicated.
+    // The indices are stored level of detail by level of detail, every level holding the triangles of all the parts.
+    // With tiles, every tile is a run of whole parts, its triangles sorted in first.
+    void SplitWeldedMesh(MeshImport& import)
+    {
+        WeldedMesh& welded = import.welded;
+        const bool optimize = import.settings.optimize;
+        const uint32_t lodCount = std::clamp(import.settings.lodCount, 1u, s_MaxMeshLodCount);
+        const bool meshlets = import.settings.meshlets;
+        const uint32_t tileGridSize = import.settings.tileGridSize;
+        std::vector<uint32_t> tileParts;
+        const std::vector<uint32_t> partStarts = tileGridSize > 0 ? SplitTrianglesIntoTiles(import, tileGridSize, tileParts) : SplitTriangles(welded.indices, welded.vertices.size());
+
+        import.lods.assign(1, MeshLod{ 0, static_cast<uint32_t>(welded.indices.size()), 0.0f });
+        import.meshlets.clear();
+        import.tiles.clear();
+
+        if (!optimize && partStarts.size() == 1 && lodCount == 1 && !meshlets && tileParts.empty())
+            return;
+
+        const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        const VertexCacheStats before = AnalyzeVertexCache(welded.indices, welded.vertices.size());
+        const std::size_t triangleCount = welded.indices.size() / 3;
+
+        WeldedMesh result;
+        result.vertices.reserve(welded.vertices.size());
+        result.indices.reserve(welded.indices.size());
+
+        std::vector<uint32_t> localIDs(welded.vertices.size());
+        std::vector<uint32_t> partStamps(welded.vertices.size(), std::numeric_limits<uint32_t>::max());
+        std::vector<uint32_t> localVertices;
+        std::vector<uint32_t> localIndices;
+        std::vector<glm::vec3> localPositions;
+        std::vector<glm::vec3> localNormals;
+        MeshPartResult partResult;
+        std::size_t clusterCount = 0;
+        // Coarser levels of every part, appended after the full mesh once all the parts went through
+        std::vector<std::vector<uint32_t>> lodIndices(lodCount);
+        std::vector<float> lodErrors(lodCount, 0.0f);
+
+        for (uint32_t part = 0; part < partStarts.size(); ++part) {
+            const std::size_t firstIndex = std::size_t(partStarts[part]) * 3;
+            const std::size_t lastIndex = (part + 1 < partStarts.size() ? std::size_t(partStarts[part + 1]) : triangleCount) * 3;
+
+            if (import.tiles.size() < tileParts.size() && tileParts[import.tiles.size()] == part)
+                import.tiles.push_back(MeshTile{ static_cast<uint32_t>(result.indices.size()), 0, static_cast<uint32_t>(import.meshlets.size()), 0, MeshBounds() });
+
+            //renumber the vertices of the part from zero:
+            localVertices.clear();
+            localIndices.clear();
+            for (std::size_t i = firstIndex; i < lastIndex; ++i) {
+                const uint32_t vertex = welded.indices[i];
+                if (partStamps[vertex] != part) {
+                    partStamps[vertex] = part;
+                    localIDs[vertex] = static_cast<uint32_t>(localVertices.size());
+                    localVertices.push_back(vertex);
+                }
+                localIndices.push_back(localIDs[vertex]);
+            }
+
+            localPositions.resize(localVertices.size());
+            localNormals.resize(localVertices.size());
+            for (std::size_t i = 0; i < localVertices.size(); ++i) {
+                const tinyobj::index_t& vertex = welded.vertices[localVertices[i]];
+                localPositions[i] = glm::make_vec3(&import.obj.vertices[3 * vertex.vertex_index]);
+                localNormals[i] = vertex.normal_index >= 0 ? glm::make_vec3(&import.obj.normals[3 * vertex.normal_index]) : glm::vec3(0.0f);
+            }
+
+            ProcessMeshPart(localIndices, localPositions, localNormals, import.settings, partResult);
+            clusterCount += partResult.clusterCount;
+            for (uint32_t lod = 1; lod < lodCount; ++lod)
+                lodErrors[lod] = std::max(lodErrors[lod], partResult.lodErrors[lod]);
+
+            const uint32_t baseVertex = static_cast<uint32_t>(result.vertices.size());
+            for (const uint32_t local : partResult.order)
+                result.vertices.push_back(welded.vertices[localVertices[local]]);
+            for (Meshlet& meshlet : partResult.meshlets) {
+                meshlet.firstIndex += static_cast<uint32_t>(result.indices.size());
+                import.meshlets.push_back(meshlet);
+            }
+            for (const uint32_t local : localIndices)
+                result.indices.push_back(baseVertex + local);
+            for (uint32_t lod = 1; lod < lodCount; ++lod) {
+                for (const uint32_t local : partResult.lodIndices[lod])
+                    lodIndices[lod].push_back(baseVertex + local);
+            }
+
+            if (!import.tiles.empty()) {
+                MeshTile& tile = import.tiles.back();
+                tile.indexCount = static_cast<uint32_t>(result.indices.size()) - tile.firstIndex;
+                tile.meshletCount = static_cast<uint32_t>(import.meshlets.size()) - tile.firstMeshlet;
+                for (const glm::vec3& position : localPositions)
+                    tile.bounds.Extend(position);
+            }
+        }
+
+        for (uint32_t lod = 1; lod < lodCount; ++lod) {
+            import.lods.push_back(MeshLod{ static_cast<uint32_t>(result.indices.size()), static_cast<uint32_t>(lodIndices[lod].size()), lodErrors[lod] });
+            result.indices.insert(result.indices.end(), lodIndices[lod].begin(), lodIndices[lod].end());
+        }
+
+        const std::size_t sourceVertexCount = welded.vertices.size();
+        welded = std::move(result);
+
+        const VertexCacheStats after = AnalyzeVertexCache(std::span<const uint32_t>(welded.indices).first(import.lods[0].indexCount), welded.vertices.size());
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << import.name << " split in " << partStarts.size() << " part(s), " << welded.vertices.size() - sourceVertexCount << " vertices duplicated" << std::endl;
+        for (uint32_t lod = 1; lod < lodCount; ++lod)
+            std::cout << import.name << " LOD " << lod << ": " << import.lods[lod].indexCount / 3 << " triangles, error " << import.lods[lod].error << std::endl;
+        if (meshlets)
+            std::cout << import.name << ": " << import.meshlets.size() << " meshlets, " << (import.meshlets.empty() ? 0.0f : import.lods[0].indexCount / 3.0f / import.meshlets.size()) << " triangles per meshlet" << std::endl;
+        if (!import.tiles.empty())
+            std::cout << import.name << ": " << import.tiles.size() << " tiles on a " << tileGridSize << "x" << tileGridSize << " grid, " << import.lods[0].indexCount / 3.0f / import.tiles.size() << " triangles per tile" << std::endl;
+        if (optimize)
+            std::cout << import.name << " optimized in " << elapsed.count() << " ms: ACMR " << before.acmr << " -> " << after.acmr
+                      << ", ATVR " << before.atvr << " -> " << after.atvr << ", " << clusterCount << " clusters" << std::endl;
+    }
+
+    // The levels of detail follow each other in the indices, each one is a segment of the index layout
+    IndexLayout ChooseLodIndexLayout(std::span<const uint32_t> indices, std::span<const MeshLod> lods)
+    {
+        std::vector<uint32_t> lodStarts;
+        for (const MeshLod& lod : lods)
+            lodStarts.push_back(lod.firstIndex);
+
+        return ChooseIndexLayout(indices, lodStarts);
+    }
+
+    // Vertex count of the blocks a thread generates before packing them, small enough to stay in the cache
+    constexpr std::size_t s_PackBlockVertices = 4096;
+}
+
+void ReadObjMesh(MeshImport& import)
+{
+    import.start = std::chrono::steady_clock::now();
+
+    //load the compiled mesh if it is still up to date:
+    if (LoadMeshCache(import.inputFile, import.settings, import.mesh))
+    {
+        import.fromCache = true;
+        import.lods.assign(import.mesh.GetLods().begin(), import.mesh.GetLods().end());
+        import.meshlets.assign(import.mesh.GetMeshlets().begin(), import.mesh.GetMeshlets().end());
+        import.tiles.assign(import.mesh.GetTiles().begin(), import.mesh.GetTiles().end());
+        if (import.lods.empty())
+            import.lods.push_back(MeshLod{ 0, static_cast<uint32_t>(import.mesh.GetIndices().size()), 0.0f });
+        import.indexLayout = ChooseLodIndexLayout(import.mesh.GetIndices(), import.lods);
+        import.vertexLayout = ChooseVertexLayout(import, import.mesh.GetBounds());
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - import.start;
+        std::cout << import.name << " loaded from cache in " << elapsed.count() << " ms" << std::endl;
+        return;
+    }
+
+    if (!VirtualFileSystem::GetInstance().Open(import.inputFile, import.source))
+        std::cerr << "Cannot open file : " << import.inputFile << std::endl;
+}
+
+void ParseObjMesh(MeshImport& import)
+{
+    if (import.fromCache || !import.source.IsOpen())
+        return;
+
+    //load obj, the source pages are faulted in while parsing so the throughput covers the reads too:
+    const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    if (!ParseObj(import.source.GetView(), import.obj))
+        std::cerr << import.name << ": couldn't parse " << import.inputFile << std::endl;
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    const float sourceSize = import.source.GetSize() / (1024.0f * 1024.0f);
+    import.source.Close();
+    std::cout << import.name << " load: " << sourceSize << " MB read and parsed in " << elapsed.count() << " ms (" << sourceSize / (elapsed.count() / 1000.0f) << " MB/s)" << std::endl;
+    std::cout << import.name << " number of vertices: " << import.obj.vertices.size() << std::endl;
+    std::cout << import.name << " number of indices: " << import.obj.indices.size() << std::endl;
+    std::cout << import.name << " number of normals: " << import.obj.normals.size() << std::endl;
+    std::cout << import.name << " number of texcoords: " << import.obj.texcoords.size() << std::endl;
+}
+
+void WeldObjMesh(MeshImport& import)
+{
+    if (import.fromCache || import.obj.indices.empty())
+        return;
+
+    const ObjData& obj = import.obj;
+
+    //weld the (v, vn, vt) corners into unique vertices, texcoords are not part of the vertex format so they are left out of the key:
+    WeldVertices(obj.indices, WeldPosition | WeldNormal, obj.vertices.size() / 3, import.welded);
+    std::cout << import.name << " welded: " << obj.vertices.size() / 3 << " positions -> " << import.welded.vertices.size() << " vertices (x"
+              << (obj.vertices.empty() ? 0.0f : static_cast<float>(import.welded.vertices.size()) / (obj.vertices.size() / 3)) << ")" << std::endl;
+    //the corners and texcoords are not needed anymore, release them before the final vertices are allocated:
+    import.obj.indices = std::vector<tinyobj::index_t>();
+    import.obj.texcoords = std::vector<float>();
+
+    //the split and reordered mesh is what gets cached, later runs load it as is:
+    SplitWeldedMesh(import);
+
+    import.indexLayout = ChooseLodIndexLayout(import.welded.indices, import.lods);
+    std::cout << import.name << " indices: " << (import.indexLayout.shortIndices ? 16 : 32) << " bits in " << import.indexLayout.ranges.size() << " range(s)" << std::endl;
+
+    import.bounds = MeshBounds();
+    for (const tinyobj::index_t& vertex : import.welded.vertices)
+        import.bounds.Extend(glm::make_vec3(&obj.vertices[3 * vertex.vertex_index]));
+    import.vertexLayout = ChooseVertexLayout(import, import.bounds);
+}
+
+void FillObjMesh(MeshImport& import, void* vertices, const VertexLayout* vertexLayout, void* indices, const IndexLayout& indexLayout)
+{
+    const ObjData& obj = import.obj;
+    const WeldedMesh& welded = import.welded;
+    const glm::vec3 color = import.settings.color;
+
+    //final vertices of welded.vertices[first, first + count), written where the caller wants them:
+    auto generate = [&obj, &welded, color](std::size_t first, std::span<VertexDataPosition3fNormal3fColor3f> block) {
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            const tinyobj::index_t& vertex = welded.vertices[first + i];
+            block[i] = VertexDataPosition3fNormal3fColor3f {
+                glm::make_vec3(&obj.vertices[3 * vertex.vertex_index]),
+                vertex.normal_index >= 0 ? glm::make_vec3(&obj.normals[3 * vertex.normal_index]) : glm::vec3(0.0f),
+                color
+            };
+        }
+    };
+
+    //every chunk writes its own slice of both arrays:
+    const std::size_t chunkCount = std::clamp<std::size_t>(welded.vertices.size() / s_MinFillVerticesPerThread, 1, std::max(1u, std::thread::hardware_concurrency()));
+    ParallelFor(chunkCount, [&](std::size_t chunk) {
+        const std::size_t firstVertex = welded.vertices.size() * chunk / chunkCount;
+        const std::size_t lastVertex = welded.vertices.size() * (chunk + 1) / chunkCount;
+        if (!vertexLayout) {
+            generate(firstVertex, std::span<VertexDataPosition3fNormal3fColor3f>(static_cast<VertexDataPosition3fNormal3fColor3f*>(vertices) + firstVertex, lastVertex - firstVertex));
+        }
+        else {
+            //packed layouts go through a small block of full vertices:
+            std::vector<VertexDataPosition3fNormal3fColor3f> block(std::min(s_PackBlockVertices, lastVertex - firstVertex));
+            for (std::size_t first = firstVertex; first < lastVertex; first += block.size()) {
+                const std::span<VertexDataPosition3fNormal3fColor3f> slice = std::span(block).first(std::min(block.size(), lastVertex - first));
+                generate(first, slice);
+                vertexLayout->PackVertices(slice, static_cast<std::byte*>(vertices) + first * vertexLayout->stride);
+            }
+        }
+
+        const std::size_t firstIndex = welded.indices.size() * chunk / chunkCount;
+        const std::size_t lastIndex = welded.indices.size() * (chunk + 1) / chunkCount;
+        WriteIndices(welded.indices, indexLayout, firstIndex, lastIndex, indices);
+    });
+
+    //compile the mesh for the next runs, the vertices are generated again rather than read back from the given storage which may be write combined:
+    MeshCacheSource source;
+    source.vertexCount = welded.vertices.size();
+    source.generateVertices = generate;
+    source.indices = welded.indices;
+    source.bounds = import.bounds;
+    source.lods = import.lods;
+    source.meshlets = import.meshlets;
+    source.tiles = import.tiles;
+    if (!WriteMeshCache(import.inputFile, import.settings, source))
+        std::cerr << import.name << ": couldn't write mesh cache" << std::endl;
+
+    import.welded = WeldedMesh();
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - import.start;
+    std::cout << import.name << " imported in " << elapsed.count() << " ms" << std::endl;
+}
+
+void BuildObjMesh(MeshImport& import)
+{
+    if (import.fromCache || import.obj.indices.empty())
+        return;
+
+    WeldObjMesh(import);
+    FillObjMeshData(import);
+}
+
+void FillObjMeshData(MeshImport& import)
+{
+    std::vector<VertexDataPosition3fNormal3fColor3f> vertices(import.welded.vertices.size());
+    std::vector<uint32_t> indices(import.welded.indices.size());
+    FillObjMesh(import, vertices.data(), nullptr, indices.data(), IndexLayout());
+
+    import.mesh = MeshData::FromBuffers(std::move(vertices), std::move(indices));
+    import.mesh.SetLods(std::vector<MeshLod>(import.lods));
+    import.mesh.SetMeshlets(std::vector<Meshlet>(import.meshlets));
+    import.mesh.SetTiles(std::vector<MeshTile>(import.tiles));
+}
+
+void BuildShortIndices(MeshImport& import)
+{
+    if (!import.indexLayout.shortIndices)
+        return;
+
+    const std::span<const uint32_t> indices = import.mesh.GetIndices();
+    import.shortIndices.resize(indices.size());
+    WriteIndices(indices, import.indexLayout, 0, indices.size(), import.shortIndices.data());
+}
+
+void PackMeshVertices(MeshImport& import)
+{
+    const std::span<const VertexDataPosition3fNormal3fColor3f> vertices = import.mesh.GetVertices();
+    import.packedVertices.resize(vertices.size() * import.vertexLayout.stride);
+    import.vertexLayout.PackVertices(vertices, import.packedVertices.data());
+}
+
+VertexLayout ChooseVertexLayout(const MeshImport& import, const MeshBounds& bounds)
+{
+    return VertexLayout::Create(ChooseVertexFormat(bounds, import.packVertices), bounds);
+}
+
+MeshData LoadObjMesh(const std::string& name, const std::string& inputFile, const MeshImportSettings& settings)
+{
+    MeshImport import;
+    import.name = name;
+    import.inputFile = inputFile;
+    import.settings = settings;
+
+    ReadObjMesh(import);
+    ParseObjMesh(import);
+    BuildObjMesh(import);
+
+    return std::move(import.mesh);
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,381 @@
+#include <meshlet.hpp>
+#include <meshoptimizer.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_NoMeshlet = std::numeric_limits<uint32_t>::max();
+    // Cones whose normals spread further than about 84 degrees from their axis cannot cull anything worth the test
+    constexpr float s_MinConeSpread = 0.1f;
+
+    // Triangles using every vertex, in compressed rows
+    struct VertexAdjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        VertexAdjacency(std::span<const uint32_t> indices, std::size_t vertexCount)
+            : offsets(vertexCount + 1, 0)
+            , triangles(indices.size())
+        {
+            for (const uint32_t vertex : indices)
+            {
+                ++offsets[vertex + 1];
+            }
+
+            for (std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+            {
+                offsets[vertex + 1] += offsets[vertex];
+            }
+
+            std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+
+            for (std::size_t i = 0; i < indices.size(); ++i)
+            {
+                triangles[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        inline std::span<const uint32_t> GetTriangles(uint32_t vertex) const
+        {
+            return std::span<const uint32_t>(triangles.data() + offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+        }
+    };
+}
+
+std::vector<Meshlet> BuildMeshlets(std::span<uint32_t> indices, std::span<const glm::vec3> positions, uint32_t maxVertices, uint32_t maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    const std::size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+    {
+        return meshlets;
+    }
+
+    const VertexAdjacency adjacency(indices, positions.size());
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    std::vector<bool> emitted(triangleCount, false);
+    // Meshlet every vertex and every candidate triangle were last added to
+    std::vector<uint32_t> vertexMeshlets(positions.size(), s_NoMeshlet);
+    std::vector<uint32_t> candidateMeshlets(triangleCount, s_NoMeshlet);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> localVertices;
+    std::vector<uint32_t> localIndices;
+    std::size_t seed = 0;
+
+    while (result.size() < triangleCount * 3)
+    {
+        //every meshlet starts from the first triangle left in the current order, which keeps the order of the previous optimizations:
+        while (emitted[seed])
+        {
+            ++seed;
+        }
+
+        const uint32_t meshletID = static_cast<uint32_t>(meshlets.size());
+        Meshlet meshlet;
+        meshlet.firstIndex = static_cast<uint32_t>(result.size());
+
+        uint32_t vertexCount = 0;
+        uint32_t meshletTriangles = 0;
+        glm::vec3 positionSum(0.0f);
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        candidates.clear();
+
+        auto addTriangle = [&](uint32_t triangle)
+        {
+            emitted[triangle] = true;
+            ++meshletTriangles;
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[3 * triangle + corner];
+                result.push_back(vertex);
+
+                if (vertexMeshlets[vertex] == meshletID)
+                {
+                    continue;
+                }
+
+                vertexMeshlets[vertex] = meshletID;
+                positionSum += positions[vertex];
+                boundsMin = glm::min(boundsMin, positions[vertex]);
+                boundsMax = glm::max(boundsMax, positions[vertex]);
+                ++vertexCount;
+
+                for (const uint32_t neighbour : adjacency.GetTriangles(vertex))
+                {
+                    if (!emitted[neighbour] && candidateMeshlets[neighbour] != meshletID)
+                    {
+                        candidateMeshlets[neighbour] = meshletID;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+        };
+
+        addTriangle(static_cast<uint32_t>(seed));
+
+        while (meshletTriangles < maxTriangles)
+        {
+            const glm::vec3 centroid = positionSum / static_cast<float>(vertexCount);
+            uint32_t bestTriangle = s_NoMeshlet;
+            uint32_t bestNewVertices = 4;
+            float bestDistance = std::numeric_limits<float>::max();
+
+            for (std::size_t i = 0; i < candidates.size();)
+            {
+                const uint32_t triangle = candidates[i];
+
+                if (emitted[triangle])
+                {
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+
+                ++i;
+
+                const uint32_t* corners = &indices[3 * triangle];
+                const uint32_t newVertices = uint32_t(vertexMeshlets[corners[0]] != meshletID) + uint32_t(vertexMeshlets[corners[1]] != meshletID) + uint32_t(vertexMeshlets[corners[2]] != meshletID);
+
+                if (vertexCount + newVertices > maxVertices || newVertices > bestNewVertices)
+                {
+                    continue;
+                }
+
+                //fewest new vertices first, then the most compact meshlet for tighter spheres and cones:
+                const glm::vec3 triangleCenter = (positions[corners[0]] + positions[corners[1]] + positions[corners[2]]) / 3.0f;
+                const float distance = glm::dot(triangleCenter - centroid, triangleCenter - centroid);
+
+                if (newVertices < bestNewVertices || distance < bestDistance)
+                {
+                    bestTriangle = triangle;
+                    bestNewVertices = newVertices;
+                    bestDistance = distance;
+                }
+            }
+
+            //disconnected parts such as separate leaves go on with the next triangle left in the current order, as long as it lies close by:
+            if (bestTriangle == s_NoMeshlet && candidates.empty())
+            {
+                while (seed < triangleCount && emitted[seed])
+                {
+                    ++seed;
+                }
+
+                if (seed < triangleCount)
+                {
+                    const uint32_t* corners = &indices[3 * seed];
+                    const uint32_t newVertices = uint32_t(vertexMeshlets[corners[0]] != meshletID) + uint32_t(vertexMeshlets[corners[1]] != meshletID) + uint32_t(vertexMeshlets[corners[2]] != meshletID);
+                    const glm::vec3 triangleCenter = (positions[corners[0]] + positions[corners[1]] + positions[corners[2]]) / 3.0f;
+                    const glm::vec3 centroid = positionSum / static_cast<float>(vertexCount);
+
+                    if (vertexCount + newVertices <= maxVertices && glm::distance(triangleCenter, centroid) <= glm::distance(boundsMin, boundsMax))
+                    {
+                        bestTriangle = static_cast<uint32_t>(seed);
+                    }
+                }
+            }
+
+            if (bestTriangle == s_NoMeshlet)
+            {
+                break;
+            }
+
+            addTriangle(bestTriangle);
+        }
+
+        meshlet.indexCount = static_cast<uint32_t>(result.size()) - meshlet.firstIndex;
+
+        //the growth order follows the adjacency, not the vertex cache, which the triangles are reordered for within the meshlet:
+        localVertices.clear();
+        localIndices.clear();
+        for (std::size_t i = meshlet.firstIndex; i < result.size(); ++i)
+        {
+            const auto local = std::find(localVertices.begin(), localVertices.end(), result[i]);
+            localIndices.push_back(static_cast<uint32_t>(local - localVertices.begin()));
+            if (local == localVertices.end())
+            {
+                localVertices.push_back(result[i]);
+            }
+        }
+        OptimizeVertexCache(localIndices, localVertices.size());
+        for (std::size_t i = 0; i < localIndices.size(); ++i)
+        {
+            result[meshlet.firstIndex + i] = localVertices[localIndices[i]];
+        }
+
+        ComputeMeshletBounds(result, positions, meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+
+    return meshlets;
+}
+
+void ComputeMeshletBounds(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, Meshlet& meshlet)
+{
+    const std::span<const uint32_t> triangles = indices.subspan(meshlet.firstIndex, meshlet.indexCount);
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+
+    for (const uint32_t vertex : triangles)
+    {
+        min = glm::min(min, positions[vertex]);
+        max = glm::max(max, positions[vertex]);
+    }
+
+    meshlet.center = (min + max) * 0.5f;
+    meshlet.radius = 0.0f;
+
+    for (const uint32_t vertex : triangles)
+    {
+        meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, positions[vertex]));
+    }
+
+    //the axis is the mean of the unit normals, the cone opens as wide as the normal furthest from it:
+    std::vector<glm::vec3> normals;
+    normals.reserve(triangles.size() / 3);
+    glm::vec3 axis(0.0f);
+
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        const glm::vec3 normal = glm::cross(positions[triangles[i + 1]] - positions[triangles[i]], positions[triangles[i + 2]] - positions[triangles[i]]);
+        const float length = glm::length(normal);
+
+        if (length > 0.0f)
+        {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+
+    meshlet.coneAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+    meshlet.coneCutoff = 1.0f;
+
+    const float axisLength = glm::length(axis);
+
+    if (normals.empty() || axisLength <= 0.0f)
+    {
+        return;
+    }
+
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+
+    for (const glm::vec3& normal : normals)
+    {
+        minDot = std::min(minDot, glm::dot(axis, normal));
+    }
+
+    if (minDot <= s_MinConeSpread)
+    {
+        return;
+    }
+
+    //the triangles face away from every view direction within 90 degrees minus the cone spread of the axis:
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+    //Gribb and Hartmann, rows of the matrix combined for the -w <= x, y, z <= w clip volume:
+    const glm::mat4 rows = glm::transpose(viewProjection);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return frustum;
+}
+
+bool Frustum::IntersectsBox(const glm::vec3& min, const glm::vec3& max) const
+{
+    //the box is outside as soon as its corner furthest along the normal of a plane is behind it:
+    for (const glm::vec4& plane : planes)
+    {
+        const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+MeshletVisibility CullMeshlet(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& offset)
+{
+    const glm::vec3 center = meshlet.center + offset;
+
+    if (!frustum.IntersectsSphere(center, meshlet.radius))
+    {
+        return MeshletVisibility::OutsideFrustum;
+    }
+
+    const glm::vec3 view = center - cameraPosition;
+
+    if (glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(view) + meshlet.radius)
+    {
+        return MeshletVisibility::Backfacing;
+    }
+
+    return MeshletVisibility::Visible;
+}
+
+void CullMeshlets(std::span<const Meshlet> meshlets, const Frustum& frustum, const glm::vec3& cameraPosition, const glm::vec3& offset,
+                  std::vector<uint32_t>& visible, MeshletCullStats& stats)
+{
+    stats.tested += meshlets.size();
+
+    for (std::size_t i = 0; i < meshlets.size(); ++i)
+    {
+        switch (CullMeshlet(meshlets[i], frustum, cameraPosition, offset))
+        {
+        case MeshletVisibility::Visible:
+            visible.push_back(static_cast<uint32_t>(i));
+            break;
+        case MeshletVisibility::OutsideFrustum:
+            ++stats.outsideFrustum;
+            break;
+        case MeshletVisibility::Backfacing:
+            ++stats.backfacing;
+            break;
+        }
+    }
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,344 @@
+#include <meshoptimizer.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr uint32_t s_NoVertex = std::numeric_limits<uint32_t>::max();
+
+    // FIFO cache where a vertex is resident while fewer than size vertices were inserted after it
+    class FifoCache
+    {
+    public:
+        FifoCache(std::size_t vertexCount, uint32_t size)
+            : m_InsertionTimes(vertexCount, 0)
+            , m_Time(size + 1)
+            , m_Size(size)
+        {}
+
+        inline void Reset() { m_Time += m_Size + 1; }
+
+        // Returns whether the vertex had to be transformed
+        inline bool Access(uint32_t vertex)
+        {
+            if (m_Time - m_InsertionTimes[vertex] <= m_Size)
+            {
+                return false;
+            }
+
+            m_InsertionTimes[vertex] = m_Time++;
+            return true;
+        }
+
+        inline uint32_t AccessTriangle(const uint32_t* triangle)
+        {
+            return uint32_t(Access(triangle[0])) + uint32_t(Access(triangle[1])) + uint32_t(Access(triangle[2]));
+        }
+
+    private:
+        std::vector<uint32_t> m_InsertionTimes;
+        uint32_t m_Time;
+        uint32_t m_Size;
+    };
+
+    // Next vertex with triangles left, popped from the dead end stack first then scanned in index order
+    uint32_t SkipDeadEnd(const std::vector<uint32_t>& liveCounts, std::vector<uint32_t>& deadEnds, std::size_t& cursor)
+    {
+        while (!deadEnds.empty())
+        {
+            const uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+
+            if (liveCounts[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+
+        for (; cursor < liveCounts.size(); ++cursor)
+        {
+            if (liveCounts[cursor] > 0)
+            {
+                return static_cast<uint32_t>(cursor);
+            }
+        }
+
+        return s_NoVertex;
+    }
+}
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, std::size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+
+    if (indices.size() < 3 || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    std::size_t referencedCount = 0;
+    std::size_t misses = 0;
+
+    for (const uint32_t vertex : indices)
+    {
+        misses += cache.Access(vertex);
+
+        if (!referenced[vertex])
+        {
+            referenced[vertex] = true;
+            ++referencedCount;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / referencedCount;
+
+    return stats;
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount, std::vector<uint32_t>* clusterStarts, uint32_t cacheSize)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+
+    if (clusterStarts)
+    {
+        clusterStarts->assign(1, 0);
+    }
+
+    if (triangleCount == 0 || vertexCount == 0)
+    {
+        return;
+    }
+
+    // Triangles around every vertex, liveCounts then counts the ones not emitted yet
+    std::vector<uint32_t> liveCounts(vertexCount, 0);
+    for (const uint32_t vertex : indices)
+    {
+        ++liveCounts[vertex];
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCounts[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            adjacency[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<uint32_t> cacheTimes(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    uint32_t time = cacheSize + 1;
+    std::size_t cursor = 0;
+    uint32_t fanning = SkipDeadEnd(liveCounts, deadEnds, cursor);
+
+    while (fanning != s_NoVertex)
+    {
+        //emit every triangle left around the fanning vertex:
+        candidates.clear();
+
+        for (uint32_t i = adjacencyOffsets[fanning]; i < adjacencyOffsets[fanning + 1]; ++i)
+        {
+            const uint32_t triangle = adjacency[i];
+
+            if (emitted[triangle])
+            {
+                continue;
+            }
+
+            emitted[triangle] = true;
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveCounts[vertex];
+
+                if (time - cacheTimes[vertex] > cacheSize)
+                {
+                    cacheTimes[vertex] = time++;
+                }
+            }
+        }
+
+        //the next fan turns around the oldest candidate that is still in the cache once its own fan is emitted:
+        uint32_t next = s_NoVertex;
+        int64_t bestPriority = -1;
+
+        for (const uint32_t vertex : candidates)
+        {
+            if (liveCounts[vertex] == 0)
+            {
+                continue;
+            }
+
+            const int64_t age = time - cacheTimes[vertex];
+            const int64_t priority = age + 2 * int64_t(liveCounts[vertex]) <= cacheSize ? age : 0;
+
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next == s_NoVertex)
+        {
+            next = SkipDeadEnd(liveCounts, deadEnds, cursor);
+
+            if (next != s_NoVertex && clusterStarts)
+            {
+                clusterStarts->push_back(static_cast<uint32_t>(result.size() / 3));
+            }
+        }
+
+        fanning = next;
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions, std::span<const uint32_t> clusterStarts, float threshold, uint32_t cacheSize)
+{
+    const std::size_t triangleCount = indices.size() / 3;
+
+    if (triangleCount == 0 || clusterStarts.empty())
+    {
+        return;
+    }
+
+    //split the clusters wherever the triangles since the last split already reach the cache efficiency of the whole cluster:
+    std::vector<uint32_t> clusters;
+    FifoCache cache(positions.size(), cacheSize);
+
+    for (std::size_t i = 0; i < clusterStarts.size(); ++i)
+    {
+        const std::size_t start = clusterStarts[i];
+        const std::size_t end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount;
+
+        if (start >= end)
+        {
+            continue;
+        }
+
+        uint32_t clusterMisses = 0;
+        cache.Reset();
+        for (std::size_t triangle = start; triangle < end; ++triangle)
+        {
+            clusterMisses += cache.AccessTriangle(&indices[triangle * 3]);
+        }
+
+        const float splitThreshold = threshold * clusterMisses / (end - start);
+
+        clusters.push_back(static_cast<uint32_t>(start));
+        std::size_t splitStart = start;
+        uint32_t splitMisses = 0;
+        cache.Reset();
+
+        for (std::size_t triangle = start; triangle + 1 < end; ++triangle)
+        {
+            splitMisses += cache.AccessTriangle(&indices[triangle * 3]);
+
+            if (splitMisses <= splitThreshold * (triangle + 1 - splitStart))
+            {
+                splitStart = triangle + 1;
+                splitMisses = 0;
+                clusters.push_back(static_cast<uint32_t>(splitStart));
+                cache.Reset();
+            }
+        }
+    }
+
+    //clusters far out along their normal are likely in front of the others, they are drawn first:
+    glm::dvec3 meshCentroid(0.0);
+    for (const uint32_t vertex : indices.first(triangleCount * 3))
+    {
+        meshCentroid += glm::dvec3(positions[vertex]);
+    }
+    const glm::vec3 center = glm::vec3(meshCentroid / double(triangleCount * 3));
+
+    std::vector<std::pair<float, uint32_t>> sortKeys(clusters.size());
+
+    for (std::size_t i = 0; i < clusters.size(); ++i)
+    {
+        const std::size_t start = clusters[i];
+        const std::size_t end = i + 1 < clusters.size() ? clusters[i + 1] : triangleCount;
+
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for (std::size_t triangle = start; triangle < end; ++triangle)
+        {
+            const glm::vec3& p0 = positions[indices[triangle * 3]];
+            const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+            const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+
+            const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            const float triangleArea = glm::length(cross);
+
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+
+        const float normalLength = glm::length(normal);
+        centroid = area > 0.0f ? centroid / area : positions[indices[start * 3]];
+        normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+
+        sortKeys[i] = { glm::dot(centroid - center, normal), static_cast<uint32_t>(i) };
+    }
+
+    std::stable_sort(sortKeys.begin(), sortKeys.end(), [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    for (const std::pair<float, uint32_t>& key : sortKeys)
+    {
+        const std::size_t start = clusters[key.second];
+        const std::size_t end = key.second + 1 < clusters.size() ? clusters[key.second + 1] : triangleCount;
+
+        result.insert(result.end(), indices.begin() + start * 3, indices.begin() + end * 3);
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, std::size_t vertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, s_NoVertex);
+    std::vector<uint32_t> order;
+    order.reserve(vertexCount);
+
+    for (uint32_t& vertex : indices)
+    {
+        if (remap[vertex] == s_NoVertex)
+        {
+            remap[vertex] = static_cast<uint32_t>(order.size());
+            order.push_back(vertex);
+        }
+
+        vertex = remap[vertex];
+    }
+
+    return order;
+}
+
+END_VISUALIZER_NAMESPACE
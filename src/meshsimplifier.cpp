@@ -0,0 +1,436 @@
+#include <meshsimplifier.hpp>
+#include <numeric>
+#include <unordered_map>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Weight of the planes keeping the borders in place, relative to the planes of the triangles
+    constexpr double s_BorderWeight = 10.0;
+    // Weight of the normal changes of a collapse, relative to its squared length
+    constexpr double s_NormalWeight = 0.5;
+    // Smallest cosine between the normals of a triangle before and after a collapse, tighter than a plain flip
+    // check so that thin triangles do not turn on their side
+    constexpr double s_MinFlipCosine = 0.25;
+
+    enum class PositionKind : uint8_t
+    {
+        Manifold,
+        Border,
+        Locked
+    };
+
+    // Sum of the squared distances to a set of weighted planes
+    struct Quadric
+    {
+        // Symmetric matrix, vector and constant of the quadratic form
+        double a00 = 0.0, a11 = 0.0, a22 = 0.0, a01 = 0.0, a02 = 0.0, a12 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        double c = 0.0;
+        double weight = 0.0;
+
+        void AddPlane(const glm::dvec3& normal, double distance, double planeWeight)
+        {
+            a00 += planeWeight * normal.x * normal.x;
+            a11 += planeWeight * normal.y * normal.y;
+            a22 += planeWeight * normal.z * normal.z;
+            a01 += planeWeight * normal.x * normal.y;
+            a02 += planeWeight * normal.x * normal.z;
+            a12 += planeWeight * normal.y * normal.z;
+            b0 += planeWeight * normal.x * distance;
+            b1 += planeWeight * normal.y * distance;
+            b2 += planeWeight * normal.z * distance;
+            c += planeWeight * distance * distance;
+            weight += planeWeight;
+        }
+
+        void Add(const Quadric& other)
+        {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a01 += other.a01; a02 += other.a02; a12 += other.a12;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        double Evaluate(const glm::dvec3& p) const
+        {
+            const double quadratic = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z);
+            const double linear = 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z);
+
+            return quadratic + linear + c;
+        }
+    };
+
+    // Weighted mean squared distance of p to the planes of both quadrics
+    double CollapseError(const Quadric& from, const Quadric& to, const glm::dvec3& p)
+    {
+        const double weight = from.weight + to.weight;
+
+        return weight > 0.0 ? std::max(0.0, from.Evaluate(p) + to.Evaluate(p)) / weight : 0.0;
+    }
+
+    inline uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return (uint64_t(a) << 32) | b;
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        // Geometric error plus the normal penalty, the collapses are sorted on it
+        double cost;
+        double error;
+        bool border;
+    };
+}
+
+std::vector<uint32_t> SimplifyMesh(std::span<const uint32_t> indices, std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+                                   std::size_t targetIndexCount, float maxError, float* error)
+{
+    std::vector<uint32_t> result(indices.begin(), indices.end() - indices.size() % 3);
+    double resultError = 0.0;
+
+    if (error)
+    {
+        *error = 0.0f;
+    }
+
+    if (result.size() <= targetIndexCount || positions.empty())
+    {
+        return result;
+    }
+
+    const std::size_t vertexCount = positions.size();
+    const bool hasNormals = normals.size() == vertexCount;
+
+    //vertices sharing a position collapse together, they are grouped by sorting them on their position:
+    std::vector<uint32_t> sortedVertices(vertexCount);
+    std::iota(sortedVertices.begin(), sortedVertices.end(), 0);
+    std::sort(sortedVertices.begin(), sortedVertices.end(), [&positions](uint32_t a, uint32_t b) {
+        const glm::vec3& pa = positions[a];
+        const glm::vec3& pb = positions[b];
+        return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    });
+
+    std::vector<uint32_t> groups(vertexCount);
+    std::vector<uint32_t> groupOffsets;
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        if (i == 0 || positions[sortedVertices[i]] != positions[sortedVertices[i - 1]])
+        {
+            groupOffsets.push_back(static_cast<uint32_t>(i));
+        }
+
+        groups[sortedVertices[i]] = static_cast<uint32_t>(groupOffsets.size() - 1);
+    }
+    const std::size_t groupCount = groupOffsets.size();
+    groupOffsets.push_back(static_cast<uint32_t>(vertexCount));
+
+    auto groupPosition = [&](uint32_t group) { return glm::dvec3(positions[sortedVertices[groupOffsets[group]]]); };
+
+    //a position is on a border when one of its edges is used by a single triangle, the borders of the source are kept:
+    std::unordered_map<uint64_t, uint32_t> edgeUses;
+    edgeUses.reserve(result.size());
+    for (std::size_t i = 0; i < result.size(); i += 3)
+    {
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            ++edgeUses[EdgeKey(groups[result[i + corner]], groups[result[i + (corner + 1) % 3]])];
+        }
+    }
+
+    std::vector<PositionKind> kinds(groupCount, PositionKind::Manifold);
+    std::vector<uint32_t> borderEdgeCounts(groupCount, 0);
+    for (const std::pair<const uint64_t, uint32_t>& edge : edgeUses)
+    {
+        const uint32_t a = static_cast<uint32_t>(edge.first >> 32);
+        const uint32_t b = static_cast<uint32_t>(edge.first);
+
+        if (edge.second > 1)
+        {
+            kinds[a] = kinds[b] = PositionKind::Locked;
+        }
+        else if (!edgeUses.contains(EdgeKey(b, a)))
+        {
+            ++borderEdgeCounts[a];
+            ++borderEdgeCounts[b];
+        }
+    }
+    for (std::size_t group = 0; group < groupCount; ++group)
+    {
+        if (kinds[group] == PositionKind::Manifold && borderEdgeCounts[group] > 0)
+        {
+            kinds[group] = borderEdgeCounts[group] == 2 ? PositionKind::Border : PositionKind::Locked;
+        }
+    }
+
+    //planes of the triangles around every position, plus planes orthogonal to the borders:
+    std::vector<Quadric> quadrics(groupCount);
+    for (std::size_t i = 0; i < result.size(); i += 3)
+    {
+        const uint32_t triangle[3] = { groups[result[i]], groups[result[i + 1]], groups[result[i + 2]] };
+        const glm::dvec3 p[3] = { groupPosition(triangle[0]), groupPosition(triangle[1]), groupPosition(triangle[2]) };
+        const glm::dvec3 cross = glm::cross(p[1] - p[0], p[2] - p[0]);
+        const double length = glm::length(cross);
+
+        if (length == 0.0)
+        {
+            continue;
+        }
+
+        const glm::dvec3 normal = cross / length;
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            quadrics[triangle[corner]].AddPlane(normal, -glm::dot(normal, p[0]), length * 0.5);
+        }
+
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            const uint32_t a = triangle[corner];
+            const uint32_t b = triangle[(corner + 1) % 3];
+
+            if (edgeUses.contains(EdgeKey(b, a)))
+            {
+                continue;
+            }
+
+            const glm::dvec3 edge = p[(corner + 1) % 3] - p[corner];
+            const double edgeLength = glm::length(edge);
+
+            if (edgeLength == 0.0)
+            {
+                continue;
+            }
+
+            const glm::dvec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+            const double borderWeight = s_BorderWeight * edgeLength * edgeLength;
+            quadrics[a].AddPlane(borderNormal, -glm::dot(borderNormal, p[corner]), borderWeight);
+            quadrics[b].AddPlane(borderNormal, -glm::dot(borderNormal, p[corner]), borderWeight);
+        }
+    }
+
+    //closest normal among the vertices of a position, for the vertices moved onto it:
+    auto closestVertex = [&](uint32_t vertex, uint32_t group, float* alignment) {
+        uint32_t best = sortedVertices[groupOffsets[group]];
+        float bestAlignment = hasNormals ? glm::dot(normals[vertex], normals[best]) : 1.0f;
+
+        for (uint32_t i = groupOffsets[group] + 1; i < groupOffsets[group + 1] && hasNormals; ++i)
+        {
+            const float candidateAlignment = glm::dot(normals[vertex], normals[sortedVertices[i]]);
+
+            if (candidateAlignment > bestAlignment)
+            {
+                bestAlignment = candidateAlignment;
+                best = sortedVertices[i];
+            }
+        }
+
+        if (alignment)
+        {
+            *alignment = bestAlignment;
+        }
+
+        return best;
+    };
+
+    const double maxCost = double(maxError) * double(maxError);
+
+    std::vector<uint32_t> adjacencyOffsets(groupCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(groupCount);
+    std::vector<uint32_t> vertexRemap(vertexCount);
+
+    //every pass applies the cheapest collapses that do not share any triangle, then rebuilds the triangles:
+    while (result.size() > targetIndexCount)
+    {
+        const std::size_t triangleCount = result.size() / 3;
+
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (const uint32_t vertex : result)
+        {
+            ++adjacencyOffsets[groups[vertex] + 1];
+        }
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (std::size_t i = 0; i < result.size(); ++i)
+            {
+                adjacency[fillOffsets[groups[result[i]]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        edgeUses.clear();
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                ++edgeUses[EdgeKey(groups[result[i + corner]], groups[result[i + (corner + 1) % 3]])];
+            }
+        }
+
+        auto evaluate = [&](uint32_t from, uint32_t to, Collapse& collapse) {
+            const bool border = !edgeUses.contains(EdgeKey(to, from)) || !edgeUses.contains(EdgeKey(from, to));
+
+            if (kinds[from] == PositionKind::Locked || (kinds[from] == PositionKind::Border && (!border || kinds[to] == PositionKind::Manifold)))
+            {
+                return false;
+            }
+
+            const glm::dvec3 target = groupPosition(to);
+            const double errorSquared = CollapseError(quadrics[from], quadrics[to], target);
+            const double lengthSquared = glm::dot(target - groupPosition(from), target - groupPosition(from));
+
+            double normalPenalty = 0.0;
+            for (uint32_t i = groupOffsets[from]; i < groupOffsets[from + 1]; ++i)
+            {
+                float alignment;
+                closestVertex(sortedVertices[i], to, &alignment);
+                normalPenalty = std::max(normalPenalty, s_NormalWeight * (1.0 - alignment) * lengthSquared);
+            }
+
+            collapse = Collapse{ from, to, errorSquared + normalPenalty, errorSquared, border };
+            return true;
+        };
+
+        collapses.clear();
+        for (std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t a = groups[result[i + corner]];
+                const uint32_t b = groups[result[i + (corner + 1) % 3]];
+
+                //interior edges are seen from both of their triangles, only one of them evaluates the edge:
+                if (a == b || (a > b && edgeUses.contains(EdgeKey(b, a))))
+                {
+                    continue;
+                }
+
+                Collapse ab, ba;
+                const bool canCollapseAB = evaluate(a, b, ab);
+                const bool canCollapseBA = evaluate(b, a, ba);
+
+                if (canCollapseAB || canCollapseBA)
+                {
+                    collapses.push_back(canCollapseAB && (!canCollapseBA || ab.cost <= ba.cost) ? ab : ba);
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::fill(touched.begin(), touched.end(), false);
+        std::iota(vertexRemap.begin(), vertexRemap.end(), 0);
+
+        const std::size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+        std::size_t trianglesRemoved = 0;
+        std::size_t applied = 0;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (trianglesRemoved >= trianglesToRemove || collapse.cost > maxCost)
+            {
+                break;
+            }
+
+            if (touched[collapse.from] || touched[collapse.to])
+            {
+                continue;
+            }
+
+            //the triangles that keep existing must not flip once the position moved:
+            const glm::dvec3 target = groupPosition(collapse.to);
+            bool flips = false;
+
+            for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && !flips; ++i)
+            {
+                const std::size_t triangle = adjacency[i];
+                const uint32_t corners[3] = { groups[result[triangle * 3]], groups[result[triangle * 3 + 1]], groups[result[triangle * 3 + 2]] };
+
+                if (corners[0] == collapse.to || corners[1] == collapse.to || corners[2] == collapse.to)
+                {
+                    continue;
+                }
+
+                glm::dvec3 p[3] = { groupPosition(corners[0]), groupPosition(corners[1]), groupPosition(corners[2]) };
+                const glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    if (corners[corner] == collapse.from)
+                    {
+                        p[corner] = target;
+                    }
+                }
+
+                const glm::dvec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                flips = glm::dot(before, after) <= s_MinFlipCosine * glm::length(before) * glm::length(after);
+            }
+
+            if (flips)
+            {
+                continue;
+            }
+
+            //every triangle around the moved position changes, none of their positions may move again in this pass:
+            for (uint32_t i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1]; ++i)
+            {
+                const std::size_t triangle = adjacency[i];
+
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                {
+                    touched[groups[result[triangle * 3 + corner]]] = true;
+                }
+            }
+
+            for (uint32_t i = groupOffsets[collapse.from]; i < groupOffsets[collapse.from + 1]; ++i)
+            {
+                vertexRemap[sortedVertices[i]] = closestVertex(sortedVertices[i], collapse.to, nullptr);
+            }
+
+            quadrics[collapse.to].Add(quadrics[collapse.from]);
+            resultError = std::max(resultError, collapse.error);
+            trianglesRemoved += collapse.border ? 1 : 2;
+            ++applied;
+        }
+
+        if (applied == 0)
+        {
+            break;
+        }
+
+        //triangles that lost a position are gone:
+        std::size_t writeIndex = 0;
+        for (std::size_t i = 0; i < triangleCount * 3; i += 3)
+        {
+            const uint32_t a = vertexRemap[result[i]];
+            const uint32_t b = vertexRemap[result[i + 1]];
+            const uint32_t c = vertexRemap[result[i + 2]];
+
+            if (groups[a] == groups[b] || groups[b] == groups[c] || groups[a] == groups[c])
+            {
+                continue;
+            }
+
+            result[writeIndex++] = a;
+            result[writeIndex++] = b;
+            result[writeIndex++] = c;
+        }
+        result.resize(writeIndex);
+    }
+
+    if (error)
+    {
+        *error = static_cast<float>(std::sqrt(resultError));
+    }
+
+    return result;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,500 @@
+#include <objparser.hpp>
+#include <threadpool.hpp>
+#include <memoryarena.hpp>
+#include <virtualfilesystem.hpp>
+#include <charconv>
+#include <cstring>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Chunks smaller than that are not worth a thread
+    constexpr std::size_t s_MinChunkSize = 256 * 1024;
+
+    enum class ObjLine
+    {
+        Vertex,
+        Normal,
+        Texcoord,
+        Face,
+        Other
+    };
+
+    struct ObjChunk
+    {
+        std::string_view text;
+
+        // Counted by the prescan, the arrays are allocated from them before parsing
+        std::size_t vertexCount = 0;
+        std::size_t normalCount = 0;
+        std::size_t texcoordCount = 0;
+        std::size_t faceCount = 0;
+        std::size_t cornerCount = 0;
+        std::size_t triangleIndexCount = 0;
+
+        // Position of the chunk elements in the result, known before parsing so that
+        // the chunk writes its attributes in place and resolves negative indices right away
+        std::size_t vertexBase = 0;
+        std::size_t normalBase = 0;
+        std::size_t texcoordBase = 0;
+        std::size_t indexBase = 0;
+
+        float* vertices = nullptr;
+        float* normals = nullptr;
+        float* texcoords = nullptr;
+
+        // Faces are kept as polygons until every position is known, quads triangulation depends on them
+        std::span<tinyobj::index_t> corners;
+        std::span<uint32_t> faceSizes;
+
+        std::size_t parsedVertexCount = 0;
+        std::size_t parsedNormalCount = 0;
+        std::size_t parsedTexcoordCount = 0;
+        std::size_t parsedFaceCount = 0;
+        std::size_t parsedCornerCount = 0;
+
+        std::string error;
+    };
+
+    inline const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline bool ParseFloat(const char*& p, const char* end, float& value)
+    {
+        p = SkipSpaces(p, end);
+
+        if (p < end && *p == '+')
+        {
+            ++p;
+        }
+
+        const std::from_chars_result result = std::from_chars(p, end, value);
+
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+
+        p = result.ptr;
+        return true;
+    }
+
+    // count is the number of elements read so far in the whole file, negative indices are relative to it
+    inline bool ParseIndex(const char*& p, const char* end, std::size_t count, int& index)
+    {
+        int value = 0;
+
+        const std::from_chars_result result = std::from_chars(p, end, value);
+
+        if (result.ec != std::errc() || value == 0)
+        {
+            return false;
+        }
+
+        p = result.ptr;
+        index = value > 0 ? value - 1 : static_cast<int>(count) + value;
+
+        return true;
+    }
+
+    // v, v/vt, v//vn or v/vt/vn
+    bool ParseCorner(const char*& p, const char* end, ObjChunk& chunk)
+    {
+        tinyobj::index_t index = { -1, -1, -1 };
+
+        if (chunk.parsedCornerCount == chunk.corners.size() ||
+            !ParseIndex(p, end, chunk.vertexBase + chunk.parsedVertexCount, index.vertex_index))
+        {
+            return false;
+        }
+
+        if (p < end && *p == '/')
+        {
+            ++p;
+
+            if (p < end && *p != '/')
+            {
+                if (!ParseIndex(p, end, chunk.texcoordBase + chunk.parsedTexcoordCount, index.texcoord_index))
+                {
+                    return false;
+                }
+            }
+
+            if (p < end && *p == '/')
+            {
+                ++p;
+
+                if (!ParseIndex(p, end, chunk.normalBase + chunk.parsedNormalCount, index.normal_index))
+                {
+                    return false;
+                }
+            }
+        }
+
+        chunk.corners[chunk.parsedCornerCount++] = index;
+
+        return true;
+    }
+
+    // The prescan and the parser must agree on the kind of every line
+    inline ObjLine ClassifyLine(const char*& p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+
+        if (end - p < 2)
+        {
+            return ObjLine::Other;
+        }
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ++p;
+            return ObjLine::Vertex;
+        }
+        if (p[0] == 'v' && p[1] == 'n')
+        {
+            p += 2;
+            return ObjLine::Normal;
+        }
+        if (p[0] == 'v' && p[1] == 't')
+        {
+            p += 2;
+            return ObjLine::Texcoord;
+        }
+        if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            ++p;
+            return ObjLine::Face;
+        }
+
+        // Groups, materials, lines and points are not needed by the visualizer
+        return ObjLine::Other;
+    }
+
+    template<typename Function>
+    void ForEachLine(std::string_view text, Function&& function)
+    {
+        const char* p = text.data();
+        const char* end = p + text.size();
+
+        while (p < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+
+            if (!lineEnd)
+            {
+                lineEnd = end;
+            }
+
+            if (!function(p, lineEnd))
+            {
+                return;
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    // Counts the elements of the chunk without parsing any number
+    void PrescanChunk(ObjChunk& chunk)
+    {
+        ForEachLine(chunk.text, [&chunk](const char* p, const char* end)
+        {
+            switch (ClassifyLine(p, end))
+            {
+            case ObjLine::Vertex: ++chunk.vertexCount; break;
+            case ObjLine::Normal: ++chunk.normalCount; break;
+            case ObjLine::Texcoord: ++chunk.texcoordCount; break;
+            case ObjLine::Face:
+            {
+                std::size_t cornerCount = 0;
+
+                for (p = SkipSpaces(p, end); p < end; p = SkipSpaces(p, end))
+                {
+                    while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+                    {
+                        ++p;
+                    }
+                    ++cornerCount;
+                }
+
+                ++chunk.faceCount;
+                chunk.cornerCount += cornerCount;
+
+                if (cornerCount >= 3)
+                {
+                    chunk.triangleIndexCount += 3 * (cornerCount - 2);
+                }
+                break;
+            }
+            case ObjLine::Other: break;
+            }
+
+            return true;
+        });
+    }
+
+    bool ParseLine(const char* p, const char* end, ObjChunk& chunk)
+    {
+        switch (ClassifyLine(p, end))
+        {
+        case ObjLine::Vertex:
+        {
+            float* vertex = chunk.vertices + 3 * chunk.parsedVertexCount;
+
+            // Optional w or vertex colors are ignored
+            if (chunk.parsedVertexCount == chunk.vertexCount ||
+                !ParseFloat(p, end, vertex[0]) || !ParseFloat(p, end, vertex[1]) || !ParseFloat(p, end, vertex[2]))
+            {
+                return false;
+            }
+
+            ++chunk.parsedVertexCount;
+            break;
+        }
+        case ObjLine::Normal:
+        {
+            float* normal = chunk.normals + 3 * chunk.parsedNormalCount;
+
+            if (chunk.parsedNormalCount == chunk.normalCount ||
+                !ParseFloat(p, end, normal[0]) || !ParseFloat(p, end, normal[1]) || !ParseFloat(p, end, normal[2]))
+            {
+                return false;
+            }
+
+            ++chunk.parsedNormalCount;
+            break;
+        }
+        case ObjLine::Texcoord:
+        {
+            float* texcoord = chunk.texcoords + 2 * chunk.parsedTexcoordCount;
+
+            if (chunk.parsedTexcoordCount == chunk.texcoordCount || !ParseFloat(p, end, texcoord[0]))
+            {
+                return false;
+            }
+
+            texcoord[1] = 0.0f;
+            ParseFloat(p, end, texcoord[1]);
+
+            ++chunk.parsedTexcoordCount;
+            break;
+        }
+        case ObjLine::Face:
+        {
+            uint32_t cornerCount = 0;
+
+            for (p = SkipSpaces(p, end); p < end; p = SkipSpaces(p, end))
+            {
+                if (!ParseCorner(p, end, chunk))
+                {
+                    return false;
+                }
+                ++cornerCount;
+            }
+
+            if (chunk.parsedFaceCount == chunk.faceSizes.size())
+            {
+                return false;
+            }
+
+            chunk.faceSizes[chunk.parsedFaceCount++] = cornerCount;
+            break;
+        }
+        case ObjLine::Other: break;
+        }
+
+        return true;
+    }
+
+    void ParseChunk(ObjChunk& chunk)
+    {
+        ForEachLine(chunk.text, [&chunk](const char* p, const char* end)
+        {
+            if (!ParseLine(p, end, chunk))
+            {
+                chunk.error = "invalid line: " + std::string(p, end);
+                return false;
+            }
+
+            return true;
+        });
+    }
+
+    inline float SquaredDistance(const std::vector<float>& vertices, int a, int b)
+    {
+        const float dx = vertices[3 * b + 0] - vertices[3 * a + 0];
+        const float dy = vertices[3 * b + 1] - vertices[3 * a + 1];
+        const float dz = vertices[3 * b + 2] - vertices[3 * a + 2];
+
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    void TriangulateChunk(ObjChunk& chunk, ObjData& result)
+    {
+        const int vertexCount = static_cast<int>(result.vertices.size() / 3);
+        const int normalCount = static_cast<int>(result.normals.size() / 3);
+        const int texcoordCount = static_cast<int>(result.texcoords.size() / 2);
+
+        tinyobj::index_t* output = result.indices.data() + chunk.indexBase;
+        const tinyobj::index_t* corner = chunk.corners.data();
+
+        for (uint32_t faceSize : chunk.faceSizes)
+        {
+            const tinyobj::index_t* face = corner;
+            corner += faceSize;
+
+            if (faceSize < 3)
+            {
+                continue;
+            }
+
+            for (uint32_t i = 0; i < faceSize; ++i)
+            {
+                if (face[i].vertex_index < 0 || face[i].vertex_index >= vertexCount ||
+                    face[i].normal_index < -1 || face[i].normal_index >= normalCount ||
+                    face[i].texcoord_index < -1 || face[i].texcoord_index >= texcoordCount)
+                {
+                    chunk.error = "face with invalid index " + std::to_string(face[i].vertex_index) + '/' + std::to_string(face[i].texcoord_index) + '/' + std::to_string(face[i].normal_index);
+                    return;
+                }
+            }
+
+            if (faceSize == 4)
+            {
+                // Split along the shortest diagonal like tinyobj
+                if (SquaredDistance(result.vertices, face[0].vertex_index, face[2].vertex_index) <
+                    SquaredDistance(result.vertices, face[1].vertex_index, face[3].vertex_index))
+                {
+                    *output++ = face[0]; *output++ = face[1]; *output++ = face[2];
+                    *output++ = face[0]; *output++ = face[2]; *output++ = face[3];
+                }
+                else
+                {
+                    *output++ = face[0]; *output++ = face[1]; *output++ = face[3];
+                    *output++ = face[1]; *output++ = face[2]; *output++ = face[3];
+                }
+            }
+            else
+            {
+                for (uint32_t i = 1; i + 1 < faceSize; ++i)
+                {
+                    *output++ = face[0]; *output++ = face[i]; *output++ = face[i + 1];
+                }
+            }
+        }
+    }
+}
+
+bool ParseObjFile(const std::string& inputFile, ObjData& result, uint32_t threadCount)
+{
+    AssetFile file;
+
+    if (!VirtualFileSystem::GetInstance().Open(inputFile, file))
+    {
+        std::cerr << "Cannot open file : " << inputFile << '\n';
+        return false;
+    }
+
+    return ParseObj(file.GetView(), result, threadCount);
+}
+
+bool ParseObj(std::string_view text, ObjData& result, uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const std::size_t chunkCount = std::clamp<std::size_t>(text.size() / s_MinChunkSize, 1, threadCount);
+
+    // Split in newline aligned chunks
+    std::vector<ObjChunk> chunks(chunkCount);
+    std::size_t chunkStart = 0;
+
+    for (std::size_t i = 0; i < chunkCount; ++i)
+    {
+        std::size_t chunkEnd = (i + 1 == chunkCount) ? text.size() : std::max(chunkStart, text.size() * (i + 1) / chunkCount);
+
+        if (chunkEnd < text.size())
+        {
+            const std::size_t newLine = text.find('\n', chunkEnd);
+            chunkEnd = (newLine == std::string_view::npos) ? text.size() : newLine + 1;
+        }
+
+        chunks[i].text = text.substr(chunkStart, chunkEnd - chunkStart);
+        chunkStart = chunkEnd;
+    }
+
+    ParallelFor(chunkCount, [&chunks](std::size_t i) { PrescanChunk(chunks[i]); });
+
+    // Chunk bases follow the file order so that the merged result is deterministic
+    std::size_t vertexCount = 0, normalCount = 0, texcoordCount = 0, indexCount = 0, faceCount = 0, cornerCount = 0;
+
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.vertexBase = vertexCount;
+        chunk.normalBase = normalCount;
+        chunk.texcoordBase = texcoordCount;
+        chunk.indexBase = indexCount;
+
+        vertexCount += chunk.vertexCount;
+        normalCount += chunk.normalCount;
+        texcoordCount += chunk.texcoordCount;
+        indexCount += chunk.triangleIndexCount;
+        faceCount += chunk.faceCount;
+        cornerCount += chunk.cornerCount;
+    }
+
+    //the result arrays get their final size once, the chunks parse straight into them:
+    result.vertices.resize(3 * vertexCount);
+    result.normals.resize(3 * normalCount);
+    result.texcoords.resize(2 * texcoordCount);
+    result.indices.resize(indexCount);
+
+    //the polygons only live until they are triangulated, they all go in one arena released on return:
+    MemoryArena arena(chunkCount * (MemoryArena::GetArraySize<tinyobj::index_t>(0) + MemoryArena::GetArraySize<uint32_t>(0)) +
+                      cornerCount * sizeof(tinyobj::index_t) + faceCount * sizeof(uint32_t));
+
+    for (ObjChunk& chunk : chunks)
+    {
+        chunk.vertices = result.vertices.data() + 3 * chunk.vertexBase;
+        chunk.normals = result.normals.data() + 3 * chunk.normalBase;
+        chunk.texcoords = result.texcoords.data() + 2 * chunk.texcoordBase;
+        chunk.corners = arena.AllocateArray<tinyobj::index_t>(chunk.cornerCount);
+        chunk.faceSizes = arena.AllocateArray<uint32_t>(chunk.faceCount);
+    }
+
+    ParallelFor(chunkCount, [&chunks](std::size_t i) { ParseChunk(chunks[i]); });
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (!chunk.error.empty())
+        {
+            std::cerr << "ParseObj: " << chunk.error << '\n';
+            return false;
+        }
+    }
+
+    ParallelFor(chunkCount, [&chunks, &result](std::size_t i) { TriangulateChunk(chunks[i], result); });
+
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (!chunk.error.empty())
+        {
+            std::cerr << "ParseObj: " << chunk.error << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,314 @@
+#include <utils.hpp>
+#include <palmgenerator.hpp>
+#include <meshimport.hpp>
+#include <meshlet.hpp>
+#include <random>
+
+#pragma warning(push, 0)
+#include <glm/gtc/constants.hpp>
+#pragma warning(pop, 0)
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Angle the leaflets hang down by from the plane of their frond, radians
+    constexpr float s_LeafletFold = 0.35f;
+    // Golden angle, so that neighbouring fronds never vary the same way
+    constexpr float s_FrondWobbleStep = 2.39996f;
+
+    struct PalmDetail
+    {
+        uint32_t rings;
+        uint32_t sides;
+        uint32_t leaflets;
+    };
+
+    PalmDetail GetPalmDetail(const PalmParameters& parameters, uint32_t level)
+    {
+        return PalmDetail{
+            std::max(1u, parameters.trunkSegments >> level),
+            std::max(3u, parameters.trunkSides >> ((level + 1) / 2)),
+            std::max(1u, parameters.frondSegments >> level)
+        };
+    }
+
+    // Largest distance between the trunk and the fronds of a level and the smooth palm they approximate
+    glm::vec2 GetPalmDeviation(const PalmParameters& parameters, const PalmDetail& detail)
+    {
+        //sagitta of the chords around the trunk section and along the bent axis:
+        const float trunkBend = std::atan(2.0f * parameters.trunkCurvature);
+        const float trunk = parameters.trunkRadius * (1.0f - std::cos(glm::pi<float>() / detail.sides))
+                          + parameters.trunkHeight * trunkBend / (8.0f * detail.rings * detail.rings);
+
+        //sagitta of the chords along the spine, plus the outline of the leaflets which moves by about a quarter of their spacing:
+        const float fronds = parameters.frondLength * parameters.frondDroop / (8.0f * detail.leaflets * detail.leaflets)
+                           + 0.25f * parameters.frondLength / detail.leaflets;
+
+        return glm::vec2(trunk, fronds);
+    }
+
+    void AddTrunk(const PalmParameters& parameters, const PalmDetail& detail, const glm::vec3& color,
+                  std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices)
+    {
+        const glm::vec3 up(0.0f, 1.0f, 0.0f);
+        const glm::vec3 bend(std::cos(parameters.bendAzimuth), 0.0f, std::sin(parameters.bendAzimuth));
+        const glm::vec3 side(-bend.z, 0.0f, bend.x);
+        const uint32_t firstVertex = static_cast<uint32_t>(vertices.size());
+        const float bendHeight = parameters.trunkCurvature * parameters.trunkHeight;
+
+        for (uint32_t ring = 0; ring <= detail.rings; ++ring)
+        {
+            const float t = static_cast<float>(ring) / detail.rings;
+            const glm::vec3 center = bend * (bendHeight * t * t) + up * (parameters.trunkHeight * t);
+            const glm::vec3 axis = glm::normalize(bend * (2.0f * bendHeight * t) + up * parameters.trunkHeight);
+            // (normal, side, axis) is direct, the quads below then face outwards
+            const glm::vec3 normal = glm::normalize(glm::cross(side, axis));
+            const float radius = parameters.trunkRadius * (1.0f - (1.0f - parameters.trunkTaper) * t);
+
+            for (uint32_t j = 0; j < detail.sides; ++j)
+            {
+                const float angle = 2.0f * glm::pi<float>() * j / detail.sides;
+                const glm::vec3 radial = std::cos(angle) * normal + std::sin(angle) * side;
+                vertices.push_back(VertexDataPosition3fNormal3fColor3f{ center + radial * radius, radial, color });
+            }
+        }
+
+        for (uint32_t ring = 0; ring < detail.rings; ++ring)
+        {
+            for (uint32_t j = 0; j < detail.sides; ++j)
+            {
+                const uint32_t v00 = firstVertex + ring * detail.sides + j;
+                const uint32_t v01 = firstVertex + ring * detail.sides + (j + 1) % detail.sides;
+                const uint32_t v10 = v00 + detail.sides;
+                const uint32_t v11 = v01 + detail.sides;
+                indices.insert(indices.end(), { v00, v01, v10, v01, v11, v10 });
+            }
+        }
+    }
+
+    // Flat shaded, every triangle gets its own vertices
+    void AddFlatTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& color,
+                         std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices)
+    {
+        const glm::vec3 normal = glm::cross(b - a, c - a);
+        const float length = glm::length(normal);
+
+        if (length <= 0.0f)
+        {
+            return;
+        }
+
+        const uint32_t first = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(VertexDataPosition3fNormal3fColor3f{ a, normal / length, color });
+        vertices.push_back(VertexDataPosition3fNormal3fColor3f{ b, normal / length, color });
+        vertices.push_back(VertexDataPosition3fNormal3fColor3f{ c, normal / length, color });
+        indices.insert(indices.end(), { first, first + 1, first + 2 });
+    }
+
+    // Appends the back faces of the flat triangles from firstIndex on, with reversed windings and normals
+    void AddBackFaces(std::size_t firstIndex, std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices)
+    {
+        const std::size_t lastIndex = indices.size();
+
+        for (std::size_t i = firstIndex; i < lastIndex; i += 3)
+        {
+            const uint32_t back = static_cast<uint32_t>(vertices.size());
+
+            for (uint32_t corner = 0; corner < 3; ++corner)
+            {
+                VertexDataPosition3fNormal3fColor3f vertex = vertices[indices[i + corner]];
+                vertex.normal = -vertex.normal;
+                vertices.push_back(vertex);
+            }
+
+            indices.insert(indices.end(), { back, back + 2, back + 1 });
+        }
+    }
+
+    void AddFronds(const PalmParameters& parameters, const PalmDetail& detail, const glm::vec3& color,
+                   std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices)
+    {
+        const glm::vec3 up(0.0f, 1.0f, 0.0f);
+        const glm::vec3 bend(std::cos(parameters.bendAzimuth), 0.0f, std::sin(parameters.bendAzimuth));
+        const glm::vec3 top = bend * (parameters.trunkCurvature * parameters.trunkHeight) + up * parameters.trunkHeight;
+
+        for (uint32_t frond = 0; frond < parameters.frondCount; ++frond)
+        {
+            const float wobble = std::sin(s_FrondWobbleStep * frond + parameters.frondPhase);
+            const float azimuth = parameters.frondPhase + 2.0f * glm::pi<float>() * frond / parameters.frondCount;
+            const glm::vec3 heading(std::cos(azimuth), 0.0f, std::sin(azimuth));
+            const glm::vec3 side(-heading.z, 0.0f, heading.x);
+            const float length = parameters.frondLength * (1.0f + 0.1f * wobble);
+            const float elevation = parameters.frondElevation + 0.15f * wobble;
+            const float step = length / detail.leaflets;
+
+            glm::vec3 root = top;
+            const std::size_t firstIndex = indices.size();
+
+            for (uint32_t leaflet = 0; leaflet < detail.leaflets; ++leaflet)
+            {
+                //the spine turns down at a constant rate, every segment follows the direction at its middle:
+                const float along = (leaflet + 0.5f) / detail.leaflets;
+                const float pitch = elevation - parameters.frondDroop * along;
+                const glm::vec3 direction = std::cos(pitch) * heading + std::sin(pitch) * up;
+                const glm::vec3 next = root + direction * step;
+
+                //the leaflets are the longest halfway along the frond and hang down a little on both sides:
+                const float width = parameters.frondWidth * std::sin(glm::pi<float>() * (0.1f + 0.9f * along));
+                const glm::vec3 middle = (root + next) * 0.5f + direction * (0.3f * width);
+
+                for (const float sign : { -1.0f, 1.0f })
+                {
+                    const glm::vec3 tip = middle + (side * (sign * std::cos(s_LeafletFold)) - up * std::sin(s_LeafletFold)) * width;
+                    AddFlatTriangle(root, next, tip, color, vertices, indices);
+                }
+
+                root = next;
+            }
+
+            //the back faces follow the whole front of the frond so that its meshlets keep to one side and can be backface culled:
+            AddBackFaces(firstIndex, vertices, indices);
+        }
+    }
+}
+
+PalmParameters GetPalmVariant(const PalmGeneratorSettings& settings, uint32_t variant)
+{
+    PalmParameters parameters = settings.parameters;
+
+    if (variant == 0)
+    {
+        return parameters;
+    }
+
+    std::mt19937 random(settings.seed + variant * 0x9E3779B9u);
+    std::uniform_real_distribution<float> spread(-settings.variation, settings.variation);
+    std::uniform_real_distribution<float> azimuth(0.0f, 2.0f * glm::pi<float>());
+    std::uniform_int_distribution<int> frondDelta(-1, 1);
+
+    parameters.trunkHeight *= 1.0f + spread(random);
+    parameters.trunkCurvature *= 1.0f + 2.0f * spread(random);
+    parameters.bendAzimuth = azimuth(random);
+    parameters.frondCount = static_cast<uint32_t>(std::max(3, static_cast<int>(parameters.frondCount) + frondDelta(random)));
+    parameters.frondPhase = azimuth(random);
+    parameters.frondLength *= 1.0f + spread(random);
+    parameters.frondElevation *= 1.0f + spread(random);
+    parameters.frondDroop *= 1.0f + spread(random);
+
+    return parameters;
+}
+
+void GeneratePalm(const PalmParameters& parameters, uint32_t lodCount, const glm::vec3& color,
+                  std::vector<VertexDataPosition3fNormal3fColor3f>& vertices, std::vector<uint32_t>& indices, std::vector<MeshLod>& lods)
+{
+    const glm::vec2 fullDeviation = GetPalmDeviation(parameters, GetPalmDetail(parameters, 0));
+
+    for (uint32_t level = 0; level < lodCount; ++level)
+    {
+        const PalmDetail detail = GetPalmDetail(parameters, level);
+
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+
+        AddTrunk(parameters, detail, color, vertices, indices);
+        AddFronds(parameters, detail, color, vertices, indices);
+
+        const glm::vec2 deviation = GetPalmDeviation(parameters, detail) - fullDeviation;
+        lod.indexCount = static_cast<uint32_t>(indices.size()) - lod.firstIndex;
+        lod.error = std::max({ 0.0f, deviation.x, deviation.y });
+        lods.push_back(lod);
+    }
+}
+
+void GeneratePalmMesh(MeshImport& import, const PalmGeneratorSettings& settings)
+{
+    import.start = std::chrono::steady_clock::now();
+
+    const uint32_t variantCount = std::max(1u, settings.variantCount);
+    const uint32_t lodCount = std::clamp(settings.lodCount, 1u, s_MaxMeshLodCount);
+
+    std::vector<VertexDataPosition3fNormal3fColor3f> vertices;
+    std::vector<uint32_t> indices;
+    import.lods.clear();
+    import.meshlets.clear();
+    import.variantMeshlets.clear();
+
+    for (uint32_t variant = 0; variant < variantCount; ++variant)
+    {
+        GeneratePalm(GetPalmVariant(settings, variant), lodCount, import.settings.color, vertices, indices, import.lods);
+    }
+
+    //the meshlets of every variant follow each other, each variant culls its own range:
+    if (import.settings.meshlets)
+    {
+        std::vector<glm::vec3> positions(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const VertexDataPosition3fNormal3fColor3f& vertex) { return vertex.position; });
+
+        import.variantMeshlets.push_back(0);
+
+        for (uint32_t variant = 0; variant < variantCount; ++variant)
+        {
+            const MeshLod& full = import.lods[variant * lodCount];
+            std::vector<Meshlet> meshlets = BuildMeshlets(std::span<uint32_t>(indices).subspan(full.firstIndex, full.indexCount), positions);
+
+            for (Meshlet& meshlet : meshlets)
+            {
+                meshlet.firstIndex += full.firstIndex;
+            }
+
+            import.meshlets.insert(import.meshlets.end(), meshlets.begin(), meshlets.end());
+            import.variantMeshlets.push_back(static_cast<uint32_t>(import.meshlets.size()));
+        }
+    }
+
+    std::vector<uint32_t> lodStarts;
+    for (const MeshLod& lod : import.lods)
+    {
+        lodStarts.push_back(lod.firstIndex);
+    }
+
+    const std::size_t vertexCount = vertices.size();
+    const std::size_t triangleCount = import.lods.front().indexCount / 3;
+
+    import.variantCount = variantCount;
+    import.indexLayout = ChooseIndexLayout(indices, lodStarts);
+    import.mesh = MeshData::FromBuffers(std::move(vertices), std::move(indices));
+    import.mesh.SetLods(std::vector<MeshLod>(import.lods));
+    import.mesh.SetMeshlets(std::vector<Meshlet>(import.meshlets));
+    import.bounds = import.mesh.GetBounds();
+    import.vertexLayout = ChooseVertexLayout(import, import.bounds);
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - import.start;
+    std::cout << import.name << " generated in " << elapsed.count() << " ms: " << variantCount << " variants of " << lodCount << " levels, "
+              << vertexCount << " vertices, " << triangleCount << " triangles at full detail" << std::endl;
+}
+
+uint64_t HashPalmGeneratorSettings(const PalmGeneratorSettings& settings)
+{
+    const PalmParameters& parameters = settings.parameters;
+    uint64_t hash = s_HashSeed;
+
+    HashBytes(hash, &parameters.trunkHeight, sizeof(float));
+    HashBytes(hash, &parameters.trunkRadius, sizeof(float));
+    HashBytes(hash, &parameters.trunkTaper, sizeof(float));
+    HashBytes(hash, &parameters.trunkCurvature, sizeof(float));
+    HashBytes(hash, &parameters.bendAzimuth, sizeof(float));
+    HashBytes(hash, &parameters.trunkSegments, sizeof(uint32_t));
+    HashBytes(hash, &parameters.trunkSides, sizeof(uint32_t));
+    HashBytes(hash, &parameters.frondCount, sizeof(uint32_t));
+    HashBytes(hash, &parameters.frondPhase, sizeof(float));
+    HashBytes(hash, &parameters.frondLength, sizeof(float));
+    HashBytes(hash, &parameters.frondWidth, sizeof(float));
+    HashBytes(hash, &parameters.frondElevation, sizeof(float));
+    HashBytes(hash, &parameters.frondDroop, sizeof(float));
+    HashBytes(hash, &parameters.frondSegments, sizeof(uint32_t));
+    HashBytes(hash, &settings.variantCount, sizeof(uint32_t));
+    HashBytes(hash, &settings.lodCount, sizeof(uint32_t));
+    HashBytes(hash, &settings.seed, sizeof(uint32_t));
+    HashBytes(hash, &settings.variation, sizeof(float));
+
+    return hash;
+}
+
+END_VISUALIZER_NAMESPACE
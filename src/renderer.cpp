@@ -13,9 +13,21 @@
 #include <utils.hpp>
 #include <glutils.hpp>
 #include <camera.hpp>
+#include <mesh.hpp>
+#include <meshimport.hpp>
+#include <meshcache.hpp>
+#include <cubemap.hpp>
+#include <virtualfilesystem.hpp>
+#include <assetpipeline.hpp>
+#include <assetprefetch.hpp>
+#include <threadpool.hpp>
+#include <impostor.hpp>
+#include <palmgenerator.hpp>
 #include <renderer.hpp>
-#include <thread>
-#include <future>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <numeric>
 
 #include "stb_image.hpp"
 
@@ -58,8 +70,12 @@ unsigned int skyboxIndices[] =
 
 STBIImgInfo LoadImg(std::string dirpath, std::string filename)
 {
-    STBIImgInfo info;
-    info.data = stbi_load((dirpath + filename).c_str(), &(info.width), &(info.height), &(info.nrChannels), 0);
+    STBIImgInfo info = {};
+    AssetFile file;
+    if (!LoadFile(dirpath + filename, file))
+        return info;
+    //decoded straight from the mapping, stb_image never opens the file itself:
+    info.data = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &(info.width), &(info.height), &(info.nrChannels), 0);
     if (info.data) {
         stbi_set_flip_vertically_on_load(false);
         std::cout << "texture loaded: " << filename << std::endl;
@@ -70,60 +86,112 @@ STBIImgInfo LoadImg(std::string dirpath, std::string filename)
     return info;
 }
 
-void LoadDesert(std::vector<int> *indices, std::vector<VertexDataPosition3fColor3f> *vertices)
-{
-    //load obj:
-    tinyobj::ObjReader desert = LoadObjFile("../../res/desert.obj");
-    std::cout << "desert load" << std::endl;
-    std::cout << "desert shape nb: " << desert.GetShapes().size() << std::endl;
-    std::cout << "desert number of vertices: " << desert.GetAttrib().GetVertices().size() << std::endl;
-    std::cout << "desert number of indices: " << desert.GetShapes()[0].mesh.indices.size() << std::endl;
-    std::cout << "desert number of colors: " << desert.GetAttrib().colors.size() << std::endl;
-    std::cout << "desert number of normals: " << desert.GetAttrib().normals.size() << std::endl;
-    std::cout << "desert number of texcoords: " << desert.GetAttrib().texcoords.size() << std::endl;
-    //init buffer:
-    for (std::vector<tinyobj::index_t>::const_iterator i = desert.GetShapes()[0].mesh.indices.begin(); i != desert.GetShapes()[0].mesh.indices.end(); ++i)
-        indices->push_back(i->vertex_index);
-    for (std::vector<tinyobj::real_t>::const_iterator v = desert.GetAttrib().GetVertices().begin(); v != desert.GetAttrib().GetVertices().end(); v += 3)
-        vertices->push_back(VertexDataPosition3fColor3f {
-            glm::vec3 {
-                *v,
-                *(v + 1),
-                *(v + 2)
-            }, glm::vec3 {
-                0.31,
-                0.34,
-                0.04
-            }
-        });
+InstanceData LoadInstances(const std::string& name, const std::string& inputFile)
+{
+    const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+    InstanceData instances;
+    FileStamp stamp;
+    const bool hasStamp = VirtualFileSystem::GetInstance().GetFileStamp(inputFile, stamp);
+
+    //map the binary instance file if it is still up to date:
+    if (hasStamp && LoadInstanceFile(GetInstanceFilePath(inputFile), instances, &stamp))
+    {
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << " instances mapped in " << elapsed.count() << " ms" << std::endl;
+        return instances;
+    }
+
+    instances = InstanceData::FromBuffer(LoadTransfoFile(inputFile));
+
+    if (hasStamp && !WriteInstanceFile(GetInstanceFilePath(inputFile), instances.GetStreams(), &stamp))
+        std::cerr << name << ": couldn't write instance file" << std::endl;
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << " instances parsed in " << elapsed.count() << " ms" << std::endl;
+    return instances;
 }
 
-void LoadPalm(std::vector<int> *indices, std::vector<VertexDataPosition3fColor3f> *vertices)
-{
-    //load obj:
-    tinyobj::ObjReader palm = LoadObjFile("../../res/palm.obj");
-    std::cout << "palm load" << std::endl;
-    std::cout << "palm number of shape: " << palm.GetShapes().size() << std::endl;
-    std::cout << "palm number of vertices: " << palm.GetAttrib().GetVertices().size() << std::endl;
-    std::cout << "palm number of indices: " << palm.GetShapes()[0].mesh.indices.size() << std::endl;
-    std::cout << "palm number of colors: " << palm.GetAttrib().colors.size() << std::endl;
-    std::cout << "palm number of normals: " << palm.GetAttrib().normals.size() << std::endl;
-    std::cout << "palm number of texcoords: " << palm.GetAttrib().texcoords.size() << std::endl;
-    //init buffer:
-    for (std::vector<tinyobj::index_t>::const_iterator i = palm.GetShapes()[0].mesh.indices.begin(); i != palm.GetShapes()[0].mesh.indices.end(); ++i)
-        indices->push_back(i->vertex_index);
-    for (std::vector<tinyobj::real_t>::const_iterator v = palm.GetAttrib().GetVertices().begin(); v != palm.GetAttrib().GetVertices().end(); v += 3)
-        vertices->push_back(VertexDataPosition3fColor3f{
-            glm::vec3 {
-                (*v),
-                (*(v + 1)),
-                (*(v + 2))
-            }, glm::vec3 {
-                0.24,
-                0.18,
-                0.01
-            }
-        });
+CubemapImage LoadSkybox(std::string dirpath, std::string filename, bool useCache)
+{
+    const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+    CubemapImage skybox;
+    FileStamp stamp;
+    const std::string sourceFile = dirpath + filename;
+    const bool hasStamp = useCache && VirtualFileSystem::GetInstance().GetFileStamp(sourceFile, stamp);
+
+    //map the raw faces if they are still up to date:
+    if (hasStamp && CubemapImage::LoadCache(GetCubemapCachePath(sourceFile), stamp, skybox))
+    {
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "skybox faces mapped in " << elapsed.count() << " ms" << std::endl;
+        return skybox;
+    }
+
+    //decode the cross once, the faces are uploaded from that single buffer:
+    STBIImgInfo info = LoadImg(dirpath, filename);
+    if (!CubemapImage::FromCross(info.data, info.width, info.height, info.nrChannels, skybox))
+        return skybox;
+
+    if (hasStamp && !skybox.WriteCache(GetCubemapCachePath(sourceFile), stamp))
+        std::cerr << "skybox: couldn't write cube map cache" << std::endl;
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "skybox decoded in " << elapsed.count() << " ms" << std::endl;
+    return skybox;
+}
+
+MeshImportSettings DesertImportSettings()
+{
+    MeshImportSettings settings;
+    settings.color = glm::vec3(0.31f, 0.34f, 0.04f);
+    return settings;
+}
+
+MeshImportSettings PalmImportSettings()
+{
+    MeshImportSettings settings;
+    settings.color = glm::vec3(0.24f, 0.18f, 0.01f);
+    settings.lodCount = 5;
+    return settings;
+}
+
+// Pending copy of a CPU array into GPU buffer storage, spread over as many frames as the upload budget requires
+struct BufferUpload
+{
+    GLuint buffer;
+    std::span<const std::byte> data;
+    std::size_t offset = 0;
+    std::function<void()> onComplete;
+    // Where the data starts in the buffer
+    std::size_t bufferOffset = 0;
+};
+
+constexpr uint32_t s_PlaceholderResolution = 64;
+// Elements under which copying a cached mesh into its mapped storage is not worth a thread
+constexpr std::size_t s_MinCopyVerticesPerThread = 64 * 1024;
+// Wait slice of PollMappedMeshes when it blocks, in nanoseconds
+constexpr GLuint64 s_FenceWaitTimeout = 100'000'000;
+// Fraction of the threshold a level of detail must be under before an instance switches to it from a finer one,
+// instances right at the switching distance would flip between both levels every frame otherwise
+constexpr float s_LodHysteresis = 0.25f;
+// Level of detail of the palm instances drawn as impostors
+constexpr uint8_t s_ImpostorLod = 0xFF;
+// Variants baked into the impostor, as many as the species byte of the instances tells apart
+constexpr uint32_t s_MaxImpostorLayers = 256;
+// Position decodings the default shader holds, the first one being that of the draws made right away
+constexpr std::size_t s_PositionDecodeCount = 4;
+// Decodings the terrain and the palms of the GPU culled scene select
+constexpr uint8_t s_TerrainPositionDecode = 1;
+constexpr uint8_t s_PalmPositionDecode = 2;
+
+// Same rotation around the vertical axis as the instance transform of the shaders
+inline glm::vec3 RotateY(const glm::vec3& v, float angle)
+{
+    const float c = std::cos(angle);
+    const float s = std::sin(angle);
+    return glm::vec3(c * v.x + s * v.z, v.y, c * v.z - s * v.x);
 }
 
 void GenerateSphereMesh(std::vector<VertexDataPosition3fColor3f>& vertices, std::vector<uint16_t>& indices, uint16_t sphereStackCount, uint16_t sphereSectorCount, glm::vec3 sphereCenter, float sphereRadius)
@@ -235,6 +303,61 @@ void GenerateSphereMesh(std::vector<VertexDataPosition3fColor3f>& vertices, std:
     }
 }
 
+struct Renderer::StreamingState
+{
+    ~StreamingState()
+    {
+        //joins the workers before the imports they write to are destroyed:
+        pipeline.Cancel();
+        threadPool.reset();
+
+        for (MappedMesh& mapped : mappedMeshes) {
+            if (mapped.fence) {
+                GL_CALL(glDeleteSync, mapped.fence);
+            }
+        }
+    }
+
+    // GPU storage a mesh is written into by the workers when uploading directly
+    struct MappedMesh
+    {
+        // In the vertex layout of the import
+        void* vertices = nullptr;
+        std::size_t vertexBytes = 0;
+        // In the index layout of the import
+        void* indices = nullptr;
+        std::size_t indexBytes = 0;
+        // Set once the writes are flushed, the mesh is drawn once it is signaled
+        GLsync fence = nullptr;
+        // Set when the storage is allocated but couldn't be mapped, the mesh is then built in memory and goes through the queued uploads
+        bool unmapped = false;
+    };
+
+    std::unique_ptr<ThreadPool> threadPool = std::make_unique<ThreadPool>();
+    AssetPipeline pipeline{ *threadPool };
+    AssetPrefetch prefetch;
+
+    MeshImport meshImports[2];
+    MappedMesh mappedMeshes[2];
+    MeshData placeholder;
+    InstanceData palmInstances;
+    CubemapImage skybox;
+    bool skyboxReady = false;
+    ImpostorAtlas palmImpostor;
+
+    std::deque<BufferUpload> uploads;
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+};
+
+Renderer::Renderer(uint32_t width, uint32_t height, const std::shared_ptr<Camera>& camera, const RendererSettings& settings)
+    : m_ViewportWidth(width)
+    , m_ViewportHeight(height)
+    , m_Camera(camera)
+    , m_Settings(settings)
+{}
+
+Renderer::~Renderer() = default;
+
 void Renderer::ShaderError(GLuint ID, std::string type)
 {
     GLint length = 0;
@@ -289,18 +412,37 @@ GLuint Renderer::InitShader(char const* const vertexSrc, char const* const fragm
     return progID;
 }
 
+GLuint Renderer::InitComputeShader(char const* const computeSrc)
+{
+    GLuint computeShader = GL_CALL(glCreateShader, GL_COMPUTE_SHADER);
+    GL_CALL(glShaderSource, computeShader, 1, &computeSrc, NULL);
+    GL_CALL(glCompileShader, computeShader);
+    ShaderError(computeShader, "Compute");
+    GLuint progID = GL_CALL(glCreateProgram);
+    GL_CALL(glAttachShader, progID, computeShader);
+    GL_CALL(glLinkProgram, progID);
+    ShaderProgramError(progID);
+    GL_CALL(glDetachShader, progID, computeShader);
+    GL_CALL(glDeleteShader, computeShader);
+    return progID;
+}
+
 GLuint Renderer::InitSkyboxShader()
 {
     char const* const vertexSource = R"(#version 330 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec3 inPosition;
 
 out vec3 texCoords;
 
 uniform mat4 projection;
 uniform mat4 view;
+// Decoding of the positions, 16 bit ones relative to the cube bounds in the geometry arena
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 void main()
 {
+    vec3 aPos = positionOffset + inPosition * positionScale;
     vec4 pos = projection * view * vec4(aPos, 1.0f);
     // Having z equal w will always result in a depth of 1.0f
     gl_Position = vec4(pos.x, -pos.y, pos.w, pos.w);
@@ -319,20 +461,20 @@ void main()
     FragColor = texture(skybox, texCoords);
 })";
 
-    GLuint progID = InitShader(vertexSource, fragmentSource);
-    GL_CALL(glUseProgram, progID);
-    GLint location = GL_CALL(glGetUniformLocation, progID, "skybox");
-    GL_CALL(glUniform1i, location, 0);
-    GL_CALL(glUseProgram, 0);
-    return progID;
+    return InitShader(vertexSource, fragmentSource);
 }
 
 GLuint Renderer::InitDefaultShader()
 {
     char const* const vertexSource = R"(#version 450 core
 
-layout(location = 0) in vec3 inWorldPos;
-layout(location = 1) in vec3 inColor;
+// Attributes of the vertex layout of the mesh, see VertexLayout
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inNormal;
+// Instance of the instanced draws, see PackedInstance
+layout(location = 2) in vec3 inInstancePosition;
+layout(location = 3) in vec4 inInstanceScaleRotation;
+layout(location = 4) in vec4 inInstanceTint;
 
 layout(location = 0) smooth out vec3 color;
 
@@ -340,13 +482,56 @@ layout(std140, binding = 0) uniform Matrix
 {
     mat4 modelViewProjection;
 };
+uniform bool instanced;
+// Instance of the other draws
 uniform vec3 transfoModif;
+uniform vec4 instanceScaleRotation;
+uniform vec3 instanceTint;
+uniform vec3 meshColor;
+// Position decodings of the meshes, as many as s_PositionDecodeCount: the instanced draws select theirs with the last byte of their tint,
+// the other draws read the first one
+uniform vec3 positionOffset[4];
+uniform vec3 positionScale[4];
+uniform bool octahedralNormals;
+
+// Same octahedral mapping as DecodeOctahedral, w is 0 for the vertices without normal
+vec3 DecodeNormal(vec4 normal)
+{
+    if (!octahedralNormals)
+        return normal.xyz;
+    if (normal.w < 0.5)
+        return vec3(0.0);
+    vec3 n = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n;
+}
+
+// Rotation around the vertical axis, counterclockwise seen from above
+mat3 RotationY(float angle)
+{
+    const float c = cos(angle);
+    const float s = sin(angle);
+    return mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+}
 
 void main()
 {
-    color = inColor;
-    //gl_Position = modelViewProjection*vec4(inWorldPos, 1.);
-    gl_Position = modelViewProjection*vec4(inWorldPos.x + transfoModif.x, inWorldPos.y + transfoModif.y, inWorldPos.z + transfoModif.z, 1.);
+    const vec3 instancePosition = instanced ? inInstancePosition : transfoModif;
+    const vec4 scaleRotation = instanced ? inInstanceScaleRotation : instanceScaleRotation;
+    const vec3 tint = instanced ? inInstanceTint.rgb : instanceTint;
+    const uint decode = instanced ? min(uint(inInstanceTint.a * 255.0 + 0.5), 3u) : 0u;
+    const mat3 rotation = RotationY(scaleRotation.w);
+
+    const vec3 inWorldPos = instancePosition + rotation * ((positionOffset[decode] + inPosition * positionScale[decode]) * scaleRotation.xyz);
+    // Normals scale by the inverse of the positions
+    const vec3 normal = rotation * (DecodeNormal(inNormal) / scaleRotation.xyz);
+
+    // Meshes without normals keep their flat color
+    const vec3 lightDirection = normalize(vec3(0.3, 1.0, 0.2));
+    float lighting = dot(normal, normal) > 0. ? 0.6 + 0.4 * max(dot(normalize(normal), lightDirection), 0.) : 1.;
+    color = meshColor * tint * lighting;
+    gl_Position = modelViewProjection * vec4(inWorldPos, 1.);
 })";
     char const* const fragmentSource = R"(#version 450 core
 
@@ -361,6 +546,148 @@ void main()
     return InitShader(vertexSource, fragmentSource);
 }
 
+GLuint Renderer::InitImpostorShader()
+{
+    char const* const vertexSource = R"(#version 450 core
+
+// Instance of every quad, see PackedInstance
+layout(location = 0) in vec3 inInstancePosition;
+layout(location = 1) in vec4 inInstanceScaleRotation;
+layout(location = 2) in vec4 inInstanceTint;
+
+layout(location = 0) smooth out vec3 worldPos;
+layout(location = 1) smooth out vec2 atlasCoords;
+// Offset from the quad to the far side of the bounding sphere, along the baked view direction
+layout(location = 2) flat out vec3 depthOffset;
+layout(location = 3) flat out vec3 tint;
+// Atlas of the variant of the instance, from the last byte of its tint
+layout(location = 4) flat out float layer;
+
+layout(std140, binding = 0) uniform Matrix
+{
+    mat4 modelViewProjection;
+};
+uniform vec3 cameraPosition;
+uniform vec3 impostorCenter;
+uniform float impostorRadius;
+uniform float framesPerSide;
+
+// Same hemi-octahedral mapping as DecodeImpostorDirection
+vec3 DecodeDirection(vec2 coords)
+{
+    vec2 e = coords * 2.0 - 1.0;
+    vec2 p = vec2(e.x + e.y, e.x - e.y) * 0.5;
+    return normalize(vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y));
+}
+
+// Rotation around the vertical axis, counterclockwise seen from above
+mat3 RotationY(float angle)
+{
+    const float c = cos(angle);
+    const float s = sin(angle);
+    return mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+}
+
+void main()
+{
+    const vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    const vec3 scale = inInstanceScaleRotation.xyz;
+    const mat3 rotation = RotationY(inInstanceScaleRotation.w);
+    const vec3 center = inInstancePosition + rotation * (impostorCenter * scale);
+
+    // The frame is picked from the view direction in the space of the mesh, before the transform of the instance
+    // Only the upper hemisphere is baked, views from below use the frames of the horizon
+    vec3 direction = (transpose(rotation) * (cameraPosition - center)) / scale;
+    direction.y = max(direction.y, 0.0);
+    direction = dot(direction, direction) > 0.0 ? normalize(direction) : vec3(0.0, 1.0, 0.0);
+
+    // Frame baked the closest to the view direction
+    const vec2 p = direction.xz / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    const vec2 coords = vec2(p.x + p.y, p.x - p.y) * 0.5 + 0.5;
+    const vec2 frame = round(coords * (framesPerSide - 1.0));
+    const vec3 frameDirection = DecodeDirection(frame / (framesPerSide - 1.0));
+
+    // Same image plane axes as GetImpostorViewBasis
+    const vec3 right = abs(frameDirection.y) > 0.999 ? vec3(1.0, 0.0, 0.0) : normalize(cross(vec3(0.0, 1.0, 0.0), frameDirection));
+    const vec3 up = cross(frameDirection, right);
+
+    worldPos = center + rotation * ((right * corner.x + up * corner.y) * impostorRadius * scale);
+    depthOffset = rotation * (frameDirection * impostorRadius * scale);
+    tint = inInstanceTint.rgb;
+    layer = round(inInstanceTint.a * 255.0);
+    atlasCoords = (frame + corner * 0.5 + 0.5) / framesPerSide;
+    gl_Position = modelViewProjection * vec4(worldPos, 1.0);
+})";
+    char const* const fragmentSource = R"(#version 450 core
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) smooth in vec3 worldPos;
+layout(location = 1) smooth in vec2 atlasCoords;
+layout(location = 2) flat in vec3 depthOffset;
+layout(location = 3) flat in vec3 tint;
+layout(location = 4) flat in float layer;
+
+layout(std140, binding = 0) uniform Matrix
+{
+    mat4 modelViewProjection;
+};
+layout(binding = 0) uniform sampler2DArray impostorColor;
+layout(binding = 1) uniform sampler2DArray impostorDepth;
+
+void main()
+{
+    const vec4 color = texture(impostorColor, vec3(atlasCoords, layer));
+    if (color.a < 0.5)
+        discard;
+    // The atlas is cleared to 0 so the filtered colours are premultiplied by the coverage
+    outColor = vec4(color.rgb / color.a * tint, 1.0);
+
+    // Depth 0 is the side of the bounding sphere facing the baked view, 1 the opposite one
+    const float depth = texture(impostorDepth, vec3(atlasCoords, layer)).r;
+    const vec4 clipPos = modelViewProjection * vec4(worldPos + depthOffset * (1.0 - 2.0 * depth), 1.0);
+    gl_FragDepth = clipPos.z / clipPos.w * 0.5 + 0.5;
+})";
+    return InitShader(vertexSource, fragmentSource);
+}
+
+bool Renderer::InitShaderPrograms()
+{
+    if (!m_ShaderProgram[0].Create(InitDefaultShader()) || !m_ShaderProgram[1].Create(InitSkyboxShader()) || !m_ShaderProgram[2].Create(InitImpostorShader())) {
+        std::cerr << "Shader programs failed to link" << std::endl;
+        return false;
+    }
+
+    //the frames address every uniform through these handles, only the setup looks names up:
+    const ShaderProgram& defaultProgram = m_ShaderProgram[0];
+    m_DefaultUniforms.instanced = defaultProgram.GetUniform<bool>("instanced");
+    m_DefaultUniforms.transfoModif = defaultProgram.GetUniform<glm::vec3>("transfoModif");
+    m_DefaultUniforms.instanceScaleRotation = defaultProgram.GetUniform<glm::vec4>("instanceScaleRotation");
+    m_DefaultUniforms.instanceTint = defaultProgram.GetUniform<glm::vec3>("instanceTint");
+    m_DefaultUniforms.meshColor = defaultProgram.GetUniform<glm::vec3>("meshColor");
+    m_DefaultUniforms.positionOffset = defaultProgram.GetUniform<glm::vec3>("positionOffset");
+    m_DefaultUniforms.positionScale = defaultProgram.GetUniform<glm::vec3>("positionScale");
+    m_DefaultUniforms.octahedralNormals = defaultProgram.GetUniform<bool>("octahedralNormals");
+
+    m_SkyboxUniforms.view = m_ShaderProgram[1].GetUniform<glm::mat4>("view");
+    m_SkyboxUniforms.projection = m_ShaderProgram[1].GetUniform<glm::mat4>("projection");
+    m_ShaderProgram[1].Set(m_ShaderProgram[1].GetUniform<int32_t>("skybox"), 0);
+
+    const ShaderProgram& impostorProgram = m_ShaderProgram[2];
+    m_ImpostorUniforms.cameraPosition = impostorProgram.GetUniform<glm::vec3>("cameraPosition");
+    m_ImpostorUniforms.impostorCenter = impostorProgram.GetUniform<glm::vec3>("impostorCenter");
+    m_ImpostorUniforms.impostorRadius = impostorProgram.GetUniform<float>("impostorRadius");
+    m_ImpostorUniforms.framesPerSide = impostorProgram.GetUniform<float>("framesPerSide");
+
+    //the camera matrix is bound once per frame at 0 for every program reading it:
+    for (uint32_t i : { 0u, 2u }) {
+        if (m_ShaderProgram[i].GetUniformBlockBinding("Matrix") != 0)
+            std::cerr << "shader program " << m_ShaderProgram[i].GetID() << ": Matrix block not at binding 0" << std::endl;
+    }
+
+    return true;
+}
+
 bool Renderer::Initialize()
 {
     /*constexpr uint16_t sphereStackCount = 63;
@@ -378,81 +705,81 @@ bool Renderer::Initialize()
 
     
     
-    //adding the desert to the buffer
-    std::vector<VertexDataPosition3fColor3f> vertices[2] = { std::vector<VertexDataPosition3fColor3f>(), std::vector<VertexDataPosition3fColor3f>()};
-    std::vector<int> indices[2] = { std::vector<int>(), std::vector<int>() };
-    std::future<void> loader[2];
-    loader[0] = std::async(LoadDesert, &(indices[0]), &(vertices[0]));
-    //adding all the palm to the buffer
-    loader[1] = std::async(LoadPalm, &(indices[1]), &(vertices[1]));
-    std::future<std::vector<glm::vec4>> loaderTransfo = std::async(LoadTransfoFile, "../../res/palmTransfo.txt");
-    std::string skyboxDir = "../../res/DesertSkybox/";
-    std::string facesCubemap[6] = {
-        "Right.png",
-        "Left.png",
-        "Up.png",
-        "Down.png",
-        "Front.png",
-        "Back.png"
-    };
-    std::future<STBIImgInfo> loaderTexture[6];
-    for (unsigned int i = 0; i < 6; ++i) {
-        loaderTexture[i] = std::async(LoadImg, skyboxDir, facesCubemap[i]);
-    }
-    m_TransfoPalm = loaderTransfo.get();
-    std::cout << "transfoPalm size: " << m_TransfoPalm.size() << std::endl;
-    loader[0].wait();
-    loader[1].wait();
+    m_Streaming = std::make_unique<StreamingState>();
+    StreamingState& streaming = *m_Streaming;
 
     GL_CALL(glCreateBuffers, 1, &m_UBO);
     GL_CALL(glNamedBufferStorage, m_UBO, sizeof(glm::mat4), glm::value_ptr(m_Camera->GetViewProjectionMatrix()), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
 
     GL_CALL(glCreateBuffers, 3, m_IBO);
     GL_CALL(glCreateBuffers, 3, m_VBO);
-    for (int i = 0; i < 2; ++i) {
-        std::cout << "indices[" << i << "] size: " << indices[i].size() << std::endl;
-        std::cout << "vertices[" << i << "] size: " << vertices[i].size() << std::endl;
-        m_IndexCount[i] = indices[i].size();
-        GL_CALL(glNamedBufferStorage, m_IBO[i], sizeof(int) * indices[i].size(), indices[i].data(), 0);
-        GL_CALL(glNamedBufferStorage, m_VBO[i], sizeof(VertexDataPosition3fColor3f) * vertices[i].size(), vertices[i].data(), 0);
-    }
 
+    //the mesh vertex arrays are set up once the vertex layout of their mesh is known:
     GL_CALL(glCreateVertexArrays, 3, m_VAO);
-    for (int i = 0; i < 2; ++i) {
-        GL_CALL(glBindVertexArray, m_VAO[i]);
 
-        GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, m_VBO[i]);
-        GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, m_IBO[i]);
+    GL_CALL(glCreateBuffers, 1, &m_PlaceholderIBO);
+    GL_CALL(glCreateBuffers, 1, &m_PlaceholderVBO);
+    GL_CALL(glCreateVertexArrays, 1, &m_PlaceholderVAO);
 
-        GL_CALL(glEnableVertexAttribArray, 0);
-        GL_CALL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexDataPosition3fColor3f), nullptr);
-        GL_CALL(glEnableVertexAttribArray, 1);
-        GL_CALL(glVertexAttribPointer, 1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexDataPosition3fColor3f), reinterpret_cast<GLvoid*>(sizeof(glm::vec3)));
+    if (!InitShaderPrograms())
+        return false;
 
-        GL_CALL(glBindVertexArray, 0);
+    m_UBOData = GL_CALL_REINTERPRET_CAST_RETURN_VALUE(glm::mat4*, glMapNamedBufferRange, m_UBO, 0, sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
 
+    if (m_Settings.multiDraw) {
+        //every static mesh is sub-allocated from the arena, the layout of which only gives the attributes, the meshes decoding their positions from their own bounds:
+        MeshBounds unitBounds;
+        unitBounds.Extend(glm::vec3(0.0f));
+        unitBounds.Extend(glm::vec3(1.0f));
+        m_Arena.Create(VertexLayout::Create(GetSharedVertexFormat(m_Settings.packVertices), unitBounds), m_Settings.arenaVertexCapacity, m_Settings.arenaIndexCapacity);
+        GL_CALL(glCreateVertexArrays, 1, &m_ArenaVAO);
+        SetupMeshVertexArray(m_ArenaVAO, m_Arena.GetVertexBuffer(), m_Arena.GetIndexBuffer(), m_Arena.GetLayout());
+
+        //the instances and commands are rebuilt every frame, the instance buffer starts with an untransformed instance so that its attributes can be enabled right away:
+        const PackedInstance identity = PackInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), glm::vec3(1.0f), 0);
+        GL_CALL(glCreateBuffers, 1, &m_DrawInstanceVBO);
+        GL_CALL(glCreateBuffers, 1, &m_IndirectBuffer);
+        GL_CALL(glNamedBufferData, m_DrawInstanceVBO, sizeof(PackedInstance), &identity, GL_STREAM_DRAW);
+        SetupInstanceAttributes(m_ArenaVAO, 1, m_DrawInstanceVBO, s_InstancePositionAttribute);
+        GL_CALL(glEnableVertexArrayAttrib, m_ArenaVAO, s_InstancePositionAttribute);
+        GL_CALL(glEnableVertexArrayAttrib, m_ArenaVAO, s_InstanceScaleRotationAttribute);
+        GL_CALL(glEnableVertexArrayAttrib, m_ArenaVAO, s_InstanceTintAttribute);
+
+        //the meshes are taken to fit until they arrive, those that don't fall back to their own buffers:
+        m_InArena[0] = m_InArena[1] = true;
+        m_InArena[2] = UploadSkyboxMesh();
+
+        //the culled scene reads the same arena, its instances being written by the culling pass once the scene is set:
+        if (m_Settings.gpuCulling && !m_GpuCulling.Create(InitComputeShader(GpuCulling::GetShaderSource()))) {
+            std::cerr << "GPU culling shader failed to link, culling on the CPU" << std::endl;
+            m_Settings.gpuCulling = false;
+        }
+        if (m_Settings.gpuCulling) {
+            GL_CALL(glCreateVertexArrays, 1, &m_CulledVAO);
+            SetupMeshVertexArray(m_CulledVAO, m_Arena.GetVertexBuffer(), m_Arena.GetIndexBuffer(), m_Arena.GetLayout());
+            SetupInstanceAttributes(m_CulledVAO, 1, m_DrawInstanceVBO, s_InstancePositionAttribute);
+            GL_CALL(glEnableVertexArrayAttrib, m_CulledVAO, s_InstancePositionAttribute);
+            GL_CALL(glEnableVertexArrayAttrib, m_CulledVAO, s_InstanceScaleRotationAttribute);
+            GL_CALL(glEnableVertexArrayAttrib, m_CulledVAO, s_InstanceTintAttribute);
+        }
+    }
+    else {
+        m_Settings.gpuCulling = false;
+    }
+    if (!m_InArena[2]) {
+        GL_CALL(glBindVertexArray, m_VAO[2]);
+        GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, m_VBO[2]);
+        GL_CALL(glBufferData, GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
+        GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, m_IBO[2]);
+        GL_CALL(glBufferData, GL_ELEMENT_ARRAY_BUFFER, sizeof(skyboxIndices), &skyboxIndices, GL_STATIC_DRAW);
+        GL_CALL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        GL_CALL(glEnableVertexAttribArray, 0);
         GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
+        GL_CALL(glBindVertexArray, 0);
         GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, 0);
-
-        GL_CALL(glDisableVertexAttribArray, 0);
-        GL_CALL(glDisableVertexAttribArray, 1);
+        m_ShaderProgram[1].Set(m_ShaderProgram[1].GetUniform<glm::vec3>("positionOffset"), glm::vec3(0.0f));
+        m_ShaderProgram[1].Set(m_ShaderProgram[1].GetUniform<glm::vec3>("positionScale"), glm::vec3(1.0f));
     }
-
-    m_ShaderProgram[0] = InitDefaultShader();
-
-    m_UBOData = GL_CALL_REINTERPRET_CAST_RETURN_VALUE(glm::mat4*, glMapNamedBufferRange, m_UBO, 0, sizeof(glm::mat4), GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
-
-    m_ShaderProgram[1] = InitSkyboxShader();
-    GL_CALL(glBindVertexArray, m_VAO[2]);
-    GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, m_VBO[2]);
-    GL_CALL(glBufferData, GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-    GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, m_IBO[2]);
-    GL_CALL(glBufferData, GL_ELEMENT_ARRAY_BUFFER, sizeof(skyboxIndices), &skyboxIndices, GL_STATIC_DRAW);
-    GL_CALL(glVertexAttribPointer, 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    GL_CALL(glEnableVertexAttribArray, 0);
-    GL_CALL(glBindBuffer, GL_ARRAY_BUFFER, 0);
-    GL_CALL(glBindVertexArray, 0);
-    GL_CALL(glBindBuffer, GL_ELEMENT_ARRAY_BUFFER, 0);
     GL_CALL(glGenTextures, 1, &m_Texture);
     GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, m_Texture);
     GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -462,60 +789,1243 @@ bool Renderer::Initialize()
     GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     GL_CALL(glTexParameteri, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     GL_CALL(glEnable, GL_TEXTURE_CUBE_MAP_SEAMLESS);
-    for (unsigned int i = 0; i < 6; ++i) {
-        STBIImgInfo info = loaderTexture[i].get();
-        if (info.data) {
-            GL_CALL(glTexImage2D, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, info.width, info.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, info.data);
+    GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, 0);
+
+    //far palms are quads sampling the impostor atlas, one instanced draw for all of them:
+    GL_CALL(glCreateTextures, GL_TEXTURE_2D_ARRAY, 2, m_ImpostorTextures);
+    GL_CALL(glCreateBuffers, 1, &m_ImpostorInstanceVBO);
+    GL_CALL(glCreateVertexArrays, 1, &m_ImpostorVAO);
+    SetupInstanceAttributes(m_ImpostorVAO, 0, m_ImpostorInstanceVBO, 0);
+    for (uint32_t location = 0; location < 3; ++location) {
+        GL_CALL(glEnableVertexArrayAttrib, m_ImpostorVAO, location);
+    }
+
+    //near palms are instanced too, their instances being a second buffer of the palm vertex array:
+    GL_CALL(glCreateBuffers, 1, &m_PalmInstanceVBO);
+    SetupInstanceAttributes(m_VAO[1], 1, m_PalmInstanceVBO, s_InstancePositionAttribute);
+
+    //every asset goes through read -> parse -> post-process on the workers, the GL thread uploads each one as soon as it is ready:
+    AssetPipeline& pipeline = streaming.pipeline;
+
+    streaming.meshImports[0].name = "desert";
+    streaming.meshImports[0].inputFile = "desert.obj";
+    streaming.meshImports[0].settings = DesertImportSettings();
+    streaming.meshImports[1].name = "palm";
+    streaming.meshImports[1].inputFile = "palm.obj";
+    streaming.meshImports[1].settings = PalmImportSettings();
+    streaming.meshImports[0].settings.quantize = streaming.meshImports[1].settings.quantize = m_Settings.quantizeMeshes;
+    streaming.meshImports[0].settings.optimize = streaming.meshImports[1].settings.optimize = m_Settings.optimizeMeshes;
+    streaming.meshImports[0].settings.meshlets = streaming.meshImports[1].settings.meshlets = m_Settings.clusterCulling;
+    streaming.meshImports[0].packVertices = streaming.meshImports[1].packVertices = m_Settings.packVertices;
+    streaming.meshImports[0].settings.tileGridSize = m_Settings.terrainTiles;
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        MeshImport& import = streaming.meshImports[i];
+        AssetPipeline::TaskID parse;
+        AssetPipeline::TaskID build;
+        if (i == 1 && m_Settings.proceduralPalms) {
+            //generated palms are final right away, like a cached mesh:
+            parse = build = pipeline.AddTask(import.name + " generate", AssetPipeline::Queue::Worker, [this, &import]() { GeneratePalmMesh(import, m_Settings.palmSettings); });
+        }
+        else {
+            const AssetPipeline::TaskID read = pipeline.AddTask(import.name + " read", AssetPipeline::Queue::Worker, [&import]() { ReadObjMesh(import); });
+            parse = pipeline.AddTask(import.name + " parse", AssetPipeline::Queue::Worker, [&import]() { ParseObjMesh(import); }, { read });
+            //when uploading directly only the counts are known after post-processing, the final arrays are written once the GPU storage is mapped:
+            build = m_Settings.directUpload
+                ? pipeline.AddTask(import.name + " weld", AssetPipeline::Queue::Worker, [&import]() { WeldObjMesh(import); }, { parse })
+                : pipeline.AddTask(import.name + " post-process", AssetPipeline::Queue::Worker, [&import]() { BuildObjMesh(import); }, { parse });
+        }
+        if (!m_Settings.directUpload) {
+            build = pipeline.AddTask(import.name + " short indices", AssetPipeline::Queue::Worker, [&import]() { BuildShortIndices(import); }, { build });
+            build = pipeline.AddTask(import.name + " pack vertices", AssetPipeline::Queue::Worker, [&import]() { PackMeshVertices(import); }, { build });
+        }
+        //the coarse terrain only needs the parsed positions or the cached mesh, it is drawn while the full one is still being built,
+        //the steps releasing what it reads wait for it:
+        AssetPipeline::TaskID placeholder = build;
+        if (i == 0) {
+            placeholder = pipeline.AddTask("desert placeholder", AssetPipeline::Queue::Worker, [&streaming, &import]() {
+                streaming.placeholder = import.fromCache
+                    ? GenerateTerrainPlaceholder(import.mesh, s_PlaceholderResolution)
+                    : GenerateTerrainPlaceholder(import.obj.vertices, import.settings.color, s_PlaceholderResolution);
+            }, { parse });
+            pipeline.AddTask("desert placeholder upload", AssetPipeline::Queue::Main, [this, &streaming]() {
+                UploadPlaceholder(streaming.placeholder);
+                streaming.placeholder = MeshData();
+            }, { placeholder });
+        }
+        if (m_Settings.directUpload) {
+            const AssetPipeline::TaskID map = pipeline.AddTask(import.name + " map", AssetPipeline::Queue::Main, [this, i, &import]() { MapMeshStorage(i, import); }, { build });
+            const AssetPipeline::TaskID fill = pipeline.AddTask(import.name + " fill", AssetPipeline::Queue::Worker, [this, i, &import]() { FillMappedMesh(i, import); }, { map, placeholder });
+            pipeline.AddTask(import.name + " publish", AssetPipeline::Queue::Main, [this, i]() { PublishMappedMesh(i); }, { fill });
+        }
+        else
+            pipeline.AddTask(import.name + " upload", AssetPipeline::Queue::Main, [this, i, &import]() { QueueMeshUpload(i, import); }, { build, placeholder });
+    }
+
+    const AssetPipeline::TaskID readInstances = pipeline.AddTask("palm instances read", AssetPipeline::Queue::Worker, [&streaming]() {
+        streaming.palmInstances = LoadInstances("palm", "palmTransfo.txt");
+    });
+    pipeline.AddTask("palm instances upload", AssetPipeline::Queue::Main, [this, &streaming]() {
+        m_TransfoPalm = std::move(streaming.palmInstances);
+        std::cout << "transfoPalm size: " << m_TransfoPalm.GetCount() << std::endl;
+        if (m_TransfoPalm.GetCount() > 0) {
+            GL_CALL(glNamedBufferStorage, m_ImpostorInstanceVBO, m_TransfoPalm.GetCount() * sizeof(PackedInstance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+        }
+        AllocatePalmInstanceBuffer();
+    }, { readInstances });
+
+    //the impostor is baked once the palm mesh is resident unless its cache is still up to date:
+    if (m_Settings.impostorDistance > 0.0f) {
+        const AssetPipeline::TaskID readImpostor = pipeline.AddTask("palm impostor read", AssetPipeline::Queue::Worker, [this, &streaming]() {
+            FileStamp stamp;
+            if (GetPalmImpostorStamp(stamp))
+                ImpostorAtlas::LoadCache(GetPalmImpostorCachePath(), stamp, HashPalmImpostorSettings(), m_Settings.impostorSettings, streaming.palmImpostor);
+        });
+        pipeline.AddTask("palm impostor upload", AssetPipeline::Queue::Main, [this, &streaming]() {
+            if (!streaming.palmImpostor.IsValid())
+                return;
+            streaming.palmImpostor.Upload(m_ImpostorTextures[0], m_ImpostorTextures[1]);
+            m_ImpostorCenter = streaming.palmImpostor.GetCenter();
+            m_ImpostorRadius = streaming.palmImpostor.GetRadius();
+            m_ImpostorLayerCount = streaming.palmImpostor.GetLayerCount();
+            m_ImpostorReady = true;
+            streaming.palmImpostor = ImpostorAtlas();
+            std::cout << "palm impostor loaded from cache" << std::endl;
+        }, { readImpostor });
+    }
+
+    const AssetPipeline::TaskID decodeSkybox = pipeline.AddTask("skybox decode", AssetPipeline::Queue::Worker, [this, &streaming]() {
+        streaming.skybox = LoadSkybox("DesertSkyboxBackup/", "SkyboxClean.png", m_Settings.skyboxCache);
+    });
+    pipeline.AddTask("skybox upload", AssetPipeline::Queue::Main, [this, &streaming]() {
+        GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, m_Texture);
+        streaming.skybox.Upload();
+        GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, 0);
+        streaming.skybox = CubemapImage();
+        streaming.skyboxReady = true;
+    }, { decodeSkybox });
+
+    //every startup asset is requested from the disk at once, the loaders then find its pages in the file cache:
+    if (m_Settings.prefetchAssets) {
+        auto prefetchCompiled = [&streaming](const std::string& compiledFile, const std::string& sourceFile) {
+            if (!streaming.prefetch.Add(compiledFile))
+                streaming.prefetch.Add(sourceFile);
+        };
+        for (uint32_t i = 0; i < 2; ++i) {
+            if (i != 1 || !m_Settings.proceduralPalms)
+                prefetchCompiled(GetMeshCachePath(streaming.meshImports[i].inputFile), streaming.meshImports[i].inputFile);
         }
-        stbi_image_free(info.data);
+        prefetchCompiled(GetInstanceFilePath("palmTransfo.txt"), "palmTransfo.txt");
+        if (m_Settings.impostorDistance > 0.0f)
+            streaming.prefetch.Add(GetPalmImpostorCachePath());
+        if (m_Settings.skyboxCache)
+            prefetchCompiled(GetCubemapCachePath("DesertSkyboxBackup/SkyboxClean.png"), "DesertSkyboxBackup/SkyboxClean.png");
+        else
+            streaming.prefetch.Add("DesertSkyboxBackup/SkyboxClean.png");
+        streaming.prefetch.Submit(*streaming.threadPool);
+        std::cout << "prefetching " << streaming.prefetch.GetAssetCount() << " assets (" << streaming.prefetch.GetSize() / (1024 * 1024) << " MB)" << std::endl;
+    }
+
+    pipeline.Start();
+
+    if (!m_Settings.progressiveLoading) {
+        pipeline.Finish();
+        FlushUploads(0);
+        PollMappedMeshes(true);
+        FinishStreaming();
+        return true;
+    }
+
+    //the skybox is the only asset the first frame waits for, the rest is picked up by StreamAssets:
+    while (!streaming.skyboxReady)
+        pipeline.ProcessMainThreadTasks(true);
+
+    return true;
+}
+
+void Renderer::SetupMeshVertexArray(GLuint vao, GLuint vbo, GLuint ibo, const VertexLayout& layout)
+{
+    GL_CALL(glVertexArrayVertexBuffer, vao, 0, vbo, 0, layout.stride);
+    GL_CALL(glVertexArrayElementBuffer, vao, ibo);
+
+    //every attribute of the layout reads the single interleaved buffer:
+    for (const VertexAttribute& attribute : layout.attributes) {
+        const GLenum type = attribute.type == VertexAttributeType::UnsignedShort ? GL_UNSIGNED_SHORT
+                          : attribute.type == VertexAttributeType::Int2_10_10_10 ? GL_INT_2_10_10_10_REV
+                          : GL_FLOAT;
+        GL_CALL(glEnableVertexArrayAttrib, vao, attribute.location);
+        GL_CALL(glVertexArrayAttribFormat, vao, attribute.location, attribute.componentCount, type, attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+        GL_CALL(glVertexArrayAttribBinding, vao, attribute.location, 0);
+    }
+}
+
+void Renderer::SetupInstanceAttributes(GLuint vao, GLuint binding, GLuint vbo, uint32_t firstLocation)
+{
+    GL_CALL(glVertexArrayVertexBuffer, vao, binding, vbo, 0, sizeof(PackedInstance));
+    GL_CALL(glVertexArrayBindingDivisor, vao, binding, 1);
+    GL_CALL(glVertexArrayAttribFormat, vao, firstLocation, 3, GL_FLOAT, GL_FALSE, offsetof(PackedInstance, position));
+    GL_CALL(glVertexArrayAttribFormat, vao, firstLocation + 1, 4, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedInstance, scaleRotation));
+    GL_CALL(glVertexArrayAttribFormat, vao, firstLocation + 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(PackedInstance, tintSpecies));
+    for (uint32_t location = firstLocation; location < firstLocation + 3; ++location) {
+        GL_CALL(glVertexArrayAttribBinding, vao, location, binding);
+    }
+}
+
+bool Renderer::UploadSkyboxMesh()
+{
+    constexpr uint32_t vertexCount = sizeof(skyboxVertices) / (3 * sizeof(float));
+    constexpr uint32_t indexCount = sizeof(skyboxIndices) / sizeof(unsigned int);
+    if (!m_Arena.Allocate(vertexCount, indexCount, m_SkyboxAllocation)) {
+        std::cerr << "skybox: doesn't fit in the geometry arena, drawn from its own buffers" << std::endl;
+        return false;
+    }
+
+    //the cube goes through the format of the arena like the meshes, without normals:
+    std::vector<VertexDataPosition3fNormal3fColor3f> vertices(vertexCount);
+    MeshBounds bounds;
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        vertices[i] = { glm::make_vec3(&skyboxVertices[3 * i]), glm::vec3(0.0f), glm::vec3(1.0f) };
+        bounds.Extend(vertices[i].position);
+    }
+    const VertexLayout layout = VertexLayout::Create(m_Arena.GetLayout().format, bounds);
+    m_ShaderProgram[1].Set(m_ShaderProgram[1].GetUniform<glm::vec3>("positionOffset"), layout.positionOffset);
+    m_ShaderProgram[1].Set(m_ShaderProgram[1].GetUniform<glm::vec3>("positionScale"), layout.positionScale);
+    std::vector<std::byte> packed(vertexCount * layout.stride);
+    layout.PackVertices(vertices, packed.data());
+    std::vector<uint16_t> indices(indexCount);
+    std::transform(std::begin(skyboxIndices), std::end(skyboxIndices), indices.begin(), [](unsigned int index) { return static_cast<uint16_t>(index); });
+
+    GL_CALL(glNamedBufferSubData, m_Arena.GetVertexBuffer(), std::size_t(m_SkyboxAllocation.baseVertex) * layout.stride, packed.size(), packed.data());
+    GL_CALL(glNamedBufferSubData, m_Arena.GetIndexBuffer(), std::size_t(m_SkyboxAllocation.firstIndex) * sizeof(uint16_t), indices.size() * sizeof(uint16_t), indices.data());
+
+    return true;
+}
+
+bool Renderer::AllocateArenaMesh(uint32_t meshID, const MeshImport& import, std::size_t vertexCount, std::size_t indexCount)
+{
+    //the imports are in the format of the arena unless their positions are too large for 16 bits, only meshes whose triangles span too many vertices keep 32 bit indices:
+    const VertexFormat& format = m_Arena.GetLayout().format;
+    if (!import.indexLayout.shortIndices || import.vertexLayout.format.position != format.position || import.vertexLayout.format.normal != format.normal) {
+        std::cerr << import.name << ": doesn't fit the layouts of the geometry arena, drawn from its own buffers" << std::endl;
+        return false;
+    }
+    if (!m_Arena.Allocate(static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(indexCount), m_MeshAllocations[meshID])) {
+        std::cerr << import.name << ": geometry arena full, " << m_Arena.GetVertexCount() << " vertices and " << m_Arena.GetIndexCount() << " indices already allocated, drawn from its own buffers" << std::endl;
+        return false;
     }
 
     return true;
 }
 
+void Renderer::AllocatePalmInstanceBuffer()
+{
+    //the palms drawn from the arena read the instances of the frame from its vertex array instead:
+    if (m_PalmInstanceStorage || m_TransfoPalm.GetCount() == 0 || m_InArena[1])
+        return;
+
+    GL_CALL(glNamedBufferStorage, m_PalmInstanceVBO, m_TransfoPalm.GetCount() * sizeof(PackedInstance), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    //the attributes are only read once their buffer has storage, the shader ignores them outside of the instanced draws:
+    GL_CALL(glEnableVertexArrayAttrib, m_VAO[1], s_InstancePositionAttribute);
+    GL_CALL(glEnableVertexArrayAttrib, m_VAO[1], s_InstanceScaleRotationAttribute);
+    GL_CALL(glEnableVertexArrayAttrib, m_VAO[1], s_InstanceTintAttribute);
+    m_PalmInstanceStorage = true;
+}
+
+void Renderer::SetInstanceUniforms(const glm::vec3& position, float rotation, const glm::vec3& scale, const glm::vec3& tint)
+{
+    const ShaderProgram& program = m_ShaderProgram[0];
+    program.Set(m_DefaultUniforms.transfoModif, position);
+    program.Set(m_DefaultUniforms.instanceScaleRotation, glm::vec4(scale, rotation));
+    program.Set(m_DefaultUniforms.instanceTint, tint);
+}
+
+void Renderer::SetMeshUniforms(const VertexLayout& layout, const glm::vec3& color)
+{
+    if (m_RecordDraws) {
+        //the recorded meshes, the terrain or its placeholder and the palms, fit in the decodings of the shader:
+        m_RecordedPositionDecode = static_cast<uint8_t>(m_PositionOffsets.size());
+        m_PositionOffsets.push_back(layout.positionOffset);
+        m_PositionScales.push_back(layout.positionScale);
+        m_RecordedInstance = static_cast<uint32_t>(m_DrawInstances.size());
+        m_RecordedColor = color;
+        m_DrawInstances.push_back(PackInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), color, m_RecordedPositionDecode));
+        return;
+    }
+
+    const ShaderProgram& program = m_ShaderProgram[0];
+    program.Set(m_DefaultUniforms.meshColor, color);
+    program.Set(m_DefaultUniforms.positionOffset, layout.positionOffset);
+    program.Set(m_DefaultUniforms.positionScale, layout.positionScale);
+    program.Set(m_DefaultUniforms.octahedralNormals, layout.format.normal == VertexNormalFormat::Octahedral10);
+}
+
+void Renderer::SetArenaUniforms(std::span<const glm::vec3> positionOffsets, std::span<const glm::vec3> positionScales)
+{
+    const ShaderProgram& program = m_ShaderProgram[0];
+    program.Set(m_DefaultUniforms.meshColor, glm::vec3(1.0f));
+    program.Set(m_DefaultUniforms.positionOffset, positionOffsets.first(std::min(positionOffsets.size(), s_PositionDecodeCount)));
+    program.Set(m_DefaultUniforms.positionScale, positionScales.first(std::min(positionScales.size(), s_PositionDecodeCount)));
+    program.Set(m_DefaultUniforms.octahedralNormals, m_Arena.GetLayout().format.normal == VertexNormalFormat::Octahedral10);
+}
+
+void Renderer::QueueMeshUpload(uint32_t meshID, MeshImport& import, bool allocated)
+{
+    import.obj = ObjData();
+    std::span<const uint32_t> indices = import.mesh.GetIndices();
+    const std::span<const std::byte> vertices = import.packedVertices;
+    const std::size_t vertexCount = import.mesh.GetVertices().size();
+    std::cout << "indices[" << meshID << "] size: " << indices.size() << std::endl;
+    std::cout << "vertices[" << meshID << "] size: " << vertexCount << " (" << import.vertexLayout.stride << " bytes each instead of " << sizeof(VertexDataPosition3fNormal3fColor3f) << ")" << std::endl;
+    if (indices.empty() || vertices.empty())
+        return;
+    m_MeshBounds[meshID] = import.mesh.GetBounds();
+    m_VertexLayouts[meshID] = import.vertexLayout;
+    m_MeshColors[meshID] = import.settings.color;
+
+    //the storage is allocated right away, its content is copied over the next frames:
+    const std::span<const std::byte> indexData = import.indexLayout.shortIndices ? std::as_bytes(std::span<const uint16_t>(import.shortIndices)) : std::as_bytes(indices);
+    BufferUpload vertexUpload{ m_VBO[meshID], vertices };
+    BufferUpload indexUpload{ m_IBO[meshID], indexData };
+    //a mesh the arena can't take is drawn from its own buffers, like without multiDraw:
+    if (!allocated) {
+        m_InArena[meshID] = m_Settings.multiDraw && AllocateArenaMesh(meshID, import, vertexCount, indices.size());
+        if (!m_InArena[meshID]) {
+            SetupMeshVertexArray(m_VAO[meshID], m_VBO[meshID], m_IBO[meshID], m_VertexLayouts[meshID]);
+            GL_CALL(glNamedBufferStorage, m_IBO[meshID], indexData.size(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            GL_CALL(glNamedBufferStorage, m_VBO[meshID], vertices.size(), nullptr, GL_DYNAMIC_STORAGE_BIT);
+            if (meshID == 1)
+                AllocatePalmInstanceBuffer();
+        }
+    }
+    if (m_InArena[meshID]) {
+        vertexUpload.buffer = m_Arena.GetVertexBuffer();
+        vertexUpload.bufferOffset = std::size_t(m_MeshAllocations[meshID].baseVertex) * import.vertexLayout.stride;
+        indexUpload.buffer = m_Arena.GetIndexBuffer();
+        indexUpload.bufferOffset = std::size_t(m_MeshAllocations[meshID].firstIndex) * sizeof(uint16_t);
+    }
+
+    const uint32_t indexCount = static_cast<uint32_t>(indices.size());
+    m_Streaming->uploads.push_back(vertexUpload);
+    indexUpload.onComplete = [this, meshID, indexCount, &import]() {
+        //uploads complete in order so the vertices are already there, the mesh can be drawn:
+        m_IndexLayout[meshID] = std::move(import.indexLayout);
+        m_MeshLods[meshID] = std::move(import.lods);
+        m_Meshlets[meshID] = std::move(import.meshlets);
+        m_Tiles[meshID] = std::move(import.tiles);
+        m_VariantCount[meshID] = import.variantCount;
+        m_VariantMeshlets[meshID] = import.variantMeshlets.empty() ? std::vector<uint32_t>{ 0, static_cast<uint32_t>(m_Meshlets[meshID].size()) } : std::move(import.variantMeshlets);
+        m_IndexCount[meshID] = indexCount;
+        import.mesh = MeshData();
+        import.shortIndices = std::vector<uint16_t>();
+        import.packedVertices = std::vector<std::byte>();
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_Streaming->start;
+        std::cout << import.name << " resident after " << elapsed.count() << " ms" << std::endl;
+    };
+    m_Streaming->uploads.push_back(std::move(indexUpload));
+}
+
+void Renderer::UploadPlaceholder(const MeshData& mesh)
+{
+    std::span<const uint32_t> indices = mesh.GetIndices();
+    std::span<const VertexDataPosition3fNormal3fColor3f> vertices = mesh.GetVertices();
+    if (indices.empty() || vertices.empty())
+        return;
+
+    //small enough to be packed right here, coarse enough for the format of the arena whatever its size,
+    //the grid is far under 65536 vertices so its indices fit the 16 bit ones of the arena:
+    m_PlaceholderColor = vertices.front().color;
+    m_PlaceholderInArena = false;
+    if (m_Settings.multiDraw) {
+        m_PlaceholderLayout = VertexLayout::Create(m_Arena.GetLayout().format, mesh.GetBounds());
+        m_PlaceholderInArena = vertices.size() <= std::numeric_limits<uint16_t>::max() + std::size_t(1) && m_PlaceholderLayout.stride == m_Arena.GetLayout().stride &&
+            m_Arena.Allocate(static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()), m_PlaceholderAllocation);
+        if (!m_PlaceholderInArena) {
+            std::cerr << "desert placeholder: doesn't fit in the geometry arena, drawn from its own buffers" << std::endl;
+            m_PlaceholderAllocation = GeometryArena::Allocation();
+        }
+    }
+    if (!m_PlaceholderInArena)
+        m_PlaceholderLayout = VertexLayout::Create(ChooseVertexFormat(mesh.GetBounds(), m_Settings.packVertices), mesh.GetBounds());
+    std::vector<std::byte> packed(vertices.size() * m_PlaceholderLayout.stride);
+    m_PlaceholderLayout.PackVertices(vertices, packed.data());
+
+    if (m_PlaceholderInArena) {
+        std::vector<uint16_t> shortIndices(indices.size());
+        std::transform(indices.begin(), indices.end(), shortIndices.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+        GL_CALL(glNamedBufferSubData, m_Arena.GetVertexBuffer(), std::size_t(m_PlaceholderAllocation.baseVertex) * m_PlaceholderLayout.stride, packed.size(), packed.data());
+        GL_CALL(glNamedBufferSubData, m_Arena.GetIndexBuffer(), std::size_t(m_PlaceholderAllocation.firstIndex) * sizeof(uint16_t), shortIndices.size() * sizeof(uint16_t), shortIndices.data());
+        m_PlaceholderIndexCount = static_cast<uint32_t>(indices.size());
+        return;
+    }
+
+    m_PlaceholderIndexCount = static_cast<uint32_t>(indices.size());
+    GL_CALL(glNamedBufferStorage, m_PlaceholderIBO, indices.size_bytes(), indices.data(), 0);
+    GL_CALL(glNamedBufferStorage, m_PlaceholderVBO, packed.size(), packed.data(), 0);
+    SetupMeshVertexArray(m_PlaceholderVAO, m_PlaceholderVBO, m_PlaceholderIBO, m_PlaceholderLayout);
+}
+
+uint64_t Renderer::FlushUploads(uint64_t budget)
+{
+    if (budget == 0)
+        budget = std::numeric_limits<uint64_t>::max();
+
+    std::deque<BufferUpload>& uploads = m_Streaming->uploads;
+    uint64_t uploaded = 0;
+
+    while (!uploads.empty() && uploaded < budget) {
+        BufferUpload& upload = uploads.front();
+        const std::size_t size = static_cast<std::size_t>(std::min<uint64_t>(upload.data.size() - upload.offset, budget - uploaded));
+        GL_CALL(glNamedBufferSubData, upload.buffer, upload.bufferOffset + upload.offset, size, upload.data.data() + upload.offset);
+        upload.offset += size;
+        uploaded += size;
+
+        if (upload.offset == upload.data.size()) {
+            if (upload.onComplete)
+                upload.onComplete();
+            uploads.pop_front();
+        }
+    }
+
+    return uploaded;
+}
+
+void Renderer::MapMeshStorage(uint32_t meshID, MeshImport& import)
+{
+    //cached and generated meshes are already final, the others are still welded:
+    const bool built = !import.mesh.GetVertices().empty();
+    const std::size_t vertexCount = built ? import.mesh.GetVertices().size() : import.welded.vertices.size();
+    const std::size_t indexCount = built ? import.mesh.GetIndices().size() : import.welded.indices.size();
+    std::cout << "indices[" << meshID << "] size: " << indexCount << std::endl;
+    std::cout << "vertices[" << meshID << "] size: " << vertexCount << " (" << import.vertexLayout.stride << " bytes each instead of " << sizeof(VertexDataPosition3fNormal3fColor3f) << ")" << std::endl;
+    if (indexCount == 0 || vertexCount == 0)
+        return;
+    m_MeshBounds[meshID] = built ? import.mesh.GetBounds() : import.bounds;
+    m_VertexLayouts[meshID] = import.vertexLayout;
+    m_MeshColors[meshID] = import.settings.color;
+
+    //immutable storage that stays mapped while the workers write into it, the writes are flushed once they are all done,
+    //like the arena it also accepts uploads in case it can't be mapped:
+    const std::size_t vertexBytes = vertexCount * import.vertexLayout.stride;
+    const std::size_t indexBytes = indexCount * import.indexLayout.GetIndexSize();
+    void* vertices = nullptr;
+    void* indices = nullptr;
+    //the whole arena stays mapped until every asset is resident, each mesh writes its own allocation, the ones it can't take get their own buffers:
+    m_InArena[meshID] = m_Settings.multiDraw && AllocateArenaMesh(meshID, import, vertexCount, indexCount);
+    if (m_InArena[meshID]) {
+        if (m_Arena.Map()) {
+            vertices = m_Arena.GetMappedVertices(m_MeshAllocations[meshID].baseVertex);
+            indices = m_Arena.GetMappedIndices(m_MeshAllocations[meshID].firstIndex);
+        }
+    }
+    else {
+        SetupMeshVertexArray(m_VAO[meshID], m_VBO[meshID], m_IBO[meshID], m_VertexLayouts[meshID]);
+        GL_CALL(glNamedBufferStorage, m_VBO[meshID], vertexBytes, nullptr, GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+        GL_CALL(glNamedBufferStorage, m_IBO[meshID], indexBytes, nullptr, GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+
+        vertices = GL_CALL(glMapNamedBufferRange, m_VBO[meshID], 0, vertexBytes, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+        indices = GL_CALL(glMapNamedBufferRange, m_IBO[meshID], 0, indexBytes, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+        if (meshID == 1)
+            AllocatePalmInstanceBuffer();
+    }
+    if (!vertices || !indices) {
+        //the mesh is built in memory on the workers and uploaded into the same storage instead:
+        std::cerr << import.name << ": couldn't map the GPU storage, uploaded from memory instead" << std::endl;
+        if (!m_InArena[meshID]) {
+            if (vertices) {
+                GL_CALL(glUnmapNamedBuffer, m_VBO[meshID]);
+            }
+            if (indices) {
+                GL_CALL(glUnmapNamedBuffer, m_IBO[meshID]);
+            }
+        }
+        m_Streaming->mappedMeshes[meshID].unmapped = true;
+        return;
+    }
+
+    m_Streaming->mappedMeshes[meshID].vertices = vertices;
+    m_Streaming->mappedMeshes[meshID].vertexBytes = vertexBytes;
+    m_Streaming->mappedMeshes[meshID].indices = indices;
+    m_Streaming->mappedMeshes[meshID].indexBytes = indexBytes;
+}
+
+void Renderer::FillMappedMesh(uint32_t meshID, MeshImport& import)
+{
+    const StreamingState::MappedMesh& mapped = m_Streaming->mappedMeshes[meshID];
+    if (mapped.unmapped) {
+        //same CPU copy as without directUpload:
+        if (import.mesh.GetVertices().empty())
+            FillObjMeshData(import);
+        BuildShortIndices(import);
+        PackMeshVertices(import);
+        return;
+    }
+    if (!mapped.vertices || !mapped.indices)
+        return;
+
+    if (import.mesh.GetVertices().empty()) {
+        FillObjMesh(import, mapped.vertices, &import.vertexLayout, mapped.indices, import.indexLayout);
+        import.obj = ObjData();
+        return;
+    }
+
+    //a cached or generated mesh is already final, every chunk packs its slice of the vertices and copies its slice of the indices out of the cache:
+    const std::span<const VertexDataPosition3fNormal3fColor3f> vertices = import.mesh.GetVertices();
+    const std::span<const uint32_t> indices = import.mesh.GetIndices();
+    const std::size_t chunkCount = std::clamp<std::size_t>(vertices.size() / s_MinCopyVerticesPerThread, 1, std::max(1u, std::thread::hardware_concurrency()));
+    ParallelFor(chunkCount, [&](std::size_t chunk) {
+        const std::size_t firstVertex = vertices.size() * chunk / chunkCount;
+        const std::size_t lastVertex = vertices.size() * (chunk + 1) / chunkCount;
+        import.vertexLayout.PackVertices(vertices.subspan(firstVertex, lastVertex - firstVertex), static_cast<std::byte*>(mapped.vertices) + firstVertex * import.vertexLayout.stride);
+
+        const std::size_t firstIndex = indices.size() * chunk / chunkCount;
+        const std::size_t lastIndex = indices.size() * (chunk + 1) / chunkCount;
+        WriteIndices(indices, import.indexLayout, firstIndex, lastIndex, mapped.indices);
+    });
+    import.mesh = MeshData();
+}
+
+void Renderer::PublishMappedMesh(uint32_t meshID)
+{
+    StreamingState::MappedMesh& mapped = m_Streaming->mappedMeshes[meshID];
+    if (mapped.unmapped) {
+        mapped = StreamingState::MappedMesh();
+        QueueMeshUpload(meshID, m_Streaming->meshImports[meshID], true);
+        return;
+    }
+    if (!mapped.vertices || !mapped.indices)
+        return;
+
+    if (m_InArena[meshID]) {
+        const MeshImport& import = m_Streaming->meshImports[meshID];
+        m_Arena.FlushVertices(m_MeshAllocations[meshID].baseVertex, static_cast<uint32_t>(mapped.vertexBytes / import.vertexLayout.stride));
+        m_Arena.FlushIndices(m_MeshAllocations[meshID].firstIndex, static_cast<uint32_t>(mapped.indexBytes / sizeof(uint16_t)));
+    }
+    else {
+        GL_CALL(glFlushMappedNamedBufferRange, m_VBO[meshID], 0, mapped.vertexBytes);
+        GL_CALL(glFlushMappedNamedBufferRange, m_IBO[meshID], 0, mapped.indexBytes);
+    }
+    mapped.fence = GL_CALL(glFenceSync, GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool Renderer::PollMappedMeshes(bool wait)
+{
+    bool pending = false;
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        StreamingState::MappedMesh& mapped = m_Streaming->mappedMeshes[i];
+        if (!mapped.fence)
+            continue;
+
+        GLenum status;
+        do {
+            status = GL_CALL(glClientWaitSync, mapped.fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? s_FenceWaitTimeout : 0);
+        } while (wait && status == GL_TIMEOUT_EXPIRED);
+
+        if (status == GL_TIMEOUT_EXPIRED) {
+            pending = true;
+            continue;
+        }
+
+        //the flushed writes reached the GPU, the mapping is not needed anymore and the mesh can be drawn:
+        GL_CALL(glDeleteSync, mapped.fence);
+        if (!m_InArena[i]) {
+            GL_CALL(glUnmapNamedBuffer, m_VBO[i]);
+            GL_CALL(glUnmapNamedBuffer, m_IBO[i]);
+        }
+        MeshImport& import = m_Streaming->meshImports[i];
+        m_IndexLayout[i] = std::move(import.indexLayout);
+        m_MeshLods[i] = std::move(import.lods);
+        m_Meshlets[i] = std::move(import.meshlets);
+        m_Tiles[i] = std::move(import.tiles);
+        m_VariantCount[i] = import.variantCount;
+        m_VariantMeshlets[i] = import.variantMeshlets.empty() ? std::vector<uint32_t>{ 0, static_cast<uint32_t>(m_Meshlets[i].size()) } : std::move(import.variantMeshlets);
+        m_IndexCount[i] = static_cast<uint32_t>(mapped.indexBytes / m_IndexLayout[i].GetIndexSize());
+        mapped = StreamingState::MappedMesh();
+
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_Streaming->start;
+        std::cout << import.name << " resident after " << elapsed.count() << " ms" << std::endl;
+    }
+
+    return pending;
+}
+
+void Renderer::FinishStreaming()
+{
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_Streaming->start;
+    std::cout << "all assets resident after " << elapsed.count() << " ms, peak memory " << GetPeakMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+    m_Streaming.reset();
+    m_Arena.Unmap();
+
+    //the full terrain replaces the placeholder for good:
+    if (m_IndexCount[0] > 0)
+        m_PlaceholderIndexCount = 0;
+
+    if (!m_ImpostorReady && m_IndexCount[1] > 0 && m_Settings.impostorDistance > 0.0f)
+        BakePalmImpostor();
+}
+
+void Renderer::BakePalmImpostor()
+{
+    const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    const ImpostorSettings& settings = m_Settings.impostorSettings;
+    const MeshBounds& bounds = m_MeshBounds[1];
+    const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    const float radius = glm::length(bounds.max - bounds.min) * 0.5f;
+    if (radius <= 0.0f)
+        return;
+
+    //every variant gets its own layer, baked from its full level of detail:
+    const uint32_t lodsPerVariant = static_cast<uint32_t>(m_MeshLods[1].size()) / m_VariantCount[1];
+    const uint32_t layerCount = std::min(m_VariantCount[1], s_MaxImpostorLayers);
+    ImpostorAtlas::AllocateTextures(m_ImpostorTextures[0], m_ImpostorTextures[1], settings, layerCount);
+
+    GLuint framebuffer;
+    GL_CALL(glCreateFramebuffers, 1, &framebuffer);
+    GL_CALL(glNamedFramebufferTextureLayer, framebuffer, GL_COLOR_ATTACHMENT0, m_ImpostorTextures[0], 0, 0);
+    GL_CALL(glNamedFramebufferTextureLayer, framebuffer, GL_DEPTH_ATTACHMENT, m_ImpostorTextures[1], 0, 0);
+    const GLenum status = GL_CALL(glCheckNamedFramebufferStatus, framebuffer, GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "palm impostor: incomplete framebuffer (" << status << ")" << std::endl;
+        GL_CALL(glDeleteFramebuffers, 1, &framebuffer);
+        return;
+    }
+
+    //a matrix per frame, each one at an offset the uniform buffer bindings accept:
+    const uint32_t frameCount = settings.framesPerSide * settings.framesPerSide;
+    GLint alignment = 256;
+    GL_CALL(glGetIntegerv, GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    const std::size_t matrixStride = (sizeof(glm::mat4) + alignment - 1) / alignment * alignment;
+    std::vector<std::byte> matrices(frameCount * matrixStride);
+    for (uint32_t j = 0; j < settings.framesPerSide; ++j) {
+        for (uint32_t i = 0; i < settings.framesPerSide; ++i) {
+            //orthographic view of the bounding sphere from outside, its depth range covering the whole sphere:
+            const glm::vec3 direction = DecodeImpostorDirection(glm::vec2(i, j) / static_cast<float>(settings.framesPerSide - 1));
+            glm::vec3 right, up;
+            GetImpostorViewBasis(direction, right, up);
+            const glm::mat4 viewProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius) * glm::lookAt(center + direction * radius, center, up);
+            std::memcpy(matrices.data() + (j * settings.framesPerSide + i) * matrixStride, glm::value_ptr(viewProjection), sizeof(glm::mat4));
+        }
+    }
+    GLuint matrixBuffer;
+    GL_CALL(glCreateBuffers, 1, &matrixBuffer);
+    GL_CALL(glNamedBufferStorage, matrixBuffer, matrices.size(), matrices.data(), 0);
+
+    const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const GLfloat clearDepth = 1.0f;
+
+    GL_CALL(glBindFramebuffer, GL_FRAMEBUFFER, framebuffer);
+    m_ShaderProgram[0].Use();
+    SetInstanceUniforms();
+    SetMeshUniforms(m_VertexLayouts[1], m_MeshColors[1]);
+    GL_CALL(glBindVertexArray, GetVertexArray(1));
+
+    const GLsizei frameSize = static_cast<GLsizei>(settings.frameSize);
+    for (uint32_t layer = 0; layer < layerCount; ++layer) {
+        GL_CALL(glNamedFramebufferTextureLayer, framebuffer, GL_COLOR_ATTACHMENT0, m_ImpostorTextures[0], 0, layer);
+        GL_CALL(glNamedFramebufferTextureLayer, framebuffer, GL_DEPTH_ATTACHMENT, m_ImpostorTextures[1], 0, layer);
+        GL_CALL(glClearNamedFramebufferfv, framebuffer, GL_COLOR, 0, clearColor);
+        GL_CALL(glClearNamedFramebufferfv, framebuffer, GL_DEPTH, 0, &clearDepth);
+        for (uint32_t j = 0; j < settings.framesPerSide; ++j) {
+            for (uint32_t i = 0; i < settings.framesPerSide; ++i) {
+                GL_CALL(glViewport, i * frameSize, j * frameSize, frameSize, frameSize);
+                GL_CALL(glBindBufferRange, GL_UNIFORM_BUFFER, 0, matrixBuffer, (j * settings.framesPerSide + i) * matrixStride, sizeof(glm::mat4));
+                DrawMesh(1, layer * lodsPerVariant);
+            }
+        }
+    }
+
+    GL_CALL(glBindVertexArray, 0);
+    GL_CALL(glBindBufferBase, GL_UNIFORM_BUFFER, 0, 0);
+    GL_CALL(glUseProgram, 0);
+    GL_CALL(glBindFramebuffer, GL_FRAMEBUFFER, 0);
+    GL_CALL(glViewport, 0, 0, m_ViewportWidth, m_ViewportHeight);
+    GL_CALL(glDeleteFramebuffers, 1, &framebuffer);
+    GL_CALL(glDeleteBuffers, 1, &matrixBuffer);
+    GL_CALL(glGenerateTextureMipmap, m_ImpostorTextures[0]);
+
+    m_ImpostorCenter = center;
+    m_ImpostorRadius = radius;
+    m_ImpostorLayerCount = layerCount;
+    m_ImpostorReady = true;
+
+    //read back once so that later starts only upload the atlas:
+    FileStamp stamp;
+    if (GetPalmImpostorStamp(stamp)) {
+        const ImpostorAtlas atlas = ImpostorAtlas::FromTextures(m_ImpostorTextures[0], m_ImpostorTextures[1], settings, layerCount, center, radius);
+        if (!atlas.WriteCache(GetPalmImpostorCachePath(), stamp, HashPalmImpostorSettings()))
+            std::cerr << "palm: couldn't write impostor cache" << std::endl;
+    }
+
+    const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "palm impostor baked in " << elapsed.count() << " ms (" << frameCount << " frames, " << layerCount << " variants)" << std::endl;
+}
+
+std::string Renderer::GetPalmImpostorCachePath() const
+{
+    return GetImpostorCachePath(m_Settings.proceduralPalms ? "palm.generated" : "palm.obj");
+}
+
+bool Renderer::GetPalmImpostorStamp(FileStamp& stamp) const
+{
+    if (m_Settings.proceduralPalms) {
+        stamp = FileStamp();
+        return true;
+    }
+
+    return VirtualFileSystem::GetInstance().GetFileStamp("palm.obj", stamp);
+}
+
+uint64_t Renderer::HashPalmImpostorSettings() const
+{
+    const MeshImportSettings import = PalmImportSettings();
+    uint64_t hash = m_Settings.proceduralPalms ? HashPalmGeneratorSettings(m_Settings.palmSettings) : s_HashSeed;
+
+    HashBytes(hash, &import.color.x, sizeof(float));
+    HashBytes(hash, &import.color.y, sizeof(float));
+    HashBytes(hash, &import.color.z, sizeof(float));
+    HashBytes(hash, &import.lodCount, sizeof(uint32_t));
+    HashBytes(hash, &m_Settings.quantizeMeshes, sizeof(bool));
+    HashBytes(hash, &m_Settings.packVertices, sizeof(bool));
+
+    return hash;
+}
+
+void Renderer::StreamAssets()
+{
+    if (!m_Streaming)
+        return;
+
+    //mesh uploads only queue their copies here, they are spread over the frames by FlushUploads:
+    m_Streaming->pipeline.ProcessMainThreadTasks(false);
+    FlushUploads(m_Settings.uploadBudget);
+    const bool mappedPending = PollMappedMeshes(false);
+
+    if (m_Streaming->uploads.empty() && !mappedPending && m_Streaming->pipeline.IsComplete())
+        FinishStreaming();
+}
+
+void Renderer::SubmitDraw(GLenum indexType, uint32_t firstIndex, uint32_t indexCount, uint32_t baseVertex, uint32_t instanceCount, uint32_t baseInstance)
+{
+    //the non instanced draws read the untransformed instance of their mesh:
+    if (m_RecordDraws) {
+        m_DrawCommands.push_back(DrawElementsIndirectCommand{ indexCount, instanceCount ? instanceCount : 1, firstIndex, static_cast<int32_t>(baseVertex), instanceCount ? baseInstance : m_RecordedInstance });
+        ++m_FrameStats.indirectDraws;
+        return;
+    }
+
+    const void* indices = reinterpret_cast<const void*>(std::size_t(firstIndex) * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)));
+    if (instanceCount) {
+        GL_CALL(glDrawElementsInstancedBaseVertexBaseInstance, GL_TRIANGLES, indexCount, indexType, indices, instanceCount, baseVertex, baseInstance);
+    }
+    else {
+        GL_CALL(glDrawElementsBaseVertex, GL_TRIANGLES, indexCount, indexType, indices, baseVertex);
+    }
+    ++m_FrameStats.drawCalls;
+}
+
+void Renderer::SubmitRecordedDraws()
+{
+    m_RecordDraws = false;
+    if (m_DrawCommands.empty())
+        return;
+
+    //both buffers are respecified every frame, the driver hands out fresh storage while the last frame still reads the previous one:
+    GL_CALL(glNamedBufferData, m_DrawInstanceVBO, m_DrawInstances.size() * sizeof(PackedInstance), m_DrawInstances.data(), GL_STREAM_DRAW);
+    GL_CALL(glNamedBufferData, m_IndirectBuffer, m_DrawCommands.size() * sizeof(DrawElementsIndirectCommand), m_DrawCommands.data(), GL_STREAM_DRAW);
+
+    //every mesh shares the layout of the arena, their colours are in the tints of the instances:
+    SetArenaUniforms(m_PositionOffsets, m_PositionScales);
+    m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, true);
+    GL_CALL(glBindVertexArray, m_ArenaVAO);
+    GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+    GL_CALL(glMultiDrawElementsIndirect, GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(m_DrawCommands.size()), 0);
+    GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, 0);
+    GL_CALL(glBindVertexArray, 0);
+    m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, false);
+    ++m_FrameStats.drawCalls;
+}
+
+uint32_t Renderer::DrawMesh(uint32_t meshID, uint32_t lod)
+{
+    const IndexLayout& layout = m_IndexLayout[meshID];
+    const GLenum indexType = layout.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const GeometryArena::Allocation& allocation = m_MeshAllocations[meshID];
+    uint32_t indexCount = 0;
+
+    //every level of detail is a segment of the index layout:
+    for (uint32_t i = layout.segmentRanges[lod]; i < layout.segmentRanges[lod + 1]; ++i) {
+        const IndexRange& range = layout.ranges[i];
+        SubmitDraw(indexType, allocation.firstIndex + range.firstIndex, range.indexCount, allocation.baseVertex + range.baseVertex);
+        indexCount += range.indexCount;
+    }
+
+    return indexCount / 3;
+}
+
+uint32_t Renderer::DrawIndices(uint32_t meshID, uint32_t lod, uint32_t firstIndex, uint32_t indexCount)
+{
+    const IndexLayout& layout = m_IndexLayout[meshID];
+    const GLenum indexType = layout.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const GeometryArena::Allocation& allocation = m_MeshAllocations[meshID];
+    const uint32_t lastIndex = firstIndex + indexCount;
+    uint32_t drawn = 0;
+
+    //the indices may cross several ranges, each part is drawn with the base vertex of its range:
+    for (uint32_t i = layout.segmentRanges[lod]; i < layout.segmentRanges[lod + 1]; ++i) {
+        const IndexRange& range = layout.ranges[i];
+        const uint32_t first = std::max(firstIndex, range.firstIndex);
+        const uint32_t last = std::min(lastIndex, range.firstIndex + range.indexCount);
+        if (first >= last)
+            continue;
+        SubmitDraw(indexType, allocation.firstIndex + first, last - first, allocation.baseVertex + range.baseVertex);
+        drawn += last - first;
+    }
+
+    return drawn / 3;
+}
+
+uint32_t Renderer::DrawMeshlets(uint32_t meshID, uint32_t variant, const Frustum& frustum, const glm::vec3& offset)
+{
+    const std::vector<uint32_t>& variantMeshlets = m_VariantMeshlets[meshID];
+    const std::span<const Meshlet> meshlets = std::span<const Meshlet>(m_Meshlets[meshID]).subspan(variantMeshlets[variant], variantMeshlets[variant + 1] - variantMeshlets[variant]);
+    m_VisibleMeshlets.clear();
+    CullMeshlets(meshlets, frustum, m_Camera->GetPosition(), offset, m_VisibleMeshlets, m_FrameStats.meshlets);
+
+    return DrawVisibleMeshlets(meshID, meshlets);
+}
+
+uint32_t Renderer::DrawVisibleMeshlets(uint32_t meshID, std::span<const Meshlet> meshlets)
+{
+    //the meshlets follow each other in the indices, every run of visible ones is a single draw:
+    uint32_t triangleCount = 0;
+    for (std::size_t i = 0; i < m_VisibleMeshlets.size();) {
+        const uint32_t firstIndex = meshlets[m_VisibleMeshlets[i]].firstIndex;
+        uint32_t lastIndex = firstIndex + meshlets[m_VisibleMeshlets[i]].indexCount;
+        for (++i; i < m_VisibleMeshlets.size() && meshlets[m_VisibleMeshlets[i]].firstIndex == lastIndex; ++i)
+            lastIndex += meshlets[m_VisibleMeshlets[i]].indexCount;
+        triangleCount += DrawIndices(meshID, 0, firstIndex, lastIndex - firstIndex);
+    }
+
+    return triangleCount;
+}
+
+uint32_t Renderer::DrawTiles(uint32_t meshID, const Frustum& frustum)
+{
+    const std::span<const MeshTile> tiles = m_Tiles[meshID];
+    const std::span<const Meshlet> meshlets = m_Meshlets[meshID];
+    m_VisibleTiles.clear();
+    m_VisibleMeshlets.clear();
+
+    //the tiles out of the view take their meshlets with them, the others go through cluster culling:
+    for (uint32_t i = 0; i < tiles.size(); ++i) {
+        const MeshTile& tile = tiles[i];
+        if (!frustum.IntersectsBox(tile.bounds.min, tile.bounds.max)) {
+            ++m_FrameStats.culledTiles;
+            continue;
+        }
+        m_VisibleTiles.push_back(i);
+        const std::size_t firstVisible = m_VisibleMeshlets.size();
+        CullMeshlets(meshlets.subspan(tile.firstMeshlet, tile.meshletCount), frustum, m_Camera->GetPosition(), glm::vec3(0.0f), m_VisibleMeshlets, m_FrameStats.meshlets);
+        for (std::size_t j = firstVisible; j < m_VisibleMeshlets.size(); ++j)
+            m_VisibleMeshlets[j] += tile.firstMeshlet;
+    }
+    m_FrameStats.testedTiles += tiles.size();
+
+    if (!meshlets.empty())
+        return DrawVisibleMeshlets(meshID, meshlets);
+
+    //neighbouring tiles along a row follow each other in the indices, every run of visible ones is a single draw:
+    uint32_t triangleCount = 0;
+    for (std::size_t i = 0; i < m_VisibleTiles.size();) {
+        const uint32_t firstIndex = tiles[m_VisibleTiles[i]].firstIndex;
+        uint32_t lastIndex = firstIndex + tiles[m_VisibleTiles[i]].indexCount;
+        for (++i; i < m_VisibleTiles.size() && tiles[m_VisibleTiles[i]].firstIndex == lastIndex; ++i)
+            lastIndex += tiles[m_VisibleTiles[i]].indexCount;
+        triangleCount += DrawIndices(meshID, 0, firstIndex, lastIndex - firstIndex);
+    }
+
+    return triangleCount;
+}
+
+uint32_t Renderer::DrawMeshInstanced(uint32_t meshID, uint32_t lod, uint32_t instanceCount, uint32_t baseInstance)
+{
+    const IndexLayout& layout = m_IndexLayout[meshID];
+    const GLenum indexType = layout.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const GeometryArena::Allocation& allocation = m_MeshAllocations[meshID];
+    uint32_t indexCount = 0;
+
+    for (uint32_t i = layout.segmentRanges[lod]; i < layout.segmentRanges[lod + 1]; ++i) {
+        const IndexRange& range = layout.ranges[i];
+        SubmitDraw(indexType, allocation.firstIndex + range.firstIndex, range.indexCount, allocation.baseVertex + range.baseVertex, instanceCount, baseInstance);
+        indexCount += range.indexCount;
+    }
+
+    return indexCount / 3 * instanceCount;
+}
+
+uint32_t Renderer::DrawPalmInstances(const Frustum& frustum)
+{
+    const InstanceStreams& palms = m_TransfoPalm.GetStreams();
+    const uint32_t lodsPerVariant = static_cast<uint32_t>(m_MeshLods[1].size()) / m_VariantCount[1];
+    const uint32_t drawCount = static_cast<uint32_t>(m_MeshLods[1].size());
+    const glm::vec3 center = (m_MeshBounds[1].min + m_MeshBounds[1].max) * 0.5f;
+    const float radius = glm::distance(m_MeshBounds[1].min, m_MeshBounds[1].max) * 0.5f;
+
+    //every level of detail of every variant is a draw, the palms are counted per draw then sorted:
+    m_PalmDrawStarts.assign(drawCount + 1, 0);
+    m_PalmInstanceDraws.resize(palms.GetCount());
+    for (std::size_t i = 0; i < palms.GetCount(); ++i) {
+        m_PalmInstanceDraws[i] = drawCount;
+        if (m_PalmLods[i] == s_ImpostorLod) {
+            m_ImpostorInstances.push_back(PackImpostorInstance(palms, i));
+            continue;
+        }
+        const uint32_t firstLod = GetPalmVariant(i) * lodsPerVariant;
+        m_FrameStats.fullDetailTriangles += m_MeshLods[1][firstLod].indexCount / 3;
+        //the palms are culled as a whole, the instanced draws leave out the meshlets of the full level:
+        const glm::vec3& scale = palms.scales[i];
+        const glm::vec3 instanceCenter = palms.positions[i] + RotateY(center * scale, palms.rotations[i]);
+        if (!frustum.IntersectsSphere(instanceCenter, radius * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) }))) {
+            ++m_FrameStats.culledPalms;
+            continue;
+        }
+        m_PalmInstanceDraws[i] = firstLod + m_PalmLods[i];
+        ++m_PalmDrawStarts[m_PalmInstanceDraws[i] + 1];
+    }
+    std::partial_sum(m_PalmDrawStarts.begin(), m_PalmDrawStarts.end(), m_PalmDrawStarts.begin());
+
+    //the recorded draws take the colour of the mesh from the tints, and its position decoding from the last byte like the others take the first one:
+    const glm::vec3 color = m_RecordDraws ? m_RecordedColor : glm::vec3(1.0f);
+    const uint8_t positionDecode = m_RecordDraws ? m_RecordedPositionDecode : 0;
+    m_PalmInstances.resize(m_PalmDrawStarts.back());
+    std::vector<uint32_t> cursors(m_PalmDrawStarts.begin(), m_PalmDrawStarts.end() - 1);
+    for (std::size_t i = 0; i < palms.GetCount(); ++i) {
+        if (m_PalmInstanceDraws[i] < drawCount)
+            m_PalmInstances[cursors[m_PalmInstanceDraws[i]]++] = PackInstance(palms.positions[i], palms.rotations[i], palms.scales[i], palms.tints[i] * color, positionDecode);
+    }
+    if (m_PalmInstances.empty())
+        return 0;
+
+    //recorded draws read the instances of the frame, the palms being appended after the ones already there:
+    uint32_t baseInstance = 0;
+    if (m_RecordDraws) {
+        baseInstance = static_cast<uint32_t>(m_DrawInstances.size());
+        m_DrawInstances.insert(m_DrawInstances.end(), m_PalmInstances.begin(), m_PalmInstances.end());
+    }
+    else {
+        GL_CALL(glNamedBufferSubData, m_PalmInstanceVBO, 0, m_PalmInstances.size() * sizeof(PackedInstance), m_PalmInstances.data());
+        m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, true);
+    }
+    uint32_t triangleCount = 0;
+    for (uint32_t draw = 0; draw < drawCount; ++draw) {
+        if (m_PalmDrawStarts[draw] < m_PalmDrawStarts[draw + 1])
+            triangleCount += DrawMeshInstanced(1, draw, m_PalmDrawStarts[draw + 1] - m_PalmDrawStarts[draw], baseInstance + m_PalmDrawStarts[draw]);
+    }
+    if (!m_RecordDraws) {
+        m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, false);
+    }
+
+    return triangleCount;
+}
+
+float Renderer::GetPixelsPerUnit() const
+{
+    return m_ViewportHeight / (2.0f * glm::tan(glm::radians(m_Camera->GetFOV()) * 0.5f));
+}
+
+void Renderer::SelectPalmLods()
+{
+    const InstanceStreams& instances = m_TransfoPalm.GetStreams();
+    const uint32_t lodsPerVariant = static_cast<uint32_t>(m_MeshLods[1].size()) / m_VariantCount[1];
+    m_PalmLods.resize(instances.GetCount(), 0);
+
+    const bool useLods = m_Settings.lodThreshold > 0.0f && lodsPerVariant >= 2;
+    const bool useImpostors = m_ImpostorReady && m_Settings.impostorDistance > 0.0f;
+    if (!useLods && !useImpostors) {
+        std::fill(m_PalmLods.begin(), m_PalmLods.end(), 0);
+        return;
+    }
+
+    //an error of e at distance d covers e / d * pixelsPerUnit pixels on screen:
+    const float pixelsPerUnit = GetPixelsPerUnit();
+    const glm::vec3 cameraPosition = m_Camera->GetPosition();
+    const uint32_t lastLod = useLods ? lodsPerVariant - 1 : 0;
+
+    for (std::size_t i = 0; i < instances.GetCount(); ++i) {
+        const MeshLod* lods = m_MeshLods[1].data() + GetPalmVariant(i) * lodsPerVariant;
+        const float distance = std::max(glm::distance(instances.positions[i], cameraPosition), 1e-3f);
+        //the errors are in mesh units, the scale of the instance stretches them by up to its largest factor:
+        const glm::vec3& scale = instances.scales[i];
+        const float errorToPixels = pixelsPerUnit / distance * std::max({ std::abs(scale.x), std::abs(scale.y), std::abs(scale.z) });
+
+        //impostors past the switching distance, an instance only gets its mesh back once well inside it:
+        uint32_t lod = m_PalmLods[i];
+        if (useImpostors) {
+            const float switchDistance = lod == s_ImpostorLod ? m_Settings.impostorDistance * (1.0f - s_LodHysteresis) : m_Settings.impostorDistance;
+            if (distance > switchDistance) {
+                m_PalmLods[i] = s_ImpostorLod;
+                continue;
+            }
+        }
+        if (lod == s_ImpostorLod)
+            lod = lastLod;
+        if (!useLods) {
+            m_PalmLods[i] = 0;
+            continue;
+        }
+
+        //coarser while the next level is well under the threshold, finer while the current one is over it:
+        while (lod < lastLod && lods[lod + 1].error * errorToPixels < m_Settings.lodThreshold * (1.0f - s_LodHysteresis))
+            ++lod;
+        while (lod > 0 && lods[lod].error * errorToPixels > m_Settings.lodThreshold)
+            --lod;
+        m_PalmLods[i] = static_cast<uint8_t>(lod);
+    }
+}
+
+void Renderer::DrawPalmImpostors()
+{
+    const ShaderProgram& program = m_ShaderProgram[2];
+    const bool gpuCulled = m_GpuCulling.HasPalms();
+    if (!gpuCulled) {
+        GL_CALL(glNamedBufferSubData, m_ImpostorInstanceVBO, 0, m_ImpostorInstances.size() * sizeof(PackedInstance), m_ImpostorInstances.data());
+    }
+
+    program.Use();
+    program.Set(m_ImpostorUniforms.cameraPosition, m_Camera->GetPosition());
+    program.Set(m_ImpostorUniforms.impostorCenter, m_ImpostorCenter);
+    program.Set(m_ImpostorUniforms.impostorRadius, m_ImpostorRadius);
+    program.Set(m_ImpostorUniforms.framesPerSide, static_cast<float>(m_Settings.impostorSettings.framesPerSide));
+    GL_CALL(glBindTextureUnit, 0, m_ImpostorTextures[0]);
+    GL_CALL(glBindTextureUnit, 1, m_ImpostorTextures[1]);
+
+    //four vertices per quad, their corner comes from gl_VertexID:
+    GL_CALL(glBindVertexArray, m_ImpostorVAO);
+    if (gpuCulled) {
+        //the culling pass wrote the instance count of the impostors after the commands of the meshes:
+        GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, m_GpuCulling.GetCommandBuffer());
+        GL_CALL(glDrawArraysIndirect, GL_TRIANGLE_STRIP, reinterpret_cast<const void*>(m_GpuCulling.GetImpostorCommandOffset()));
+        GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else {
+        GL_CALL(glDrawArraysInstanced, GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_ImpostorInstances.size()));
+    }
+    GL_CALL(glBindVertexArray, 0);
+    GL_CALL(glBindTextureUnit, 0, 0);
+    GL_CALL(glBindTextureUnit, 1, 0);
+
+    m_FrameStats.impostorCount += m_ImpostorInstances.size();
+    ++m_FrameStats.drawCalls;
+    m_FrameStats.submittedTriangles += 2 * m_ImpostorInstances.size();
+    m_FrameStats.fullDetailTriangles += m_MeshLods[1].empty() ? 0 : m_ImpostorInstances.size() * (m_MeshLods[1][0].indexCount / 3);
+
+    m_ShaderProgram[0].Use();
+}
+
+void Renderer::PrepareGpuCulling()
+{
+    //the variant of every instance travels in its species byte, the commands only reach meshes held by the arena and instanced palms:
+    const bool terrain = m_IndexCount[0] > 0 && m_InArena[0];
+    const bool palms = m_IndexCount[1] > 0 && m_InArena[1] && m_Settings.instancedPalms && m_TransfoPalm.GetCount() > 0 && m_VariantCount[1] <= 256;
+    const uint32_t meshes = (terrain ? 1u : 0u) | (palms ? 2u : 0u);
+    if (meshes == m_GpuCulledMeshes)
+        return;
+    m_GpuCulledMeshes = meshes;
+
+    GpuCullingScene scene;
+    scene.terrainInstance = PackInstance(glm::vec3(0.0f), 0.0f, glm::vec3(1.0f), m_MeshColors[0], s_TerrainPositionDecode);
+    if (terrain) {
+        //the tiles are split along the index ranges of the full level they cross, a terrain without tiles is a single one:
+        const IndexLayout& layout = m_IndexLayout[0];
+        const GeometryArena::Allocation& allocation = m_MeshAllocations[0];
+        auto addTile = [&](uint32_t firstIndex, uint32_t lastIndex, const MeshBounds& bounds) {
+            for (uint32_t i = layout.segmentRanges[0]; i < layout.segmentRanges[1]; ++i) {
+                const IndexRange& range = layout.ranges[i];
+                const uint32_t first = std::max(firstIndex, range.firstIndex);
+                const uint32_t last = std::min(lastIndex, range.firstIndex + range.indexCount);
+                if (first >= last)
+                    continue;
+                scene.tileCommands.push_back(DrawElementsIndirectCommand{ last - first, 0, allocation.firstIndex + first, static_cast<int32_t>(allocation.baseVertex + range.baseVertex), 0 });
+                scene.tileBounds.push_back(bounds);
+            }
+        };
+        for (const MeshTile& tile : m_Tiles[0])
+            addTile(tile.firstIndex, tile.firstIndex + tile.indexCount, tile.bounds);
+        if (m_Tiles[0].empty())
+            addTile(0, std::numeric_limits<uint32_t>::max(), m_MeshBounds[0]);
+    }
+    if (palms) {
+        const InstanceStreams& instances = m_TransfoPalm.GetStreams();
+        scene.instances.resize(instances.GetCount());
+        for (std::size_t i = 0; i < instances.GetCount(); ++i)
+            scene.instances[i] = PackInstance(instances.positions[i], instances.rotations[i], instances.scales[i], instances.tints[i], GetPalmVariant(i));
+
+        //every level of detail of every variant is a draw, made of the commands of its index ranges:
+        const IndexLayout& layout = m_IndexLayout[1];
+        const GeometryArena::Allocation& allocation = m_MeshAllocations[1];
+        for (uint32_t draw = 0; draw < m_MeshLods[1].size(); ++draw) {
+            scene.lodErrors.push_back(m_MeshLods[1][draw].error);
+            for (uint32_t i = layout.segmentRanges[draw]; i < layout.segmentRanges[draw + 1]; ++i) {
+                const IndexRange& range = layout.ranges[i];
+                scene.palmCommands.push_back(DrawElementsIndirectCommand{ range.indexCount, 0, allocation.firstIndex + range.firstIndex, static_cast<int32_t>(allocation.baseVertex + range.baseVertex), 0 });
+                scene.palmCommandDraws.push_back(draw);
+            }
+        }
+        scene.lodsPerVariant = static_cast<uint32_t>(m_MeshLods[1].size()) / m_VariantCount[1];
+        scene.palmCenter = (m_MeshBounds[1].min + m_MeshBounds[1].max) * 0.5f;
+        scene.palmRadius = glm::distance(m_MeshBounds[1].min, m_MeshBounds[1].max) * 0.5f;
+        scene.palmColor = m_MeshColors[1];
+        scene.palmPositionDecode = s_PalmPositionDecode;
+    }
+    else if (m_IndexCount[1] > 0 && m_InArena[1] && m_Settings.instancedPalms && m_TransfoPalm.GetCount() > 0) {
+        std::cerr << "palm: " << m_VariantCount[1] << " variants, more than the GPU culling handles, the palms are culled on the CPU" << std::endl;
+    }
+    m_GpuCulling.SetScene(scene);
+
+    //the buffers of the pass are new, the vertex arrays reading them follow:
+    GL_CALL(glVertexArrayVertexBuffer, m_CulledVAO, 1, m_GpuCulling.GetInstanceBuffer(), 0, sizeof(PackedInstance));
+    if (palms) {
+        GL_CALL(glVertexArrayVertexBuffer, m_ImpostorVAO, 0, m_GpuCulling.GetInstanceBuffer(), 0, sizeof(PackedInstance));
+    }
+}
+
+void Renderer::DrawGpuCulledScene()
+{
+    GpuCullingParameters parameters;
+    parameters.cameraPosition = m_Camera->GetPosition();
+    parameters.pixelsPerUnit = GetPixelsPerUnit();
+    parameters.lodThreshold = m_Settings.lodThreshold;
+    parameters.lodHysteresis = s_LodHysteresis;
+    parameters.impostorDistance = m_ImpostorReady ? m_Settings.impostorDistance : 0.0f;
+    m_GpuCulling.Dispatch(parameters);
+
+    //same state as the recorded draws, with the commands and instances the pass wrote, which select the decoding of the terrain or of the palms:
+    const glm::vec3 positionOffsets[] = { glm::vec3(0.0f), m_VertexLayouts[0].positionOffset, m_VertexLayouts[1].positionOffset };
+    const glm::vec3 positionScales[] = { glm::vec3(1.0f), m_VertexLayouts[0].positionScale, m_VertexLayouts[1].positionScale };
+    static_assert(s_TerrainPositionDecode == 1 && s_PalmPositionDecode == 2);
+    m_ShaderProgram[0].Use();
+    SetArenaUniforms(positionOffsets, positionScales);
+    m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, true);
+    GL_CALL(glBindVertexArray, m_CulledVAO);
+    GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, m_GpuCulling.GetCommandBuffer());
+    GL_CALL(glMultiDrawElementsIndirect, GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(m_GpuCulling.GetDrawCommandCount()), 0);
+    GL_CALL(glBindBuffer, GL_DRAW_INDIRECT_BUFFER, 0);
+    GL_CALL(glBindVertexArray, 0);
+    m_ShaderProgram[0].Set(m_DefaultUniforms.instanced, false);
+    ++m_FrameStats.drawCalls;
+    m_FrameStats.gpuCulledDraws += m_GpuCulling.GetDrawCommandCount();
+}
+
 void Renderer::Render()
 {
     GL_CALL(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    GL_CALL(glUseProgram, m_ShaderProgram[0]);
+    m_ShaderProgram[0].Use();
 
     GL_CALL(glBindBufferBase, GL_UNIFORM_BUFFER, 0, m_UBO);
 
-    glm::vec4 tmp(0, 0, 0, 0);
-    GLint transfoModifLocation = GL_CALL(glGetUniformLocation, m_ShaderProgram[0], "transfoModif");
-    GL_CALL(glUniform3f, transfoModifLocation, 0, 0, 0);
+    SetInstanceUniforms();
 
-    GL_CALL(glBindVertexArray, m_VAO[0]);
-    GL_CALL(glDrawElements, GL_TRIANGLES, m_IndexCount[0], GL_UNSIGNED_INT, nullptr);
-    GL_CALL(glBindVertexArray, 0);
-    for (int i = 0; i < m_TransfoPalm.size(); ++i) {
-        GLint transfoModifLocation = GL_CALL(glGetUniformLocation, m_ShaderProgram[0], "transfoModif");
-        GL_CALL(glUniform3f, transfoModifLocation, m_TransfoPalm[i].x, m_TransfoPalm[i].y, m_TransfoPalm[i].z);
+    m_FrameStats = FrameStats();
+    const Frustum frustum = Frustum::FromMatrix(m_Camera->GetViewProjectionMatrix());
+
+    //the resident terrain and palms are left to the GPU culling, the rest is recorded as usual:
+    if (m_Settings.gpuCulling)
+        PrepareGpuCulling();
+    const bool gpuTerrain = m_GpuCulling.HasTerrain();
+    const bool gpuPalms = m_GpuCulling.HasPalms();
 
-        GL_CALL(glBindVertexArray, m_VAO[1]);
-        GL_CALL(glDrawElements, GL_TRIANGLES, m_IndexCount[1], GL_UNSIGNED_INT, nullptr);
+    //the opaque meshes held by the arena are recorded below then drawn at once, the others are drawn right away:
+    if (m_Settings.multiDraw) {
+        m_DrawCommands.clear();
+        m_DrawInstances.clear();
+        m_PositionOffsets.assign(1, glm::vec3(0.0f));
+        m_PositionScales.assign(1, glm::vec3(1.0f));
+    }
+
+    if (m_IndexCount[0] > 0 && !gpuTerrain) {
+        m_RecordDraws = m_InArena[0];
+        SetMeshUniforms(m_VertexLayouts[0], m_MeshColors[0]);
+        GL_CALL(glBindVertexArray, GetVertexArray(0));
+        if (!m_Tiles[0].empty())
+            m_FrameStats.submittedTriangles += DrawTiles(0, frustum);
+        else
+            m_FrameStats.submittedTriangles += m_Meshlets[0].empty() ? DrawMesh(0) : DrawMeshlets(0, 0, frustum, glm::vec3(0.0f));
+        m_FrameStats.fullDetailTriangles += m_MeshLods[0].empty() ? 0 : m_MeshLods[0][0].indexCount / 3;
+        GL_CALL(glBindVertexArray, 0);
+    }
+    else if (m_PlaceholderIndexCount > 0 && !gpuTerrain) {
+        m_RecordDraws = m_PlaceholderInArena;
+        SetMeshUniforms(m_PlaceholderLayout, m_PlaceholderColor);
+        GL_CALL(glBindVertexArray, m_PlaceholderInArena ? m_ArenaVAO : m_PlaceholderVAO);
+        SubmitDraw(m_PlaceholderInArena ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, m_PlaceholderAllocation.firstIndex, m_PlaceholderIndexCount, m_PlaceholderAllocation.baseVertex);
+        GL_CALL(glBindVertexArray, 0);
+        m_FrameStats.submittedTriangles += m_PlaceholderIndexCount / 3;
+        m_FrameStats.fullDetailTriangles += m_PlaceholderIndexCount / 3;
+    }
+    //palms appear once their mesh is resident, each one at the level of detail its distance allows:
+    const InstanceStreams palms = m_IndexCount[1] > 0 && !gpuPalms ? m_TransfoPalm.GetStreams() : InstanceStreams();
+    if (palms.GetCount() > 0)
+        SelectPalmLods();
+    m_ImpostorInstances.clear();
+    if (palms.GetCount() > 0 && m_Settings.instancedPalms) {
+        m_RecordDraws = m_InArena[1];
+        SetMeshUniforms(m_VertexLayouts[1], m_MeshColors[1]);
+        GL_CALL(glBindVertexArray, GetVertexArray(1));
+        m_FrameStats.submittedTriangles += DrawPalmInstances(frustum);
+        GL_CALL(glBindVertexArray, 0);
+    }
+    if (m_Settings.multiDraw)
+        SubmitRecordedDraws();
+    if (gpuTerrain || gpuPalms)
+        DrawGpuCulledScene();
+    //palms drawn one by one are never recorded, wherever their mesh is:
+    if (palms.GetCount() > 0 && !m_Settings.instancedPalms)
+        SetMeshUniforms(m_VertexLayouts[1], m_MeshColors[1]);
+    const uint32_t lodsPerVariant = static_cast<uint32_t>(m_MeshLods[1].size()) / m_VariantCount[1];
+    for (std::size_t i = 0; i < palms.GetCount() && !m_Settings.instancedPalms; ++i) {
+        if (m_PalmLods[i] == s_ImpostorLod) {
+            m_ImpostorInstances.push_back(PackImpostorInstance(palms, i));
+            continue;
+        }
+        const glm::vec3& position = palms.positions[i];
+        SetInstanceUniforms(position, palms.rotations[i], palms.scales[i], palms.tints[i]);
+
+        GL_CALL(glBindVertexArray, GetVertexArray(1));
+        //only the full level of detail has meshlets, the coarser ones are small enough to be drawn whole,
+        //the meshlet bounds only follow a translation:
+        const uint32_t variant = GetPalmVariant(i);
+        const uint32_t firstLod = variant * lodsPerVariant;
+        const bool translated = palms.rotations[i] == 0.0f && palms.scales[i] == glm::vec3(1.0f);
+        m_FrameStats.submittedTriangles += m_PalmLods[i] == 0 && !m_Meshlets[1].empty() && translated ? DrawMeshlets(1, variant, frustum, position) : DrawMesh(1, firstLod + m_PalmLods[i]);
+        m_FrameStats.fullDetailTriangles += m_MeshLods[1].empty() ? 0 : m_MeshLods[1][firstLod].indexCount / 3;
         GL_CALL(glBindVertexArray, 0);
     }
+    if (!m_ImpostorInstances.empty() || (gpuPalms && m_ImpostorReady && m_Settings.impostorDistance > 0.0f))
+        DrawPalmImpostors();
     GL_CALL(glBindBufferBase, GL_UNIFORM_BUFFER, 0, 0);
 
     GL_CALL(glUseProgram, 0);
 
     GL_CALL(glDepthFunc, GL_LEQUAL);
-    GL_CALL(glUseProgram, m_ShaderProgram[1]);
+    m_ShaderProgram[1].Use();
     
     m_SkyboxInfo.view = glm::mat4(1.0f);
     m_SkyboxInfo.projection = glm::mat4(1.0f);
     m_SkyboxInfo.view = glm::mat4(glm::mat3(glm::lookAt(m_Camera->GetPosition(), m_Camera->GetPosition() - m_Camera->GetDirection(), m_Camera->GetUp())));
     m_SkyboxInfo.projection = glm::perspective(glm::radians(45.0f), (float)m_ViewportWidth / m_ViewportHeight, 0.1f, 100.0f);
-    GLint viewLocation = GL_CALL(glGetUniformLocation, m_ShaderProgram[1], "view");
-    GLint projectionLocation = GL_CALL(glGetUniformLocation, m_ShaderProgram[1], "projection");
-    GL_CALL(glUniformMatrix4fv, viewLocation, 1, GL_FALSE, glm::value_ptr(m_SkyboxInfo.view));
-    GL_CALL(glUniformMatrix4fv, projectionLocation, 1, GL_FALSE, glm::value_ptr(m_SkyboxInfo.projection));
+    m_ShaderProgram[1].Set(m_SkyboxUniforms.view, m_SkyboxInfo.view);
+    m_ShaderProgram[1].Set(m_SkyboxUniforms.projection, m_SkyboxInfo.projection);
 
-    GL_CALL(glBindVertexArray, m_VAO[2]);
+    GL_CALL(glBindVertexArray, GetVertexArray(2));
     GL_CALL(glActiveTexture, GL_TEXTURE0);
     GL_CALL(glBindTexture, GL_TEXTURE_CUBE_MAP, m_Texture);
-    GL_CALL(glDrawElements, GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+    if (m_InArena[2]) {
+        GL_CALL(glDrawElementsBaseVertex, GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(m_SkyboxAllocation.firstIndex * sizeof(uint16_t)), m_SkyboxAllocation.baseVertex);
+    }
+    else {
+        GL_CALL(glDrawElements, GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+    }
     GL_CALL(glBindVertexArray, 0);
     GL_CALL(glUseProgram, 0);
     GL_CALL(glDepthFunc, GL_LESS);
@@ -524,6 +2034,8 @@ void Renderer::Render()
 
 void Renderer::Cleanup()
 {
+    m_Streaming.reset();
+
     m_UBOData = nullptr;
 
     GL_CALL(glUnmapNamedBuffer, m_UBO);
@@ -534,8 +2046,24 @@ void Renderer::Cleanup()
 
     GL_CALL(glDeleteVertexArrays, 3, m_VAO);
 
-    GL_CALL(glDeleteProgram, m_ShaderProgram[0]);
-    GL_CALL(glDeleteProgram, m_ShaderProgram[1]);
+    GL_CALL(glDeleteBuffers, 1, &m_PlaceholderVBO);
+    GL_CALL(glDeleteBuffers, 1, &m_PlaceholderIBO);
+    GL_CALL(glDeleteVertexArrays, 1, &m_PlaceholderVAO);
+
+    m_Arena.Destroy();
+    GL_CALL(glDeleteVertexArrays, 1, &m_ArenaVAO);
+    GL_CALL(glDeleteBuffers, 1, &m_DrawInstanceVBO);
+    GL_CALL(glDeleteBuffers, 1, &m_IndirectBuffer);
+    m_GpuCulling.Destroy();
+    GL_CALL(glDeleteVertexArrays, 1, &m_CulledVAO);
+
+    for (ShaderProgram& program : m_ShaderProgram)
+        program.Destroy();
+
+    GL_CALL(glDeleteTextures, 2, m_ImpostorTextures);
+    GL_CALL(glDeleteBuffers, 1, &m_ImpostorInstanceVBO);
+    GL_CALL(glDeleteBuffers, 1, &m_PalmInstanceVBO);
+    GL_CALL(glDeleteVertexArrays, 1, &m_ImpostorVAO);
 
     GL_CALL(glDeleteTextures, 1, &m_Texture);
 }
@@ -0,0 +1,198 @@
+#include <GL/glew.h>
+
+#pragma warning(push, 0)
+#include <glm/gtc/type_ptr.hpp>
+#pragma warning(pop, 0)
+
+#include <shaderprogram.hpp>
+#include <glutils.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    // Samplers are set as texture units
+    bool IsSamplerType(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_SHADOW:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Name, binding or location and type of every active resource of an interface, the members of blocks left out
+    template<typename Resource>
+    std::vector<Resource> ReflectResources(GLuint program, GLenum programInterface)
+    {
+        GLint count = 0;
+        GL_CALL(glGetProgramInterfaceiv, program, programInterface, GL_ACTIVE_RESOURCES, &count);
+
+        const bool uniforms = programInterface == GL_UNIFORM;
+        const GLenum uniformProperties[] = { GL_NAME_LENGTH, GL_LOCATION, GL_TYPE, GL_BLOCK_INDEX };
+        const GLenum blockProperties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING };
+        const GLenum* properties = uniforms ? uniformProperties : blockProperties;
+        const GLsizei propertyCount = uniforms ? 4 : 2;
+
+        std::vector<Resource> resources;
+        resources.reserve(count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLint values[4] = { 0, -1, 0, -1 };
+            GL_CALL(glGetProgramResourceiv, program, programInterface, i, propertyCount, properties, propertyCount, nullptr, values);
+            if (uniforms && values[3] != -1)
+            {
+                continue;
+            }
+
+            Resource resource;
+            resource.name.resize(values[0]);
+            GL_CALL(glGetProgramResourceName, program, programInterface, i, values[0], nullptr, resource.name.data());
+            //the length counts the terminating null, arrays are reported as their first element:
+            resource.name.resize(std::strlen(resource.name.c_str()));
+            if (resource.name.ends_with("[0]"))
+            {
+                resource.name.resize(resource.name.size() - 3);
+            }
+            resource.index = values[1];
+            resource.type = uniforms ? static_cast<GLenum>(values[2]) : 0;
+            resources.push_back(std::move(resource));
+        }
+
+        return resources;
+    }
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    Destroy();
+}
+
+bool ShaderProgram::Create(GLuint program)
+{
+    Destroy();
+
+    m_Program = program;
+
+    GLint linked = GL_FALSE;
+    GL_CALL(glGetProgramiv, program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE)
+    {
+        return false;
+    }
+
+    m_Uniforms = ReflectResources<Resource>(program, GL_UNIFORM);
+    m_UniformBlocks = ReflectResources<Resource>(program, GL_UNIFORM_BLOCK);
+    m_StorageBlocks = ReflectResources<Resource>(program, GL_SHADER_STORAGE_BLOCK);
+
+    return true;
+}
+
+void ShaderProgram::Destroy()
+{
+    if (m_Program)
+    {
+        GL_CALL(glDeleteProgram, m_Program);
+        m_Program = 0;
+    }
+
+    m_Uniforms.clear();
+    m_UniformBlocks.clear();
+    m_StorageBlocks.clear();
+}
+
+void ShaderProgram::Use() const
+{
+    GL_CALL(glUseProgram, m_Program);
+}
+
+GLint ShaderProgram::FindUniform(std::string_view name, GLenum type) const
+{
+    for (const Resource& uniform : m_Uniforms)
+    {
+        if (uniform.name != name)
+        {
+            continue;
+        }
+        if (uniform.type != type && !(type == GL_INT && IsSamplerType(uniform.type)))
+        {
+            std::cerr << "shader program " << m_Program << ": uniform " << name << " is not of the type it is set with" << std::endl;
+            return -1;
+        }
+        return uniform.index;
+    }
+
+    //uniforms the compiler optimized out are not an error, they are simply never set:
+    return -1;
+}
+
+GLint ShaderProgram::FindBlock(const std::vector<Resource>& blocks, std::string_view name)
+{
+    for (const Resource& block : blocks)
+    {
+        if (block.name == name)
+        {
+            return block.index;
+        }
+    }
+
+    return -1;
+}
+
+GLint ShaderProgram::GetUniformBlockBinding(std::string_view name) const
+{
+    return FindBlock(m_UniformBlocks, name);
+}
+
+GLint ShaderProgram::GetStorageBlockBinding(std::string_view name) const
+{
+    return FindBlock(m_StorageBlocks, name);
+}
+
+void ShaderProgram::Set(Uniform<bool> uniform, bool value) const
+{
+    GL_CALL(glProgramUniform1i, m_Program, uniform.location, value ? 1 : 0);
+}
+
+void ShaderProgram::Set(Uniform<int32_t> uniform, int32_t value) const
+{
+    GL_CALL(glProgramUniform1i, m_Program, uniform.location, value);
+}
+
+void ShaderProgram::Set(Uniform<uint32_t> uniform, uint32_t value) const
+{
+    GL_CALL(glProgramUniform1ui, m_Program, uniform.location, value);
+}
+
+void ShaderProgram::Set(Uniform<float> uniform, float value) const
+{
+    GL_CALL(glProgramUniform1f, m_Program, uniform.location, value);
+}
+
+void ShaderProgram::Set(Uniform<glm::vec3> uniform, const glm::vec3& value) const
+{
+    GL_CALL(glProgramUniform3fv, m_Program, uniform.location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::Set(Uniform<glm::vec3> uniform, std::span<const glm::vec3> values) const
+{
+    GL_CALL(glProgramUniform3fv, m_Program, uniform.location, static_cast<GLsizei>(values.size()), reinterpret_cast<const GLfloat*>(values.data()));
+}
+
+void ShaderProgram::Set(Uniform<glm::vec4> uniform, const glm::vec4& value) const
+{
+    GL_CALL(glProgramUniform4fv, m_Program, uniform.location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::Set(Uniform<glm::mat4> uniform, const glm::mat4& value) const
+{
+    GL_CALL(glProgramUniformMatrix4fv, m_Program, uniform.location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,86 @@
+#include <threadpool.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    thread_local ThreadPool* s_CurrentPool = nullptr;
+}
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_Threads.reserve(threadCount);
+
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+
+    m_Condition.notify_all();
+
+    for (std::thread& thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+
+    m_Condition.notify_one();
+}
+
+ThreadPool* ThreadPool::GetCurrent()
+{
+    return s_CurrentPool;
+}
+
+ThreadPool& ThreadPool::GetShared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    s_CurrentPool = this;
+
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
+END_VISUALIZER_NAMESPACE
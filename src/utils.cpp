@@ -7,25 +7,96 @@
 
 
 #include <utils.hpp>
+#include <virtualfilesystem.hpp>
+#include <instancefile.hpp>
 #include <Windows.h>
+#include <Psapi.h>
 #include <fstream>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
 
 BEGIN_VISUALIZER_NAMESPACE
 
-bool LoadFile(const std::string& fileName, std::string& result)
+namespace
 {
-    std::ifstream ifs(fileName, std::ios::binary);
+    inline const char* SkipWhitespaces(const char* p, const char* end)
+    {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p)))
+        {
+            ++p;
+        }
+        return p;
+    }
 
-    if (ifs)
+    template<typename T>
+    inline bool ParseNumber(const char*& p, const char* end, T& value)
     {
-        result = std::move(std::string(std::istreambuf_iterator<char>(ifs), {}));
+        p = SkipWhitespaces(p, end);
 
-        if (!ifs)
+        const std::from_chars_result result = std::from_chars(p, end, value);
+
+        if (result.ec != std::errc())
         {
-            std::cerr << "Error: only " << ifs.gcount() << " could be read\n";
+            return false;
         }
+
+        p = result.ptr;
+        return true;
+    }
+
+    // Skips the blanks up to the next character, false if that one starts a new line
+    inline bool HasMoreOnLine(const char*& p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        {
+            ++p;
+        }
+        return p < end && *p != '\n';
+    }
+
+    // Lets the stream based parsers read a mapped asset in place
+    class ViewStreamBuffer : public std::streambuf
+    {
+    public:
+        explicit ViewStreamBuffer(std::string_view view)
+        {
+            char* begin = const_cast<char*>(view.data());
+            setg(begin, begin, begin + view.size());
+        }
+    };
+}
+
+bool GetFileStamp(const std::string& fileName, FileStamp& stamp)
+{
+    std::error_code error;
+
+    stamp.size = std::filesystem::file_size(fileName, error);
+
+    if (error)
+    {
+        return false;
+    }
+
+    stamp.writeTime = std::filesystem::last_write_time(fileName, error).time_since_epoch().count();
+
+    return !error;
+}
+
+void HashBytes(uint64_t& hash, const void* data, std::size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
     }
-    else
+}
+
+bool LoadFile(const std::string& fileName, AssetFile& result)
+{
+    if (!VirtualFileSystem::GetInstance().Open(fileName, result))
     {
         std::cerr << "Cannot open file : " << fileName << '\n';
         return false;
@@ -63,35 +134,89 @@ void DisplayLastWinAPIError()
     }
 }
 
-tinyobj::ObjReader LoadObjFile(std::string inputFile, tinyobj::ObjReaderConfig readerConfig)
+std::size_t GetPeakMemoryUsage()
 {
-    tinyobj::ObjReader reader;
-    if (!reader.ParseFromFile(inputFile, readerConfig)) {
-        std::cerr << "LoadObjFile: read error" << reader.Error();
-        if (!reader.Error().empty()) {
-            std::cerr << "TinyObjReader: " << reader.Error();
+    PROCESS_MEMORY_COUNTERS counters = {};
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        DisplayLastWinAPIError();
+        return 0;
+    }
+
+    return counters.PeakWorkingSetSize;
+}
+
+TinyObjMesh LoadObjFile(std::string inputFile, tinyobj::ObjReaderConfig readerConfig)
+{
+    TinyObjMesh mesh;
+    AssetFile file;
+    if (!LoadFile(inputFile, file))
+        return mesh;
+    //the mapped file is parsed in place, the materials from an empty stream:
+    ViewStreamBuffer buffer(file.GetView());
+    std::istream stream(&buffer);
+    std::stringbuf materialBuffer;
+    std::istream materialStream(&materialBuffer);
+    tinyobj::MaterialStreamReader materialReader(materialStream);
+    std::string warning, error;
+    mesh.valid = tinyobj::LoadObj(&mesh.attrib, &mesh.shapes, &mesh.materials, &warning, &error, &stream, &materialReader, readerConfig.triangulate, readerConfig.vertex_color);
+    if (!mesh.valid) {
+        std::cerr << "LoadObjFile: read error" << error;
+        if (!error.empty()) {
+            std::cerr << "TinyObjReader: " << error;
         }
     }
-    if (!reader.Warning().empty()) {
-        std::cout << "TinyObjReader: " << reader.Warning();
+    if (!warning.empty()) {
+        std::cout << "TinyObjReader: " << warning;
     }
-    return reader;
+    return mesh;
 }
 
-std::vector<glm::vec4> LoadTransfoFile(std::string inputFile)
+InstanceArrays LoadTransfoFile(std::string inputFile)
 {
-    std::vector<glm::vec4> ret;
-    std::fstream file(inputFile);
-    int lineCount;
-    file >> lineCount;
-    float x, y, z, w;
-    for (int i = 0; i < lineCount && (file >> x >> y >> z >> w); ++i)
-        ret.push_back(glm::vec4{
-            x,
-            y,
-            z,
-            w
-        });
+    InstanceArrays ret;
+    AssetFile file;
+    if (!LoadFile(inputFile, file))
+        return ret;
+    const char* p = reinterpret_cast<const char*>(file.GetData());
+    const char* end = p + file.GetSize();
+    int lineCount = 0;
+    if (!ParseNumber(p, end, lineCount) || lineCount < 0)
+    {
+        std::cerr << "LoadTransfoFile: invalid line count in " << inputFile << '\n';
+        return ret;
+    }
+    ret.Resize(lineCount);
+    int i = 0;
+    for (; i < lineCount; ++i)
+    {
+        glm::vec3& position = ret.positions[i];
+        float scale = 1.0f;
+        if (!ParseNumber(p, end, position.x) || !ParseNumber(p, end, position.y) || !ParseNumber(p, end, position.z) || !ParseNumber(p, end, scale))
+            break;
+        ret.rotations[i] = 0.0f;
+        ret.scales[i] = glm::vec3(scale);
+        ret.tints[i] = glm::vec3(1.0f);
+        if (!HasMoreOnLine(p, end))
+        {
+            //spread the variants over legacy rows the same way on every load, whatever the order of the rows:
+            uint64_t hash = s_HashSeed;
+            HashBytes(hash, &position, sizeof(glm::vec3));
+            ret.species[i] = static_cast<uint32_t>(hash);
+            continue;
+        }
+        glm::vec3 axisScale;
+        glm::vec3& tint = ret.tints[i];
+        if (!ParseNumber(p, end, ret.rotations[i]) || !ParseNumber(p, end, axisScale.x) || !ParseNumber(p, end, axisScale.y) || !ParseNumber(p, end, axisScale.z) ||
+            !ParseNumber(p, end, tint.r) || !ParseNumber(p, end, tint.g) || !ParseNumber(p, end, tint.b) || !ParseNumber(p, end, ret.species[i]))
+        {
+            std::cerr << "LoadTransfoFile: invalid instance " << i << " in " << inputFile << '\n';
+            break;
+        }
+        ret.scales[i] *= axisScale;
+    }
+    ret.Resize(i);
     return ret;
 }
 
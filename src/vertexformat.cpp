@@ -0,0 +1,137 @@
+#include <vertexformat.hpp>
+#include <meshcodec.hpp>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+namespace
+{
+    constexpr float s_PositionScale = 65535.0f;
+    constexpr float s_NormalScale = 511.0f;
+
+    inline bool HasVolume(const MeshBounds& bounds)
+    {
+        return bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z;
+    }
+
+    inline uint32_t PackSnorm10(float value)
+    {
+        return static_cast<uint32_t>(static_cast<int32_t>(std::round(std::clamp(value, -1.0f, 1.0f) * s_NormalScale))) & 0x3FF;
+    }
+
+    // x and y hold the octahedral coordinates, w tells whether there is a normal at all
+    inline uint32_t PackOctahedralNormal(const glm::vec3& normal)
+    {
+        const float length = glm::length(normal);
+
+        if (length <= 0.0f)
+        {
+            return 0;
+        }
+
+        const glm::vec2 octahedral = EncodeOctahedral(normal / length);
+        return PackSnorm10(octahedral.x) | (PackSnorm10(octahedral.y) << 10) | (1u << 30);
+    }
+}
+
+VertexLayout VertexLayout::Create(const VertexFormat& format, const MeshBounds& bounds)
+{
+    VertexLayout layout;
+    layout.format = format;
+
+    if (format.position == VertexPositionFormat::Unorm16 && HasVolume(bounds))
+    {
+        layout.attributes.push_back(VertexAttribute{ s_PositionAttribute, 3, VertexAttributeType::UnsignedShort, true, layout.stride });
+        // Padded to keep the next attribute 4 byte aligned
+        layout.stride += 4 * sizeof(uint16_t);
+        layout.positionOffset = bounds.min;
+        layout.positionScale = bounds.max - bounds.min;
+    }
+    else
+    {
+        layout.format.position = VertexPositionFormat::Float3;
+        layout.attributes.push_back(VertexAttribute{ s_PositionAttribute, 3, VertexAttributeType::Float, false, layout.stride });
+        layout.stride += 3 * sizeof(float);
+    }
+
+    if (format.normal == VertexNormalFormat::Octahedral10)
+    {
+        layout.attributes.push_back(VertexAttribute{ s_NormalAttribute, 4, VertexAttributeType::Int2_10_10_10, true, layout.stride });
+        layout.stride += sizeof(uint32_t);
+    }
+    else
+    {
+        layout.attributes.push_back(VertexAttribute{ s_NormalAttribute, 3, VertexAttributeType::Float, false, layout.stride });
+        layout.stride += 3 * sizeof(float);
+    }
+
+    return layout;
+}
+
+void VertexLayout::PackVertices(std::span<const VertexDataPosition3fNormal3fColor3f> vertices, void* destination) const
+{
+    uint8_t* output = static_cast<uint8_t*>(destination);
+    const glm::vec3 inverseScale = glm::vec3(
+        positionScale.x > 0.0f ? s_PositionScale / positionScale.x : 0.0f,
+        positionScale.y > 0.0f ? s_PositionScale / positionScale.y : 0.0f,
+        positionScale.z > 0.0f ? s_PositionScale / positionScale.z : 0.0f);
+
+    for (const VertexDataPosition3fNormal3fColor3f& vertex : vertices)
+    {
+        uint8_t* normal = output;
+
+        if (format.position == VertexPositionFormat::Unorm16)
+        {
+            const glm::vec3 quantized = glm::clamp(glm::round((vertex.position - positionOffset) * inverseScale), glm::vec3(0.0f), glm::vec3(s_PositionScale));
+            const uint16_t position[4] = { static_cast<uint16_t>(quantized.x), static_cast<uint16_t>(quantized.y), static_cast<uint16_t>(quantized.z), 0 };
+            std::memcpy(output, position, sizeof(position));
+            normal += sizeof(position);
+        }
+        else
+        {
+            std::memcpy(output, &vertex.position, sizeof(glm::vec3));
+            normal += sizeof(glm::vec3);
+        }
+
+        if (format.normal == VertexNormalFormat::Octahedral10)
+        {
+            const uint32_t packed = PackOctahedralNormal(vertex.normal);
+            std::memcpy(normal, &packed, sizeof(uint32_t));
+        }
+        else
+        {
+            std::memcpy(normal, &vertex.normal, sizeof(glm::vec3));
+        }
+
+        output += stride;
+    }
+}
+
+VertexFormat ChooseVertexFormat(const MeshBounds& bounds, bool pack, float maxPositionError)
+{
+    VertexFormat format;
+
+    if (!pack)
+    {
+        return format;
+    }
+
+    //rounding to the closest of the 65536 steps along the largest axis is off by half a step at most:
+    const glm::vec3 extent = HasVolume(bounds) ? bounds.max - bounds.min : glm::vec3(std::numeric_limits<float>::max());
+    const float error = std::max({ extent.x, extent.y, extent.z }) / s_PositionScale * 0.5f;
+
+    format.position = error <= maxPositionError ? VertexPositionFormat::Unorm16 : VertexPositionFormat::Float3;
+    format.normal = VertexNormalFormat::Octahedral10;
+
+    return format;
+}
+
+VertexFormat GetSharedVertexFormat(bool pack)
+{
+    VertexFormat format;
+    format.position = pack ? VertexPositionFormat::Unorm16 : VertexPositionFormat::Float3;
+    format.normal = pack ? VertexNormalFormat::Octahedral10 : VertexNormalFormat::Float3;
+
+    return format;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -0,0 +1,90 @@
+#include <virtualfilesystem.hpp>
+#include <utility>
+
+BEGIN_VISUALIZER_NAMESPACE
+
+AssetFile::AssetFile(AssetFile&& other) noexcept
+    : m_Mapping(std::move(other.m_Mapping))
+    , m_Data(std::exchange(other.m_Data, std::span<const uint8_t>()))
+{}
+
+AssetFile& AssetFile::operator=(AssetFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        m_Mapping = std::move(other.m_Mapping);
+        m_Data = std::exchange(other.m_Data, std::span<const uint8_t>());
+    }
+
+    return *this;
+}
+
+void AssetFile::Close()
+{
+    m_Mapping.Close();
+    m_Data = std::span<const uint8_t>();
+}
+
+bool VirtualFileSystem::MountPack(const std::string& packFile)
+{
+    if (!m_Pack.Open(packFile))
+    {
+        return false;
+    }
+
+    std::cout << "Asset pack mounted: " << packFile << " (" << m_Pack.GetEntryCount() << " files)\n";
+
+    return true;
+}
+
+void VirtualFileSystem::SetResourceDirectory(const std::string& resourceDirectory)
+{
+    m_ResourceDirectory = resourceDirectory;
+
+    if (!m_ResourceDirectory.empty() && m_ResourceDirectory.back() != '/' && m_ResourceDirectory.back() != '\\')
+    {
+        m_ResourceDirectory += '/';
+    }
+}
+
+bool VirtualFileSystem::Open(const std::string& path, AssetFile& file) const
+{
+    file.Close();
+
+    FileStamp stamp;
+
+    if (m_Pack.Find(path, file.m_Data, stamp))
+    {
+        return file.IsOpen();
+    }
+
+    return OpenLoose(path, file);
+}
+
+bool VirtualFileSystem::OpenLoose(const std::string& path, AssetFile& file) const
+{
+    file.Close();
+
+    if (!file.m_Mapping.Open(GetLoosePath(path)))
+    {
+        return false;
+    }
+
+    file.m_Data = std::span<const uint8_t>(file.m_Mapping.GetData(), file.m_Mapping.GetSize());
+
+    return true;
+}
+
+bool VirtualFileSystem::GetFileStamp(const std::string& path, FileStamp& stamp) const
+{
+    std::span<const uint8_t> data;
+
+    return m_Pack.Find(path, data, stamp) || visualizer::GetFileStamp(GetLoosePath(path), stamp);
+}
+
+std::string VirtualFileSystem::GetLoosePath(const std::string& path) const
+{
+    return m_ResourceDirectory + path;
+}
+
+END_VISUALIZER_NAMESPACE
@@ -528,6 +528,8 @@ void Window::Run()
         return;
     }
 
+    const std::chrono::time_point<std::chrono::steady_clock> runStart = std::chrono::steady_clock::now();
+
     ShowWindow(m_hWnd, SW_SHOW);
 
     glEnable(GL_CULL_FACE);
@@ -538,7 +540,26 @@ void Window::Run()
 
     m_Camera = std::make_shared<Camera>(m_Width, m_Height, glm::vec3(0., 0., 2.5f));
 
-    m_Renderer = std::make_unique<Renderer>(m_Width, m_Height, m_Camera);
+    RendererSettings rendererSettings;
+    rendererSettings.skyboxCache = (*m_CommandLineOptions)["skybox-cache"].as<bool>();
+    rendererSettings.quantizeMeshes = (*m_CommandLineOptions)["quantize-meshes"].as<bool>();
+    rendererSettings.optimizeMeshes = (*m_CommandLineOptions)["optimize-meshes"].as<bool>();
+    rendererSettings.progressiveLoading = (*m_CommandLineOptions)["progressive-loading"].as<bool>();
+    rendererSettings.uploadBudget = (*m_CommandLineOptions)["upload-budget"].as<uint64_t>();
+    rendererSettings.directUpload = (*m_CommandLineOptions)["direct-upload"].as<bool>();
+    rendererSettings.prefetchAssets = (*m_CommandLineOptions)["prefetch-assets"].as<bool>();
+    rendererSettings.lodThreshold = (*m_CommandLineOptions)["lod-threshold"].as<float>();
+    rendererSettings.clusterCulling = (*m_CommandLineOptions)["cluster-culling"].as<bool>();
+    rendererSettings.terrainTiles = (*m_CommandLineOptions)["terrain-tiles"].as<uint32_t>();
+    rendererSettings.packVertices = (*m_CommandLineOptions)["pack-vertices"].as<bool>();
+    rendererSettings.impostorDistance = (*m_CommandLineOptions)["impostor-distance"].as<float>();
+    rendererSettings.proceduralPalms = (*m_CommandLineOptions)["procedural-palms"].as<bool>();
+    rendererSettings.palmSettings.variantCount = (*m_CommandLineOptions)["palm-variants"].as<uint32_t>();
+    rendererSettings.instancedPalms = (*m_CommandLineOptions)["instanced-palms"].as<bool>();
+    rendererSettings.multiDraw = (*m_CommandLineOptions)["multi-draw"].as<bool>();
+    rendererSettings.gpuCulling = (*m_CommandLineOptions)["gpu-culling"].as<bool>();
+
+    m_Renderer = std::make_unique<Renderer>(m_Width, m_Height, m_Camera, rendererSettings);
 
     if (!m_Renderer->Initialize())
     {
@@ -549,8 +570,10 @@ void Window::Run()
     std::chrono::duration<float> dt;
     std::chrono::duration<float> totalElapsedTime;
 
-    std::chrono::time_point<std::chrono::steady_clock> start, lastFrame;
-    start = lastFrame = std::chrono::steady_clock::now();
+    std::chrono::time_point<std::chrono::steady_clock> start, lastFrame, lastStatsReport;
+    start = lastFrame = lastStatsReport = std::chrono::steady_clock::now();
+
+    bool firstFrame = true;
 
     while (Update())
     {
@@ -560,9 +583,27 @@ void Window::Run()
         lastFrame = end;
         HandleCameraMovement(dt.count());
 
+        m_Renderer->StreamAssets();
         m_Renderer->Render();
 
         SwapBuffers(m_hDC);
+
+        if (firstFrame)
+        {
+            const std::chrono::duration<float, std::milli> timeToFirstFrame = std::chrono::steady_clock::now() - runStart;
+            std::cout << "Time to first frame: " << timeToFirstFrame.count() << " ms\n";
+            firstFrame = false;
+        }
+
+        if (end - lastStatsReport >= std::chrono::seconds(5))
+        {
+            const FrameStats& stats = m_Renderer->GetFrameStats();
+            std::cout << "Triangles per frame: " << stats.submittedTriangles << " (" << stats.fullDetailTriangles << " at full detail) in " << stats.drawCalls << " draws (" << stats.indirectDraws << " indirect, " << stats.gpuCulledDraws << " GPU culled), "
+                      << stats.impostorCount << " impostors, " << stats.culledPalms << " palms culled, " << stats.meshlets.GetRejected() << " of " << stats.meshlets.tested << " meshlets culled ("
+                      << stats.meshlets.outsideFrustum << " outside the frustum, " << stats.meshlets.backfacing << " backfacing), "
+                      << stats.culledTiles << " of " << stats.testedTiles << " terrain tiles culled\n";
+            lastStatsReport = end;
+        }
     }
 
     m_Renderer->Cleanup();